@@ -66,10 +66,23 @@ namespace Walnut {
 		return *s_Instance;
 	}
 
+	static void *ImGui_MemAlloc( size_t size, void * ) {
+		return GetMemory( size, TAG_UI );
+	}
+
+	static void ImGui_MemFree( void *ptr, void * ) {
+		FreeMemory( ptr, TAG_UI );
+	}
+
 	void Application::Init( void )
 	{
     	Log_Printf( "[Application::Init] Setting up GUI\n" );
 
+		Hunk_Init();
+		Frame_Init( 32 * 1024 * 1024 );
+		Job_Init( g_pPrefsDlg->m_nJobThreads );
+		Watch_Init();
+
 	    m_WindowHandle = SDL_CreateWindow( m_Specification.Name.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, m_Specification.Width, m_Specification.Height,
 	        SDL_WINDOW_OPENGL | SDL_WINDOW_MOUSE_CAPTURE );
 	    if ( !m_WindowHandle ) {
@@ -95,6 +108,7 @@ namespace Walnut {
 
 		// Setup Dear ImGui context
 		IMGUI_CHECKVERSION();
+		ImGui::SetAllocatorFunctions( ImGui_MemAlloc, ImGui_MemFree, NULL );
 		ImGui::CreateContext();
 		ImGuiIO& io = ImGui::GetIO(); (void)io;
 		io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;       // Enable Keyboard Controls
@@ -151,6 +165,9 @@ namespace Walnut {
 		}
 		s_ResourceFreeQueue.clear();
 
+		Thumb_Shutdown();
+		Tex_Shutdown();
+
 		ImGui_ImplOpenGL3_Shutdown();
 		ImGui_ImplSDL2_Shutdown();
 		ImGui::DestroyContext();
@@ -160,6 +177,12 @@ namespace Walnut {
 		SDL_DestroyWindow( m_WindowHandle );
 
 		SDL_Quit();
+
+		Asset_Shutdown();
+		Watch_Shutdown();
+		Job_Shutdown();
+		Frame_Shutdown();
+		Hunk_Shutdown();
 	}
 
 	void Application::Run( void )
@@ -169,6 +192,13 @@ namespace Walnut {
 
 		// Main loop
 		while ( m_Running ) {
+			// everything handed out by Frame_Alloc last frame is dead now
+			Frame_Reset();
+			Mem_SampleTags();
+			Job_RunMainThreadTasks();
+			Watch_Poll();
+			Tex_UploadFrame();
+
 			glClear( GL_COLOR_BUFFER_BIT );
 			glClearColor( 0.1f, 0.1f, 0.1f, 1.0f );
 			glViewport( 0, 0, m_Specification.Width, m_Specification.Height );
@@ -1,9 +1,23 @@
 #include "gln.h"
 #include "editor.h"
 #include "Walnut/Random.h"
+#include <algorithm>
+
+#define LISTING_CHECK_INTERVAL 1.0 // seconds between checks of the shown directory's mtime when nothing is watching it
+
+static std::filesystem::path NormalizeDirectory( const std::filesystem::path& path )
+{
+	std::filesystem::path normal = path.lexically_normal();
+
+	if ( !normal.has_filename() && normal.has_parent_path() ) {
+		normal = normal.parent_path();
+	}
+	return normal;
+}
 
 ContentBrowserPanel::ContentBrowserPanel( void )
-	: m_BaseDirectory( g_pProjectManager->GetAssetDirectory() ), m_CurrentDirectory( m_BaseDirectory )
+	: m_BaseDirectory( g_pProjectManager->GetAssetDirectory() ), m_CurrentDirectory( m_BaseDirectory ),
+	m_nLastCheckTime( 0.0 ), m_bListingStale( true ), m_nWatchHandle( 0 ), m_bItemSelected( false )
 {
 }
 
@@ -14,73 +28,185 @@ ContentBrowserPanel::~ContentBrowserPanel()
 void ContentBrowserPanel::OnAttach( void ) {
 	m_pFileIcon = new Walnut::Image( va( "%sbitmaps/FileIcon.png", g_pEditor->m_CurrentPath.c_str() ) );
 	m_pDirectoryIcon = new Walnut::Image( va( "%sbitmaps/DirectoryIcon.png", g_pEditor->m_CurrentPath.c_str() ) );
+
+	m_nWatchHandle = Watch_AddListener( [this]( const watchEvent_t& event ) {
+		const std::filesystem::path path = NormalizeDirectory( event.path );
+		const std::filesystem::path listed = NormalizeDirectory( m_ListedDirectory );
+
+		// anything changing in the listed directory, or the directory itself going away
+		if ( ( event.flags & WATCH_RESCAN ) || path.parent_path() == listed || path == listed ) {
+			m_bListingStale = true;
+		}
+	} );
 }
 
 void ContentBrowserPanel::OnDetach( void ) {
+	Watch_RemoveListener( m_nWatchHandle );
 	delete m_pFileIcon;
 	delete m_pDirectoryIcon;
 }
 
+/*
+* RefreshListing: lists m_CurrentDirectory again if it's a different directory or the file watcher
+* saw something change in it. Without a watcher the directory's mtime is checked every so often,
+* which covers files being added, removed or renamed but not edited.
+*/
+void ContentBrowserPanel::RefreshListing( void )
+{
+	std::error_code error;
+	std::filesystem::file_time_type modifiedTime;
+
+	if ( m_ListedDirectory == m_CurrentDirectory && !m_bListingStale ) {
+		if ( Watch_IsActive() || ImGui::GetTime() - m_nLastCheckTime < LISTING_CHECK_INTERVAL ) {
+			return;
+		}
+		m_nLastCheckTime = ImGui::GetTime();
+
+		modifiedTime = std::filesystem::last_write_time( m_CurrentDirectory, error );
+		if ( !error && modifiedTime == m_ListedTime ) {
+			return;
+		}
+	}
+	m_ListedDirectory = m_CurrentDirectory;
+	m_ListedTime = std::filesystem::last_write_time( m_CurrentDirectory, error );
+	m_bListingStale = false;
+
+	m_Items.clear();
+	for ( const auto& directoryEntry : std::filesystem::directory_iterator{ m_CurrentDirectory, error } ) {
+		browserItem_t& item = m_Items.emplace_back();
+
+		item.path = directoryEntry.path().string();
+		item.name = directoryEntry.path().filename().string();
+		item.isDirectory = directoryEntry.is_directory( error );
+		item.fileSize = item.isDirectory ? 0 : directoryEntry.file_size( error );
+		item.modifiedTime = directoryEntry.last_write_time( error ).time_since_epoch().count();
+		item.hasThumbnail = !item.isDirectory && Thumb_CanGenerate( item.path.c_str() );
+	}
+	if ( error ) {
+		Log_FPrintf( SYS_WRN, "WARNING: failed to list directory '%s', %s\n", m_CurrentDirectory.c_str(), error.message().c_str() );
+	}
+
+	std::sort( m_Items.begin(), m_Items.end(), []( const browserItem_t& a, const browserItem_t& b ) {
+		if ( a.isDirectory != b.isDirectory ) {
+			return a.isDirectory;
+		}
+		return N_stricmp( a.name.c_str(), b.name.c_str() ) < 0;
+	} );
+}
+
+void ContentBrowserPanel::DrawItem( const browserItem_t& item, float thumbnailSize )
+{
+	thumbImage_t thumb;
+	ImTextureID texture;
+	ImVec2 uv0, uv1;
+	char label[MAX_OSPATH];
+	uint64_t length;
+
+	ImGui::PushID( item.path.c_str() );
+	ImGui::BeginGroup();
+
+	if ( item.hasThumbnail && Thumb_Get( item.path, item.fileSize, item.modifiedTime, &thumb ) ) {
+		texture = (ImTextureID)(intptr_t)thumb.texture;
+		uv0 = ImVec2( thumb.uv0[0], thumb.uv0[1] );
+		uv1 = ImVec2( thumb.uv1[0], thumb.uv1[1] );
+	} else {
+		texture = (ImTextureID)(intptr_t)( item.isDirectory ? m_pDirectoryIcon : m_pFileIcon )->GetID();
+		uv0 = ImVec2( 0, 0 );
+		uv1 = ImVec2( 1, 1 );
+	}
+
+	ImGui::PushStyleColor( ImGuiCol_Button, ImVec4( 0, 0, 0, 0 ) );
+	if ( ImGui::ImageButtonEx( ImGui::GetID( "##item" ), texture, { thumbnailSize, thumbnailSize }, uv0, uv1, { 0, 0, 0, 0 }, { 1, 1, 1, 1 } ) ) {
+		m_ItemPath = item.path;
+		m_bItemSelected = true;
+	}
+
+	if ( ImGui::BeginDragDropSource() ) {
+		ImGui::SetDragDropPayload( "CONTENT_BROWSER_ITEM", item.path.c_str(), ( item.path.size() + 1 ) * sizeof(char) );
+		ImGui::EndDragDropSource();
+	}
+
+	ImGui::PopStyleColor();
+	if ( ImGui::IsItemHovered() ) {
+		if ( ImGui::IsMouseDoubleClicked( ImGuiMouseButton_Left ) && item.isDirectory ) {
+			m_NextDirectory = item.path;
+		}
+		if ( item.isDirectory ) {
+			ImGui::SetTooltip( "%s", item.name.c_str() );
+		} else {
+			ImGui::SetTooltip( "%s\n%.2f KiB", item.name.c_str(), (double)item.fileSize / 1024.0 );
+		}
+	}
+
+	// one line per name so every row is the same height for the clipper
+	N_strncpyz( label, item.name.c_str(), sizeof(label) );
+	length = strlen( label );
+	if ( ImGui::CalcTextSize( label ).x > thumbnailSize ) {
+		while ( length > 1 && ImGui::CalcTextSize( label ).x + ImGui::CalcTextSize( "..." ).x > thumbnailSize ) {
+			label[--length] = '\0';
+		}
+		if ( length > sizeof(label) - 4 ) {
+			length = sizeof(label) - 4;
+		}
+		memcpy( label + length, "...", 4 );
+	}
+	ImGui::TextUnformatted( label );
+
+	ImGui::EndGroup();
+	ImGui::PopID();
+}
+
 void ContentBrowserPanel::OnUIRender( void )
 {
 	static float thumbnailSize = 132.0f;
-	const float cellSize = thumbnailSize;
-	const float panelWidth = ImGui::GetContentRegionAvail().x;
-    int columnCount;
+	int columnCount, rowCount;
+	float cellWidth, rowHeight;
 
 	ImGui::Begin( "Content Browser" );
 
 	if ( m_CurrentDirectory != m_BaseDirectory ) {
 		if ( ImGui::Button( "<-" ) ) {
-			m_CurrentDirectory = std::filesystem::path( m_CurrentDirectory ).parent_path();
+			m_CurrentDirectory = std::filesystem::path( m_CurrentDirectory ).parent_path().string();
 		}
 	}
 
-	columnCount = (int)( panelWidth / cellSize );
+	RefreshListing();
+
+	const ImGuiStyle& style = ImGui::GetStyle();
+	cellWidth = thumbnailSize + style.FramePadding.x * 2.0f;
+	rowHeight = thumbnailSize + style.FramePadding.y * 2.0f + style.ItemSpacing.y + ImGui::GetTextLineHeightWithSpacing();
 
+	columnCount = (int)( ( ImGui::GetContentRegionAvail().x + style.ItemSpacing.x ) / ( cellWidth + style.ItemSpacing.x ) );
 	if ( columnCount < 1 ) {
 		columnCount = 1;
-    }
-
-    ImGui::Columns( columnCount, NULL, false );
-
-	for ( const auto& directoryEntry : std::filesystem::directory_iterator{ m_CurrentDirectory } ) {
-		const auto& path = directoryEntry.path();
-		std::string filenameString = path.string();
-		
-		ImGui::PushID( filenameString.c_str() );
-		Walnut::Image *icon = directoryEntry.is_directory() ? m_pDirectoryIcon : m_pFileIcon;
-        const ImGuiID id = directoryEntry.is_directory() ? m_pDirectoryIcon->GetRendererID() : m_pFileIcon->GetRendererID();
-
-		ImGui::PushStyleColor( ImGuiCol_Button, ImVec4( 0, 0, 0, 0 ) );
-		if ( ImGui::ImageButtonEx( id, (ImTextureID)(intptr_t)icon->GetID(), { thumbnailSize, thumbnailSize }, { 0, 0 }, { 1, 1 }, { 0, 0, 0, 0 }, { 1, 1, 1, 1 } ) ) {
-			m_ItemPath = filenameString;
-			m_bItemSelected = true;
-		}
-		
-        if ( ImGui::BeginDragDropSource() ) {
-            const char *itemPath = path.c_str();
-            ImGui::SetDragDropPayload( "CONTENT_BROWSER_ITEM", itemPath, ( strlen( itemPath ) + 1 ) * sizeof(char) );
-			ImGui::EndDragDropSource();
-		}
-
-		ImGui::PopStyleColor();
-		if ( ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked( ImGuiMouseButton_Left ) ) {
-			if ( directoryEntry.is_directory() ) {
-				m_CurrentDirectory = path;
-            } else {
-
-            }
+	}
+	rowCount = ( (int)m_Items.size() + columnCount - 1 ) / columnCount;
+
+	// only the rows in view are submitted, a folder of thousands of files costs what a screenful does
+	ImGuiListClipper clipper;
+	clipper.Begin( rowCount, rowHeight );
+	while ( clipper.Step() ) {
+		for ( int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++ ) {
+			for ( int column = 0; column < columnCount; column++ ) {
+				const uint64_t index = (uint64_t)row * columnCount + column;
+
+				if ( index >= m_Items.size() ) {
+					break;
+				}
+				if ( column ) {
+					ImGui::SameLine();
+				}
+				DrawItem( m_Items[index], thumbnailSize );
+			}
 		}
-
-		const char *name = strrchr( filenameString.c_str(), PATH_SEP );
-		ImGui::TextWrapped( name ? name + 1 : filenameString.c_str() );
-		ImGui::NextColumn();
-		ImGui::PopID();
 	}
+	clipper.End();
 
-	ImGui::Columns( 1 );
+	if ( m_NextDirectory.size() ) {
+		m_CurrentDirectory = m_NextDirectory;
+		m_NextDirectory.clear();
+	}
 
 	// TODO: status bar
 	ImGui::End();
-}
\ No newline at end of file
+}
@@ -7,6 +7,19 @@
 
 #include <filesystem>
 
+/*
+* browserItem_t: one entry of the directory being shown, listed once and kept until the directory
+* changes rather than walked every frame
+*/
+typedef struct {
+	std::string path;
+	std::string name;
+	uint64_t fileSize;
+	int64_t modifiedTime;
+	bool isDirectory;
+	bool hasThumbnail;
+} browserItem_t;
+
 class ContentBrowserPanel : public Walnut::Layer
 {
 public:
@@ -19,10 +32,21 @@ public:
 
     const std::string& GetItemPath( void ) const;
 	bool ItemIsSelected( void ) const;
+private:
+	void RefreshListing( void );
+	void DrawItem( const browserItem_t& item, float thumbnailSize );
 public:
 	std::string m_BaseDirectory;
 	std::string m_CurrentDirectory;
 
+	std::vector<browserItem_t> m_Items;
+	std::string m_ListedDirectory;
+	std::filesystem::file_time_type m_ListedTime;
+	double m_nLastCheckTime; // only used without a file watcher
+	bool m_bListingStale;
+	int m_nWatchHandle;
+	std::string m_NextDirectory; // navigation is deferred to the end of the frame's listing
+
     std::string m_ItemPath;
 	bool m_bItemSelected;
 
@@ -107,6 +107,8 @@ SOFTWARE.
 #include <algorithm>
 #include <iostream>
 
+#include "jobs.h"  // the file list is scanned on the editor's job pool
+
 #pragma endregion
 
 #pragma region Common defines
@@ -277,6 +279,20 @@ SOFTWARE.
 #define DateTimeFormat "%Y/%m/%d %H:%M"
 #endif  // DateTimeFormat
 ///////////////////////////////
+// SCANNING
+///////////////////////////////
+#ifndef scanBatchSize
+// count of entries the background scan hands over at once,
+// also the list size from which sorting goes to the background
+#define scanBatchSize 256
+#endif  // scanBatchSize
+#ifndef scanProgressString
+#define scanProgressString "%u/%u"
+#endif  // scanProgressString
+#ifndef scanProgressWidth
+#define scanProgressWidth 100.0f
+#endif  // scanProgressWidth
+///////////////////////////////
 // THUMBNAILS
 ///////////////////////////////
 #ifdef USE_THUMBNAILS
@@ -1633,6 +1649,20 @@ bool IGFD::FileInfos::FinalizeFileTypeParsing(const size_t& vMaxDotToExtract) {
 
 #pragma region FileManager
 
+// shared between the FileManager and the job scanning or sorting for it. the job holds its own
+// reference, so a scan that is no longer wanted can be dropped without waiting on it
+struct IGFD::FileManager::ScanState {
+    jobGroup_t group;
+    std::mutex lock;
+    std::vector<std::shared_ptr<FileInfos>> found;   // built since the last PollScan, guarded by lock
+    std::vector<std::shared_ptr<FileInfos>> sorted;  // the whole list once the job is done, guarded by lock
+    bool done = false;                               // guarded by lock
+    std::atomic<uint32_t> processed{0};              // directory entries handled, for the progress bar
+    std::atomic<uint32_t> total{0};                  // directory entries found, 0 until the directory is read
+    SortingFieldEnum sortingField = SortingFieldEnum::FIELD_NONE;  // the order the job sorts in
+    bool sortingDirection = true;
+};
+
 IGFD::FileManager::FileManager() {
     fsRoot = std::string(1u, PATH_SEP);
     m_FileSystemName = typeid(FILE_SYSTEM_OVERRIDE).name();
@@ -1641,6 +1671,10 @@ IGFD::FileManager::FileManager() {
     //m_FileSystemPtr = std::make_unique<FILE_SYSTEM_OVERRIDE>();
 }
 
+IGFD::FileManager::~FileManager() {
+    m_CancelScan();
+}
+
 void IGFD::FileManager::OpenCurrentPath(const FileDialogInternal& vFileDialogInternal) {
     showDrives = false;
     ClearComposer();
@@ -1654,12 +1688,47 @@ void IGFD::FileManager::OpenCurrentPath(const FileDialogInternal& vFileDialogInt
 }
 
 void IGFD::FileManager::SortFields(const FileDialogInternal& vFileDialogInternal) {
-    m_SortFields(vFileDialogInternal, m_FileList, m_FilteredFileList);
+    m_UpdateSortingHeaders();
+    if (IsScanning()) {
+        return;  // PollScan sorts again when the running job is done, if it was started with another order
+    }
+    if (m_FileList.size() < scanBatchSize) {
+        m_SortFileList(sortingField, m_GetSortingDirection(), m_FileList);
+        m_FilterCache.clear();
+        ApplyFilteringOnFileList(vFileDialogInternal);
+        return;
+    }
+
+    // a big directory is sorted on a copy in the background, the list keeps its old order until then
+    auto state = std::make_shared<ScanState>();
+    state->sortingField = sortingField;
+    state->sortingDirection = m_GetSortingDirection();
+    m_ScanState = state;
+
+    auto list = m_FileList;
+    Job_Add(&state->group, JOB_PRIORITY_INTERACTIVE, [state, list]() mutable {
+        m_SortFileList(state->sortingField, state->sortingDirection, list);
+        std::lock_guard<std::mutex> lock(state->lock);
+        state->sorted = std::move(list);
+        state->done = true;
+    });
 }
 
 void IGFD::FileManager::m_SortFields(const FileDialogInternal& vFileDialogInternal,
     std::vector<std::shared_ptr<FileInfos>>& vFileInfosList,
     std::vector<std::shared_ptr<FileInfos>>& vFileInfosFilteredList) {
+    m_UpdateSortingHeaders();
+    m_SortFileList(sortingField, m_GetSortingDirection(), vFileInfosList);
+    m_ApplyFilteringOnFileList(vFileDialogInternal, vFileInfosList, vFileInfosFilteredList);
+}
+
+bool IGFD::FileManager::m_GetSortingDirection() const {
+    if (sortingField == SortingFieldEnum::FIELD_NONE)
+        return true;
+    return sortingDirection[(size_t)sortingField - 1U];
+}
+
+void IGFD::FileManager::m_UpdateSortingHeaders() {
     if (sortingField != SortingFieldEnum::FIELD_NONE) {
         headerFileName = tableHeaderFileNameString;
         headerFileType = tableHeaderFileTypeString;
@@ -1669,11 +1738,28 @@ void IGFD::FileManager::m_SortFields(const FileDialogInternal& vFileDialogIntern
         headerFileThumbnails = tableHeaderFileThumbnailsString;
 #endif  // #ifdef USE_THUMBNAILS
     }
-    if (sortingField == SortingFieldEnum::FIELD_FILENAME) {
-        if (sortingDirection[0]) {
 #ifdef USE_CUSTOM_SORTING_ICON
-            headerFileName = tableHeaderAscendingIcon + headerFileName;
+    const char* icon = m_GetSortingDirection() ? tableHeaderAscendingIcon : tableHeaderDescendingIcon;
+    if (sortingField == SortingFieldEnum::FIELD_FILENAME) {
+        headerFileName = icon + headerFileName;
+    } else if (sortingField == SortingFieldEnum::FIELD_TYPE) {
+        headerFileType = icon + headerFileType;
+    } else if (sortingField == SortingFieldEnum::FIELD_SIZE) {
+        headerFileSize = icon + headerFileSize;
+    } else if (sortingField == SortingFieldEnum::FIELD_DATE) {
+        headerFileDate = icon + headerFileDate;
+    }
+#ifdef USE_THUMBNAILS
+    else if (sortingField == SortingFieldEnum::FIELD_THUMBNAILS) {
+        headerFileThumbnails = icon + headerFileThumbnails;
+    }
+#endif  // USE_THUMBNAILS
 #endif  // USE_CUSTOM_SORTING_ICON
+}
+
+void IGFD::FileManager::m_SortFileList(SortingFieldEnum vSortingField, bool vAscending, std::vector<std::shared_ptr<FileInfos>>& vFileInfosList) {
+    if (vSortingField == SortingFieldEnum::FIELD_FILENAME) {
+        if (vAscending) {
             std::sort(
                 vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                     if (!a.use_count() || !b.use_count())
@@ -1699,9 +1785,6 @@ void IGFD::FileManager::m_SortFields(const FileDialogInternal& vFileDialogIntern
                     return (stricmp(a->fileNameExt.c_str(), b->fileNameExt.c_str()) < 0);  // sort in insensitive case
                 });
         } else {
-#ifdef USE_CUSTOM_SORTING_ICON
-            headerFileName = tableHeaderDescendingIcon + headerFileName;
-#endif  // USE_CUSTOM_SORTING_ICON
             std::sort(
                 vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                     if (!a.use_count() || !b.use_count())
@@ -1727,11 +1810,8 @@ void IGFD::FileManager::m_SortFields(const FileDialogInternal& vFileDialogIntern
                     return (stricmp(a->fileNameExt.c_str(), b->fileNameExt.c_str()) > 0);  // sort in insensitive case
                 });
         }
-    } else if (sortingField == SortingFieldEnum::FIELD_TYPE) {
-        if (sortingDirection[1]) {
-#ifdef USE_CUSTOM_SORTING_ICON
-            headerFileType = tableHeaderAscendingIcon + headerFileType;
-#endif  // USE_CUSTOM_SORTING_ICON
+    } else if (vSortingField == SortingFieldEnum::FIELD_TYPE) {
+        if (vAscending) {
             std::sort(
                 vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                     if (!a.use_count() || !b.use_count())
@@ -1741,9 +1821,6 @@ void IGFD::FileManager::m_SortFields(const FileDialogInternal& vFileDialogIntern
                     return (a->fileExtLevels[0] < b->fileExtLevels[0]);  // else
                 });
         } else {
-#ifdef USE_CUSTOM_SORTING_ICON
-            headerFileType = tableHeaderDescendingIcon + headerFileType;
-#endif  // USE_CUSTOM_SORTING_ICON
             std::sort(
                 vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                     if (!a.use_count() || !b.use_count())
@@ -1753,11 +1830,8 @@ void IGFD::FileManager::m_SortFields(const FileDialogInternal& vFileDialogIntern
                     return (a->fileExtLevels[0] > b->fileExtLevels[0]);  // else
                 });
         }
-    } else if (sortingField == SortingFieldEnum::FIELD_SIZE) {
-        if (sortingDirection[2]) {
-#ifdef USE_CUSTOM_SORTING_ICON
-            headerFileSize = tableHeaderAscendingIcon + headerFileSize;
-#endif  // USE_CUSTOM_SORTING_ICON
+    } else if (vSortingField == SortingFieldEnum::FIELD_SIZE) {
+        if (vAscending) {
             std::sort(
                 vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                     if (!a.use_count() || !b.use_count())
@@ -1767,9 +1841,6 @@ void IGFD::FileManager::m_SortFields(const FileDialogInternal& vFileDialogIntern
                     return (a->fileSize < b->fileSize);      // else
                 });
         } else {
-#ifdef USE_CUSTOM_SORTING_ICON
-            headerFileSize = tableHeaderDescendingIcon + headerFileSize;
-#endif  // USE_CUSTOM_SORTING_ICON
             std::sort(
                 vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                     if (!a.use_count() || !b.use_count())
@@ -1779,11 +1850,8 @@ void IGFD::FileManager::m_SortFields(const FileDialogInternal& vFileDialogIntern
                     return (a->fileSize > b->fileSize);      // else
                 });
         }
-    } else if (sortingField == SortingFieldEnum::FIELD_DATE) {
-        if (sortingDirection[3]) {
-#ifdef USE_CUSTOM_SORTING_ICON
-            headerFileDate = tableHeaderAscendingIcon + headerFileDate;
-#endif  // USE_CUSTOM_SORTING_ICON
+    } else if (vSortingField == SortingFieldEnum::FIELD_DATE) {
+        if (vAscending) {
             std::sort(
                 vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                     if (!a.use_count() || !b.use_count())
@@ -1793,9 +1861,6 @@ void IGFD::FileManager::m_SortFields(const FileDialogInternal& vFileDialogIntern
                     return (a->fileModifDate < b->fileModifDate);  // else
                 });
         } else {
-#ifdef USE_CUSTOM_SORTING_ICON
-            headerFileDate = tableHeaderDescendingIcon + headerFileDate;
-#endif  // USE_CUSTOM_SORTING_ICON
             std::sort(
                 vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                     if (!a.use_count() || !b.use_count())
@@ -1807,15 +1872,12 @@ void IGFD::FileManager::m_SortFields(const FileDialogInternal& vFileDialogIntern
         }
     }
 #ifdef USE_THUMBNAILS
-    else if (sortingField == SortingFieldEnum::FIELD_THUMBNAILS) {
+    else if (vSortingField == SortingFieldEnum::FIELD_THUMBNAILS) {
         // we will compare thumbnails by :
         // 1) width
         // 2) height
 
-        if (sortingDirection[4]) {
-#ifdef USE_CUSTOM_SORTING_ICON
-            headerFileThumbnails = tableHeaderAscendingIcon + headerFileThumbnails;
-#endif  // USE_CUSTOM_SORTING_ICON
+        if (vAscending) {
             std::sort(
                 vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                     if (!a.use_count() || !b.use_count())
@@ -1829,9 +1891,6 @@ void IGFD::FileManager::m_SortFields(const FileDialogInternal& vFileDialogIntern
         }
 
         else {
-#ifdef USE_CUSTOM_SORTING_ICON
-            headerFileThumbnails = tableHeaderDescendingIcon + headerFileThumbnails;
-#endif  // USE_CUSTOM_SORTING_ICON
             std::sort(
                 vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                     if (!a.use_count() || !b.use_count())
@@ -1845,13 +1904,13 @@ void IGFD::FileManager::m_SortFields(const FileDialogInternal& vFileDialogIntern
         }
     }
 #endif  // USE_THUMBNAILS
-
-    m_ApplyFilteringOnFileList(vFileDialogInternal, vFileInfosList, vFileInfosFilteredList);
 }
 
 void IGFD::FileManager::ClearFileLists() {
+    m_CancelScan();
     m_FilteredFileList.clear();
     m_FileList.clear();
+    m_FilterCache.clear();
 }
 
 void IGFD::FileManager::ClearPathLists() {
@@ -1859,8 +1918,11 @@ void IGFD::FileManager::ClearPathLists() {
     m_PathList.clear();
 }
 
-void IGFD::FileManager::m_AddFile(
-    const FileDialogInternal& vFileDialogInternal, const std::string& vPath, const std::string& vFileName, const FileType& vFileType) {
+std::shared_ptr<IGFD::FileInfos> IGFD::FileManager::m_MakeFileInfos(const FilterManager& vFilterManager,
+    ImGuiFileDialogFlags vFlags,
+    const std::string& vPath,
+    const std::string& vFileName,
+    const FileType& vFileType) {
     auto infos = std::make_shared<FileInfos>();
 
     infos->filePath = vPath;
@@ -1869,30 +1931,28 @@ void IGFD::FileManager::m_AddFile(
     infos->fileType = vFileType;
 
     if (infos->fileNameExt.empty() ||
-        (infos->fileNameExt == "." &&
-            !vFileDialogInternal.filterManager.dLGFilters.empty())) {  // filename empty or filename is the current dir '.' //-V807
-        return;
+        (infos->fileNameExt == "." && !vFilterManager.dLGFilters.empty())) {  // filename empty or filename is the current dir '.' //-V807
+        return nullptr;
     }
 
-    if (infos->fileNameExt != ".." && (vFileDialogInternal.dLGflags & ImGuiFileDialogFlags_DontShowHiddenFiles) &&
+    if (infos->fileNameExt != ".." && (vFlags & ImGuiFileDialogFlags_DontShowHiddenFiles) &&
         infos->fileNameExt[0] == '.') {  // dont show hidden files
-        if (!vFileDialogInternal.filterManager.dLGFilters.empty() ||
-            (vFileDialogInternal.filterManager.dLGFilters.empty() && infos->fileNameExt != ".")) {  // except "." if in directory mode //-V728
-            return;
+        if (!vFilterManager.dLGFilters.empty() ||
+            (vFilterManager.dLGFilters.empty() && infos->fileNameExt != ".")) {  // except "." if in directory mode //-V728
+            return nullptr;
         }
     }
 
-    if (infos->FinalizeFileTypeParsing(vFileDialogInternal.filterManager.GetSelectedFilter().count_dots)) {
-        if (!vFileDialogInternal.filterManager.IsCoveredByFilters(
-                *infos.get(), (vFileDialogInternal.dLGflags & ImGuiFileDialogFlags_CaseInsensitiveExtention) != 0)) {
-            return;
+    if (infos->FinalizeFileTypeParsing(vFilterManager.GetSelectedFilter().count_dots)) {
+        if (!vFilterManager.IsCoveredByFilters(*infos.get(), (vFlags & ImGuiFileDialogFlags_CaseInsensitiveExtention) != 0)) {
+            return nullptr;
         }
     }
 
-    vFileDialogInternal.filterManager.m_FillFileStyle(infos);
+    vFilterManager.m_FillFileStyle(infos);
 
     m_CompleteFileInfos(infos);
-    m_FileList.push_back(infos);
+    return infos;
 }
 
 void IGFD::FileManager::m_AddPath(
@@ -1941,14 +2001,121 @@ void IGFD::FileManager::ScanDir(const FileDialogInternal& vFileDialogInternal, c
 #endif  // _IGFD_WIN_
 
         ClearFileLists();
+        m_UpdateSortingHeaders();
 
-        const auto& files = m_FileSystemPtr->ScanDirectory(vPath);
-        for (const auto& file : files) {
-            m_AddFile(vFileDialogInternal, path, file.fileNameExt, file.fileType);
+        // stat'ing, filtering and sorting a big directory would stall the dialog for as long,
+        // so it is done on the job pool and the entries are streamed in by PollScan
+        auto state = std::make_shared<ScanState>();
+        state->sortingField = sortingField;
+        state->sortingDirection = m_GetSortingDirection();
+        m_ScanState = state;
+
+        // the job works on its own copy of the filters, the dialog may change them meanwhile
+        const FilterManager filterManager = vFileDialogInternal.filterManager;
+        const ImGuiFileDialogFlags flags = vFileDialogInternal.dLGflags;
+        Job_Add(&state->group, JOB_PRIORITY_INTERACTIVE, [state, filterManager, flags, path, vPath]() {
+            m_ScanJob(state, filterManager, flags, path, vPath);
+        });
+    }
+}
+
+void IGFD::FileManager::m_ScanJob(const std::shared_ptr<ScanState>& vState,
+    const FilterManager& vFilterManager,
+    ImGuiFileDialogFlags vFlags,
+    const std::string& vPath,
+    const std::string& vScanPath) {
+    FILE_SYSTEM_OVERRIDE fileSystem;  // stateless, so the job doesn't depend on the FileManager staying alive
+    const auto& files = fileSystem.ScanDirectory(vScanPath);
+    vState->total = (uint32_t)files.size();
+
+    std::vector<std::shared_ptr<FileInfos>> list;
+    std::vector<std::shared_ptr<FileInfos>> batch;
+    list.reserve(files.size());
+    for (const auto& file : files) {
+        if (Job_Cancelled(&vState->group)) {
+            return;
+        }
+        auto infos = m_MakeFileInfos(vFilterManager, vFlags, vPath, file.fileNameExt, file.fileType);
+        if (infos) {
+            list.push_back(infos);
+            batch.push_back(infos);
+        }
+        ++vState->processed;
+
+        if (batch.size() >= scanBatchSize) {
+            std::lock_guard<std::mutex> lock(vState->lock);
+            vState->found.insert(vState->found.end(), batch.begin(), batch.end());
+            batch.clear();
+        }
+    }
+
+    m_SortFileList(vState->sortingField, vState->sortingDirection, list);
+
+    std::lock_guard<std::mutex> lock(vState->lock);
+    vState->sorted = std::move(list);
+    vState->done = true;
+}
+
+void IGFD::FileManager::m_CancelScan() {
+    if (m_ScanState) {
+        Job_Cancel(&m_ScanState->group);
+        m_ScanState.reset();
+    }
+}
+
+bool IGFD::FileManager::IsScanning() const {
+    return m_ScanState != nullptr;
+}
+
+void IGFD::FileManager::PollScan(const FileDialogInternal& vFileDialogInternal) {
+    if (!m_ScanState) {
+        return;
+    }
+
+    std::vector<std::shared_ptr<FileInfos>> found;
+    std::vector<std::shared_ptr<FileInfos>> sorted;
+    bool done;
+    {
+        std::lock_guard<std::mutex> lock(m_ScanState->lock);
+        found.swap(m_ScanState->found);
+        sorted.swap(m_ScanState->sorted);
+        done = m_ScanState->done;
+    }
+
+    if (done) {
+        // sorted holds everything, including what was already streamed in
+        const bool needResort =
+            m_ScanState->sortingField != sortingField || m_ScanState->sortingDirection != m_GetSortingDirection();
+        m_ScanState.reset();
+        m_FileList = std::move(sorted);
+        m_FilterCache.clear();
+        ApplyFilteringOnFileList(vFileDialogInternal);
+        if (needResort) {  // the user clicked on a column while the job was running
+            SortFields(vFileDialogInternal);
+        }
+    } else if (!found.empty()) {
+        // unsorted until the scan is done, so the entries only ever go to the end of the list
+        m_FilterCache.clear();
+        for (const auto& file : found) {
+            m_FileList.push_back(file);
+            if (m_IsFilteredIn(vFileDialogInternal, file)) {
+                m_FilteredFileList.push_back(file);
+            }
         }
+    }
+}
 
-        m_SortFields(vFileDialogInternal, m_FileList, m_FilteredFileList);
+bool IGFD::FileManager::DrawScanProgress() {
+    if (!m_ScanState) {
+        return false;
     }
+
+    const uint32_t total = m_ScanState->total;
+    const uint32_t processed = m_ScanState->processed;
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), scanProgressString, processed, total);
+    ImGui::ProgressBar(total ? (float)((double)processed / (double)total) : 0.0f, ImVec2(scanProgressWidth, 0.0f), buffer);
+    return true;
 }
 
 void IGFD::FileManager::m_ScanDirForPathSelection(const FileDialogInternal& vFileDialogInternal, const std::string& vPath) {
@@ -2078,24 +2245,50 @@ void IGFD::FileManager::ClearAll() {
     ClearPathLists();
 }
 void IGFD::FileManager::ApplyFilteringOnFileList(const FileDialogInternal& vFileDialogInternal) {
-    m_ApplyFilteringOnFileList(vFileDialogInternal, m_FileList, m_FilteredFileList);
+    // the search bar filters again on every key typed, so the results of each tag are kept
+    // until the list changes. a tag matching a file also means its prefixes do, so a longer
+    // tag only has to go over the result of the longest prefix already filtered
+    const std::string& tag = vFileDialogInternal.searchManager.searchTag;
+    auto cached = m_FilterCache.find(tag);
+    if (cached != m_FilterCache.end()) {
+        m_FilteredFileList = cached->second;
+        return;
+    }
+
+    std::vector<std::shared_ptr<FileInfos>>* source = &m_FileList;
+    for (size_t len = tag.size(); len > 0U; --len) {
+        auto prefix = m_FilterCache.find(tag.substr(0U, len - 1U));
+        if (prefix != m_FilterCache.end()) {
+            source = &prefix->second;
+            break;
+        }
+    }
+
+    m_ApplyFilteringOnFileList(vFileDialogInternal, *source, m_FilteredFileList);
+    if (!IsScanning()) {
+        m_FilterCache[tag] = m_FilteredFileList;
+    }
+}
+
+bool IGFD::FileManager::m_IsFilteredIn(const FileDialogInternal& vFileDialogInternal, const std::shared_ptr<FileInfos>& vInfos) const {
+    if (!vInfos.use_count())
+        return false;
+    if (!vInfos->SearchForTag(vFileDialogInternal.searchManager.searchTag))  // if search tag
+        return false;
+    if (dLGDirectoryMode && !vInfos->fileType.isDir())
+        return false;
+    return true;
 }
 
 void IGFD::FileManager::m_ApplyFilteringOnFileList(const FileDialogInternal& vFileDialogInternal,
     std::vector<std::shared_ptr<FileInfos>>& vFileInfosList,
     std::vector<std::shared_ptr<FileInfos>>& vFileInfosFilteredList) {
-    vFileInfosFilteredList.clear();
+    std::vector<std::shared_ptr<FileInfos>> filtered;  // vFileInfosList may be a cached filtered list
     for (const auto& file : vFileInfosList) {
-        if (!file.use_count())
-            continue;
-        bool show = true;
-        if (!file->SearchForTag(vFileDialogInternal.searchManager.searchTag))  // if search tag
-            show = false;
-        if (dLGDirectoryMode && !file->fileType.isDir())
-            show = false;
-        if (show)
-            vFileInfosFilteredList.push_back(file);
+        if (m_IsFilteredIn(vFileDialogInternal, file))
+            filtered.push_back(file);
     }
+    vFileInfosFilteredList = std::move(filtered);
 }
 
 std::string IGFD::FileManager::m_RoundNumber(double vvalue, int n) {
@@ -2167,9 +2360,9 @@ void IGFD::FileManager::m_CompleteFileInfos(const std::shared_ptr<FileInfos>& vI
             if (!err)
                 len = strftime(timebuf, 99, DateTimeFormat, &_tm);
 #else   // _MSC_VER
-            struct tm* _tm = localtime(&statInfos.st_mtime);
-            if (_tm)
-                len = strftime(timebuf, 99, DateTimeFormat, _tm);
+            struct tm _tm;  // localtime_r, this runs on the scan jobs
+            if (localtime_r(&statInfos.st_mtime, &_tm))
+                len = strftime(timebuf, 99, DateTimeFormat, &_tm);
 #endif  // _MSC_VER
             if (len) {
                 vInfos->fileModifDate = std::string(timebuf, len);
@@ -2643,6 +2836,7 @@ void IGFD::FileDialogInternal::NewFrame() {
     isOk = false;          // reset dialog result
     fileManager.drivesClicked = false;
     fileManager.puPathClicked = false;
+    fileManager.PollScan(*this);
 
     needToExitDialog = false;
 
@@ -3782,7 +3976,7 @@ bool IGFD::FileDialog::Display(const std::string& vKey, ImGuiWindowFlags vFlags,
                 fdFilter.SetDefaultFilterIfNotDefined();
 
                 // init list of files
-                if (fdFile.IsFileListEmpty() && !fdFile.showDrives) {
+                if (fdFile.IsFileListEmpty() && !fdFile.showDrives && !fdFile.IsScanning()) {
                     if (fdFile.dLGpath != ".")  // Removes extension seperator in filename if we don't check
                         IGFD::Utils::ReplaceString(fdFile.dLGDefaultFileName, fdFile.dLGpath, "");  // local path
 
@@ -3874,6 +4068,9 @@ void IGFD::FileDialog::m_DrawHeader() {
     }
 #endif  // USE_THUMBNAILS
 
+    if (m_FileDialogInternal.fileManager.DrawScanProgress()) {
+        ImGui::SameLine();
+    }
     m_FileDialogInternal.searchManager.DrawSearchBar(m_FileDialogInternal);
 }
 
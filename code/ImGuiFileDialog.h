@@ -1678,6 +1678,9 @@ private:
     bool m_CreateDirectoryMode = false;                          // for create directory widget
     std::string m_FileSystemName;
     std::unique_ptr<IFileSystem> m_FileSystemPtr = nullptr;
+    struct ScanState;                                            // shared with the background scan or sort of m_FileList
+    std::shared_ptr<ScanState> m_ScanState;                      // the running scan or sort, if any
+    std::map<std::string, std::vector<std::shared_ptr<FileInfos>>> m_FilterCache;  // m_FileList filtered by search tag, cleared when m_FileList changes
 
 public:
     bool inputPathActivated = false;                             // show input for path edition
@@ -1717,12 +1720,21 @@ private:
     static std::string m_RoundNumber(double vvalue, int n);                        // custom rounding number
     static std::string m_FormatFileSize(size_t vByteSize);                         // format file size field
     static void m_CompleteFileInfos(const std::shared_ptr<FileInfos>& FileInfos);  // set time and date infos of a file (detail view mode)
-    void m_RemoveFileNameInSelection(const std::string& vFileName);                // selection : remove a file name
-    void m_m_AddFileNameInSelection(const std::string& vFileName, bool vSetLastSelectionFileName);  // selection : add a file name
-    void m_AddFile(const FileDialogInternal& vFileDialogInternal,
+    static std::shared_ptr<FileInfos> m_MakeFileInfos(const FilterManager& vFilterManager,
+        ImGuiFileDialogFlags vFlags,
         const std::string& vPath,
         const std::string& vFileName,
-        const FileType& vFileType);  // add file called by scandir
+        const FileType& vFileType);  // build the infos of a file, nullptr if filtered out. safe to call from a job
+    static void m_SortFileList(SortingFieldEnum vSortingField,
+        bool vAscending,
+        std::vector<std::shared_ptr<FileInfos>>& vFileInfosList);  // sort only, safe to call from a job
+    static void m_ScanJob(const std::shared_ptr<ScanState>& vState,
+        const FilterManager& vFilterManager,
+        ImGuiFileDialogFlags vFlags,
+        const std::string& vPath,
+        const std::string& vScanPath);  // background part of ScanDir
+    void m_RemoveFileNameInSelection(const std::string& vFileName);                // selection : remove a file name
+    void m_m_AddFileNameInSelection(const std::string& vFileName, bool vSetLastSelectionFileName);  // selection : add a file name
     void m_AddPath(const FileDialogInternal& vFileDialogInternal,
         const std::string& vPath,
         const std::string& vFileName,
@@ -1732,15 +1744,20 @@ private:
     void m_OpenPathPopup(const FileDialogInternal& vFileDialogInternal,
         std::vector<std::string>::iterator vPathIter);  // open the popup list of paths
     void m_SetCurrentPath(std::vector<std::string>::iterator vPathIter);  // set the current path, update the path bar
+    bool m_IsFilteredIn(const FileDialogInternal& vFileDialogInternal, const std::shared_ptr<FileInfos>& vInfos) const;  // search tag and directory mode
     void m_ApplyFilteringOnFileList(const FileDialogInternal& vFileDialogInternal,
         std::vector<std::shared_ptr<FileInfos>>& vFileInfosList,
         std::vector<std::shared_ptr<FileInfos>>& vFileInfosFilteredList);
+    bool m_GetSortingDirection() const;  // direction of the current sorting field
+    void m_UpdateSortingHeaders();       // column labels with the sorting icon
     void m_SortFields(const FileDialogInternal& vFileDialogInternal,
         std::vector<std::shared_ptr<FileInfos>>& vFileInfosList,
         std::vector<std::shared_ptr<FileInfos>>& vFileInfosFilteredList);  // will sort a column
+    void m_CancelScan();  // drop the running scan or sort, its job bails out on its own
 
 public:
     FileManager();
+    ~FileManager();
     bool IsComposerEmpty();
     size_t GetComposerSize();
     bool IsFileListEmpty();
@@ -1776,7 +1793,10 @@ public:
         const std::shared_ptr<FileInfos>& vInfos);  // select filename
     void SetCurrentDir(const std::string& vPath);   // define current directory for scan
     void ScanDir(const FileDialogInternal& vFileDialogInternal,
-        const std::string& vPath);  // scan the directory for retrieve the file list
+        const std::string& vPath);  // scan the directory for retrieve the file list, runs in the background
+    bool IsScanning() const;        // a scan or sort of the file list is still running
+    void PollScan(const FileDialogInternal& vFileDialogInternal);  // take what the background scan found since the last frame
+    bool DrawScanProgress();        // draw the scan progress bar, false if there is no scan running
 
     std::string GetResultingPath();
     std::string GetResultingFileName(FileDialogInternal& vFileDialogInternal, IGFD_ResultMode vFlag);
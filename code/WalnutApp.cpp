@@ -84,24 +84,7 @@ static void InitDialogs( void )
 
 	g_pPrefsDlg->LoadImGuiData();
 
-	parm_compression = CheckParm( "-compression" );
-
-	if ( parm_compression != -1 ) {
-		if ( !N_stricmp( myargv[parm_compression+1], "zlib" ) ) {
-			parm_compression = COMPRESS_ZLIB;
-			Log_Printf( "Manual compression override for zlib.\n" );
-		} else if ( !N_stricmp( myargv[parm_compression+1], "bzip2" ) ) {
-			parm_compression = COMPRESS_BZIP2;
-			Log_Printf( "Manual compression override for bzip2.\n" );
-		} else {
-			Log_FPrintf( SYS_WRN, "WARNING: invalid compression format provided '%s', defaulting to zlib\n", myargv[parm_compression+1] );
-			parm_compression = COMPRESS_ZLIB;
-		}
-	}
-	else {
-		parm_compression = COMPRESS_ZLIB;
-		Log_Printf( "Using ZLib compression.\n" );
-	}
+	GLN_InitCompression();
 
 	Walnut::InitShaders();
 	Walnut::InitTextures();
@@ -168,16 +151,19 @@ bool IsMouseInCurrentWindow( void )
 	return false;
 }
 
+static void SetMapTexture( int bundle, const std::string& path )
+{
+	g_pAssetManagerDlg->AddTextureFile( path );
+	Tex_Release( mapData->textures[bundle] );
+	mapData->textures[bundle] = Tex_Load( path.c_str() );
+}
+
 void DrawFileDialogs( void )
 {
-	FileDialogUIRender( "SelectDiffuseMapDlg", []( const std::string& path ){ g_pAssetManagerDlg->AddTextureFile( path );
-			mapData->textures[Walnut::TB_DIFFUSEMAP] = Walnut::FindImage( path.c_str() ); } );
-	FileDialogUIRender( "SelectSpecularMapDlg", []( const std::string& path ){ g_pAssetManagerDlg->AddTextureFile( path );
-			mapData->textures[Walnut::TB_SPECULARMAP] = Walnut::FindImage( path.c_str() ); } );
-	FileDialogUIRender( "SelectAmbientOccMapDlg", []( const std::string& path ){ g_pAssetManagerDlg->AddTextureFile( path );
-			mapData->textures[Walnut::TB_LIGHTMAP] = Walnut::FindImage( path.c_str() ); } );
-	FileDialogUIRender( "SelectNormalMapDlg", []( const std::string& path ){ g_pAssetManagerDlg->AddTextureFile( path );
-		mapData->textures[Walnut::TB_NORMALMAP] = Walnut::FindImage( path.c_str() ); } );
+	FileDialogUIRender( "SelectDiffuseMapDlg", []( const std::string& path ){ SetMapTexture( Walnut::TB_DIFFUSEMAP, path ); } );
+	FileDialogUIRender( "SelectSpecularMapDlg", []( const std::string& path ){ SetMapTexture( Walnut::TB_SPECULARMAP, path ); } );
+	FileDialogUIRender( "SelectAmbientOccMapDlg", []( const std::string& path ){ SetMapTexture( Walnut::TB_LIGHTMAP, path ); } );
+	FileDialogUIRender( "SelectNormalMapDlg", []( const std::string& path ){ SetMapTexture( Walnut::TB_NORMALMAP, path ); } );
 	FileDialogUIRender( "AddTextureFileDlg", []( const std::string& path ){ g_pAssetManagerDlg->AddTextureFile( path ); } );
 	FileDialogUIRender( "LoadProjectFileDlg", []( const std::string& path ){ g_pProjectManager->SetCurrent( path, false ); } );
 	FileDialogUIRender( "ImportMapFileDlg", []( const std::string& path ){ if ( IsMap( path.c_str() ) ) { Map_LoadFile( path.c_str() ); } } );
@@ -362,19 +348,21 @@ void Valden_HandleInput( void )
 		}
 		if ( ImGui::IsKeyDown( ImGuiKey_C ) ) {
 			if ( g_pMapDrawer->m_bTileSelectOn ) {
-				g_pEditor->m_pCopyPasteData = CopyMemory( &mapData->tiles[g_pMapDrawer->m_nTileSelectY * mapData->width + g_pMapDrawer->m_nTileSelectX],
-					sizeof(maptile_t) );
+				g_pEditor->m_pCopyPasteData = GetMemory( sizeof(maptile_t), TAG_UI );
+				Tiles_GetTile( &mapData->tiles, g_pMapDrawer->m_nTileSelectY * mapData->width + g_pMapDrawer->m_nTileSelectX,
+					mapData->texcoords, mapData->tileset.numTiles, (maptile_t *)g_pEditor->m_pCopyPasteData );
 				Log_Printf( "Copied tile at %ix%i to editor clipboard.\n" );
 			}
 		}
 		if ( ImGui::IsKeyDown( ImGuiKey_V ) ) {
 			if ( g_pMapDrawer->m_bTileSelectOn ) {
-				memcpy( &mapData->tiles[g_pMapDrawer->m_nTileSelectY * mapData->width + g_pMapDrawer->m_nTileSelectX], g_pEditor->m_pCopyPasteData,
-					sizeof(maptile_t) );
+				Tiles_SetTile( &mapData->tiles, g_pMapDrawer->m_nTileSelectY * mapData->width + g_pMapDrawer->m_nTileSelectX,
+					(const maptile_t *)g_pEditor->m_pCopyPasteData );
 				g_pMapInfoDlg->m_bMapModified = true;
 				g_pMapInfoDlg->m_bMapNameUpdated = false;
 			}
-			free( g_pEditor->m_pCopyPasteData );
+			FreeMemory( g_pEditor->m_pCopyPasteData, TAG_UI );
+			g_pEditor->m_pCopyPasteData = NULL;
 		}
 		if ( ImGui::IsKeyDown( ImGuiKey_N ) ) {
 			g_pEditor->OnFileNew();
@@ -447,19 +435,21 @@ static void EditMenu( void )
     ImGui::Separator();
     if ( ImGui::MenuItem( "Copy", "Ctrl+C" ) ) {
 		if ( g_pMapDrawer->m_bTileSelectOn ) {
-			g_pEditor->m_pCopyPasteData = CopyMemory( &mapData->tiles[g_pMapDrawer->m_nTileSelectY * mapData->width + g_pMapDrawer->m_nTileSelectX],
-				sizeof(maptile_t) );
+			g_pEditor->m_pCopyPasteData = GetMemory( sizeof(maptile_t), TAG_UI );
+			Tiles_GetTile( &mapData->tiles, g_pMapDrawer->m_nTileSelectY * mapData->width + g_pMapDrawer->m_nTileSelectX,
+				mapData->texcoords, mapData->tileset.numTiles, (maptile_t *)g_pEditor->m_pCopyPasteData );
 			Log_Printf( "Copied tile at %ix%i to editor clipboard.\n" );
 		}
     }
     if ( ImGui::MenuItem( "Paste", "Ctrl+V" ) && g_pEditor->m_pCopyPasteData ) {
 		if ( g_pMapDrawer->m_bTileSelectOn ) {
-			memcpy( &mapData->tiles[g_pMapDrawer->m_nTileSelectY * mapData->width + g_pMapDrawer->m_nTileSelectX], g_pEditor->m_pCopyPasteData,
-				sizeof(maptile_t) );
+			Tiles_SetTile( &mapData->tiles, g_pMapDrawer->m_nTileSelectY * mapData->width + g_pMapDrawer->m_nTileSelectX,
+				(const maptile_t *)g_pEditor->m_pCopyPasteData );
 			g_pMapInfoDlg->m_bMapModified = true;
 			g_pMapInfoDlg->m_bMapNameUpdated = false;
 		}
-		free( g_pEditor->m_pCopyPasteData );
+		FreeMemory( g_pEditor->m_pCopyPasteData, TAG_UI );
+		g_pEditor->m_pCopyPasteData = NULL;
     }
 	ImGui::Separator();
 	if ( ImGui::MenuItem( "Current Tile", "Ctrl-T" ) ) {
@@ -484,9 +474,107 @@ static void ViewMenu( void )
     }
 	ImGui::Checkbox( "Console Window", &s_ConsoleOpen );
 	ImGui::Checkbox( "ImGui Metrics", &g_pEditor->m_bShowImGuiMetricsWindow );
+	ImGui::Checkbox( "Memory Statistics", &g_pEditor->m_bShowMemoryStats );
 	ImGui::Checkbox( "Map Data", &g_pMapInfoDlg->m_bShow );
 }
 
+static void HunkPrintLine( const char *fmt, ... )
+{
+	va_list argptr;
+	char line[256];
+	int length;
+
+	va_start( argptr, fmt );
+	length = vsnprintf( line, sizeof(line), fmt, argptr );
+	va_end( argptr );
+
+	// Hunk_Print ends its lines for the log, ImGui already puts each Text on its own line
+	length = length < (int)sizeof(line) ? length : (int)sizeof(line) - 1;
+	if ( length > 0 && line[length - 1] == '\n' ) {
+		line[length - 1] = '\0';
+	}
+	ImGui::TextUnformatted( line );
+}
+
+static void DrawMemoryStatistics( void )
+{
+	uint64_t lastFrame, peak, capacity;
+	int hunkLow, hunkHigh, hunkSize;
+	memTagStats_t tags[NUM_MEMTAGS];
+	texCacheStats_t texStats;
+	int i;
+
+	if ( !ImGui::Begin( "Memory Statistics", &g_pEditor->m_bShowMemoryStats ) ) {
+		ImGui::End();
+		return;
+	}
+
+	Mem_GetTagStats( tags );
+	ImGui::SeparatorText( "Heap" );
+	if ( ImGui::BeginTable( "##HeapMemoryStats", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp ) ) {
+		ImGui::TableSetupColumn( "Tag" );
+		ImGui::TableSetupColumn( "Current" );
+		ImGui::TableSetupColumn( "Peak" );
+		ImGui::TableSetupColumn( "Blocks" );
+		ImGui::TableSetupColumn( "Allocations" );
+		ImGui::TableHeadersRow();
+
+		for ( i = 0; i < NUM_MEMTAGS; i++ ) {
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted( Mem_TagName( (memtag_t)i ) );
+			ImGui::TableNextColumn();
+			ImGui::Text( "%.2f KiB", (double)tags[i].bytes / 1024.0 );
+			ImGui::TableNextColumn();
+			ImGui::Text( "%.2f KiB", (double)tags[i].peakBytes / 1024.0 );
+			ImGui::TableNextColumn();
+			ImGui::Text( "%li", tags[i].liveBlocks );
+			ImGui::TableNextColumn();
+			ImGui::Text( "%lu", tags[i].totalAllocs );
+		}
+		ImGui::EndTable();
+	}
+	if ( ImGui::Button( "Dump To Log##HeapMemoryStats" ) ) {
+		Mem_PrintTags( Log_Printf );
+	}
+
+	Frame_GetUsage( &lastFrame, &peak, &capacity );
+	ImGui::SeparatorText( "Frame Arena" );
+	ImGui::Text( "Last Frame: %.2f KiB", (double)lastFrame / 1024.0 );
+	ImGui::Text( "Peak: %.2f KiB", (double)peak / 1024.0 );
+	ImGui::Text( "Capacity: %.2f MiB", (double)capacity / ( 1024.0 * 1024.0 ) );
+
+	Hunk_GetUsage( &hunkLow, &hunkHigh, &hunkSize );
+	ImGui::SeparatorText( "Hunk" );
+	ImGui::Text( "Low: %.2f KiB", (double)hunkLow / 1024.0 );
+	ImGui::Text( "High: %.2f KiB", (double)hunkHigh / 1024.0 );
+	ImGui::Text( "Reserved: %.2f MiB", (double)hunkSize / ( 1024.0 * 1024.0 ) );
+	if ( ImGui::Button( "Dump To Log##HunkMemoryStats" ) ) {
+		Hunk_Print( qtrue, Log_Printf );
+	}
+	if ( ImGui::TreeNodeEx( "Allocations##HunkMemoryStats" ) ) {
+		Hunk_Print( qfalse, HunkPrintLine );
+		ImGui::TreePop();
+	}
+
+	ImGui::SeparatorText( "Jobs" );
+	ImGui::Text( "Workers: %i (%i busy)", Job_NumWorkers(), Job_ActiveJobs() );
+	ImGui::Text( "Interactive Queue: %i", Job_QueueDepth( JOB_PRIORITY_INTERACTIVE ) );
+	ImGui::Text( "Background Queue: %i", Job_QueueDepth( JOB_PRIORITY_BACKGROUND ) );
+
+	Tex_GetCacheStats( &texStats );
+	ImGui::SeparatorText( "Texture Cache" );
+	ImGui::Text( "Textures: %u (%u unreferenced, %u loading)", texStats.numTextures, texStats.numUnreferenced, texStats.numLoading );
+	ImGui::Text( "Resident: %.2f MiB / %.2f MiB", (double)texStats.residentBytes / ( 1024.0 * 1024.0 ),
+		(double)texStats.budgetBytes / ( 1024.0 * 1024.0 ) );
+	ImGui::Text( "Unreferenced: %.2f MiB", (double)texStats.unreferencedBytes / ( 1024.0 * 1024.0 ) );
+	ImGui::Text( "Hits: %lu Misses: %lu Evictions: %lu", texStats.hits, texStats.misses, texStats.evictions );
+	ImGui::Text( "Thumbnails: %u resident, %u KiB of atlas", Thumb_NumResident(), Thumb_NumResident() * THUMB_SIZE * THUMB_SIZE * 4 / 1024 );
+	ImGui::Text( "Watched directories: %u", Watch_NumDirectories() );
+
+	ImGui::End();
+}
+
 static void DrawEditor( void )
 {
 	std::unique_lock<std::mutex> lock{ g_ImGuiLock };
@@ -568,6 +656,10 @@ static void DrawEditor( void )
 		ImGui::End();
 		ImGui::PopStyleColor();
 	}
+
+	if ( g_pEditor->m_bShowMemoryStats ) {
+		DrawMemoryStatistics();
+	}
 }
 
 Walnut::Application* Walnut::CreateApplication( int argc, char **argv )
@@ -0,0 +1,239 @@
+#include "editor.h"
+#include <mutex>
+#include <algorithm>
+#include <unordered_map>
+
+typedef struct {
+    std::vector<assetFile_t> files[NUM_ASSET_TYPES];
+} assetIndex_t;
+
+typedef struct {
+    jobGroup_t group;
+    std::mutex lock;
+    assetIndex_t *index;
+} assetScan_t;
+
+// main thread only, the scan jobs only write through their assetScan_t
+static std::unordered_map<std::string, assetIndex_t *> s_AssetIndexes;
+static std::string s_WatchedRoot; // the watcher's root when the indexes were last checked against it
+static int s_nWatchHandle;
+
+static const struct {
+    const char *ext;
+    assetType_t type;
+} s_AssetExtensions[] = {
+    { "png", ASSET_TEXTURE },
+    { "jpg", ASSET_TEXTURE },
+    { "jpeg", ASSET_TEXTURE },
+    { "bmp", ASSET_TEXTURE },
+    { "tga", ASSET_TEXTURE },
+    { "shader", ASSET_SHADER },
+    { "map", ASSET_MAP },
+    { "bmf", ASSET_MAP }
+};
+
+assetType_t Asset_Classify( const char *path )
+{
+    const char *ext = COM_GetExtension( path );
+
+    for ( const auto& it : s_AssetExtensions ) {
+        if ( !N_stricmp( ext, it.ext ) ) {
+            return it.type;
+        }
+    }
+    return ASSET_NONE;
+}
+
+/*
+* Asset_RootKey: the same directory spelt with or without a trailing separator is the same index
+*/
+static std::string Asset_RootKey( const std::filesystem::path& root )
+{
+    std::filesystem::path normal = root.lexically_normal();
+
+    if ( !normal.has_filename() && normal.has_parent_path() ) {
+        normal = normal.parent_path();
+    }
+    return normal.string();
+}
+
+static bool Asset_PathLess( const assetFile_t& a, const std::string& b ) {
+    return a.path < b;
+}
+
+/*
+* Asset_ScanDirectory: lists one directory on a worker and hands each subdirectory to a job of its
+* own, so a wide tree is spread over the whole pool
+*/
+static void Asset_ScanDirectory( assetScan_t *scan, const std::filesystem::path& directory )
+{
+    std::vector<std::pair<assetType_t, assetFile_t>> found;
+    std::error_code error;
+    assetType_t type;
+
+    for ( const auto& it : std::filesystem::directory_iterator{ directory, error } ) {
+        if ( it.is_directory( error ) ) {
+            const std::filesystem::path subdirectory = it.path();
+            Job_Add( &scan->group, JOB_PRIORITY_INTERACTIVE, [scan, subdirectory]( void ) {
+                Asset_ScanDirectory( scan, subdirectory );
+            } );
+            continue;
+        }
+
+        const std::string path = it.path().string();
+        type = Asset_Classify( path.c_str() );
+        if ( type == ASSET_NONE ) {
+            continue;
+        }
+
+        auto& entry = found.emplace_back();
+        entry.first = type;
+        entry.second.path = path;
+        entry.second.fileSize = it.file_size( error );
+        entry.second.modifiedTime = it.last_write_time( error ).time_since_epoch().count();
+    }
+
+    std::lock_guard<std::mutex> lock{ scan->lock };
+    for ( auto& it : found ) {
+        scan->index->files[it.first].emplace_back( std::move( it.second ) );
+    }
+}
+
+static void Asset_Scan( const std::string& root, assetIndex_t *index )
+{
+    assetScan_t scan;
+    uint64_t total;
+
+    for ( auto& it : index->files ) {
+        it.clear();
+    }
+    scan.index = index;
+
+    Job_Add( &scan.group, JOB_PRIORITY_INTERACTIVE, [&scan, &root]( void ) {
+        Asset_ScanDirectory( &scan, root );
+    } );
+    Job_Wait( &scan.group );
+
+    total = 0;
+    for ( auto& it : index->files ) {
+        std::sort( it.begin(), it.end(), []( const assetFile_t& a, const assetFile_t& b ) { return a.path < b.path; } );
+        total += it.size();
+    }
+    Log_Printf( "Indexed %lu assets under '%s' (%lu textures, %lu shaders, %lu maps)\n", total, root.c_str(),
+        index->files[ASSET_TEXTURE].size(), index->files[ASSET_SHADER].size(), index->files[ASSET_MAP].size() );
+}
+
+/*
+* Asset_UpdateFile: applies one settled watcher event to an index
+*/
+static void Asset_UpdateFile( assetIndex_t *index, const watchEvent_t& event )
+{
+    const assetType_t type = Asset_Classify( event.path.c_str() );
+    std::error_code error;
+
+    if ( type == ASSET_NONE ) {
+        return;
+    }
+
+    std::vector<assetFile_t>& files = index->files[type];
+    auto it = std::lower_bound( files.begin(), files.end(), event.path, Asset_PathLess );
+    const bool exists = it != files.end() && it->path == event.path;
+
+    if ( event.flags & WATCH_REMOVED ) {
+        if ( exists ) {
+            files.erase( it );
+        }
+        return;
+    }
+
+    if ( !exists ) {
+        it = files.insert( it, assetFile_t{ event.path, 0, 0 } );
+    }
+    it->fileSize = std::filesystem::file_size( event.path, error );
+    it->modifiedTime = std::filesystem::last_write_time( event.path, error ).time_since_epoch().count();
+}
+
+/*
+* Asset_CheckRoot: only the watcher's root is kept current, an index built while its root wasn't
+* being watched may have missed anything, so they're all dropped once the root moves and rebuilt
+* the next time they're asked for
+*/
+static void Asset_CheckRoot( void )
+{
+    const std::string root = Asset_RootKey( Watch_GetRoot() );
+
+    if ( root == s_WatchedRoot ) {
+        return;
+    }
+    s_WatchedRoot = root;
+
+    for ( auto& it : s_AssetIndexes ) {
+        delete it.second;
+    }
+    s_AssetIndexes.clear();
+}
+
+static void Asset_OnFileChanged( const watchEvent_t& event )
+{
+    Asset_CheckRoot();
+
+    for ( auto& it : s_AssetIndexes ) {
+        const std::string& root = it.first;
+
+        // a rescan after the watcher's queue overflowed names the root itself
+        if ( event.path.compare( 0, root.size(), root )
+            || ( event.path.size() > root.size() && event.path[ root.size() ] != PATH_SEP ) )
+        {
+            continue;
+        }
+        if ( ( event.flags & WATCH_RESCAN ) || event.isDirectory ) {
+            // a whole directory came or went, its contents have no events of their own
+            Asset_Scan( root, it.second );
+        } else {
+            Asset_UpdateFile( it.second, event );
+        }
+    }
+}
+
+const std::vector<assetFile_t>& Asset_GetFiles( const std::filesystem::path& root, assetType_t type )
+{
+    const std::string key = Asset_RootKey( root );
+
+    if ( !s_nWatchHandle ) {
+        s_nWatchHandle = Watch_AddListener( Asset_OnFileChanged );
+    }
+    Asset_CheckRoot();
+
+    auto it = s_AssetIndexes.find( key );
+    if ( it == s_AssetIndexes.end() ) {
+        it = s_AssetIndexes.try_emplace( key, new assetIndex_t ).first;
+        Asset_Scan( key, it->second );
+    }
+    return it->second->files[type];
+}
+
+void Asset_Rescan( const std::filesystem::path& root )
+{
+    const std::string key = Asset_RootKey( root );
+
+    Asset_CheckRoot();
+
+    const auto it = s_AssetIndexes.find( key );
+
+    if ( it != s_AssetIndexes.end() ) {
+        Asset_Scan( key, it->second );
+    }
+}
+
+void Asset_Shutdown( void )
+{
+    if ( s_nWatchHandle ) {
+        Watch_RemoveListener( s_nWatchHandle );
+        s_nWatchHandle = 0;
+    }
+    for ( auto& it : s_AssetIndexes ) {
+        delete it.second;
+    }
+    s_AssetIndexes.clear();
+    s_WatchedRoot.clear();
+}
@@ -0,0 +1,46 @@
+#ifndef __ASSETINDEX__
+#define __ASSETINDEX__
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <filesystem>
+
+/*
+===============================================================
+
+Asset index: every file the editor cares about under a
+project's asset directory, sorted by type. The tree is walked
+once, one job per directory, and kept current from the file
+watcher afterwards, so the asset manager, the shader loader and
+the project's map list all read the same listing instead of
+each walking the disk.
+
+===============================================================
+*/
+
+typedef enum {
+    ASSET_TEXTURE,
+    ASSET_SHADER,
+    ASSET_MAP,
+
+    NUM_ASSET_TYPES,
+    ASSET_NONE = NUM_ASSET_TYPES
+} assetType_t;
+
+typedef struct {
+    std::string path;
+    uint64_t fileSize;
+    int64_t modifiedTime;
+} assetFile_t;
+
+assetType_t Asset_Classify( const char *path );
+
+// files of one type under root sorted by path, root is scanned the first time it's asked for
+const std::vector<assetFile_t>& Asset_GetFiles( const std::filesystem::path& root, assetType_t type );
+void Asset_Rescan( const std::filesystem::path& root );
+void Asset_Shutdown( void );
+
+#endif
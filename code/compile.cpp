@@ -0,0 +1,574 @@
+#include "editor.h"
+#include "compile.h"
+#include "stb_image.h"
+#include <chrono>
+#include <mutex>
+#include <limits.h>
+
+/*
+===============================================================
+
+Level compiler: turns .map files into .bmf levels, either the
+current map from the editor or a whole project from the command
+line with no window
+
+===============================================================
+*/
+
+typedef struct {
+    std::string name;
+    uint64_t mapSize;
+    uint64_t levelSize;
+    uint64_t hash; // of everything that goes into the level
+    uint64_t oldHash; // from the last build
+    double parseMsec;
+    double compileMsec;
+    bool compiled;
+    bool skipped;
+} compileJob_t;
+
+uint64_t LittleLong(uint64_t l)
+{
+#ifdef __BIG_ENDIAN__
+	byte b1, b2, b3, b4, b5, b6, b7;
+
+	b1 = l & 0xff;
+	b2 = (l >> 8) & 0xff;
+	b3 = (l >> 16) & 0xff;
+	b4 = (l >> 24) & 0xff;
+	b5 = (l >> 32) & 0xff;
+	b6 = (l >> 40) & 0xff;
+	b7 = (l >> 48) & 0xff;
+
+	return ((uint64_t)b1<<48) + ((uint64_t)b2<<40) + ((uint64_t)b3<<32) + ((uint64_t)b4<<24) + ((uint64_t)b5<<16) + ((uint64_t)b6<<8) + b7;
+#else
+	return l;
+#endif
+}
+
+static void AddLump( const void *data, uint64_t size, mapheader_t *header, int lumpnum, FileStream *file )
+{
+    lump_t *lump;
+    char *compressed;
+    uint64_t compressedLength;
+    uint32_t numBlocks;
+    const char *error;
+
+    lump = &header->lumps[lumpnum];
+    lump->length = LittleLong( size );
+    lump->fileofs = LittleLong( file->GetPosition() );
+    lump->compressedLength = lump->length;
+    lump->compression = COMPRESS_NONE;
+    lump->numBlocks = 0;
+
+    if ( size == 0 ) {
+        return;
+    }
+
+    // large lumps are compressed block by block so the game can stream them back in
+    if ( parm_compression != COMPRESS_NONE && size >= COMPRESSED_LUMP_SIZE ) {
+        compressed = CompressBlocks( data, size, LUMP_BLOCK_SIZE, parm_compression, &compressedLength, &numBlocks, &error );
+        if ( compressed ) {
+            lump->compressedLength = LittleLong( compressedLength );
+            lump->compression = parm_compression;
+            lump->numBlocks = numBlocks;
+
+            file->Write( compressed, compressedLength );
+            FreeMemory( compressed );
+            return;
+        }
+        if ( error ) {
+            Log_FPrintf( SYS_WRN, "WARNING: failed to compress lump %i, storing it raw: %s\n", lumpnum, error );
+        } else {
+            Log_Printf( "Lump %i didn't compress, storing it raw.\n", lumpnum );
+        }
+    }
+
+    file->Write( data, size );
+}
+
+static const char *GetAbsolutePath( const char *filename )
+{
+    if ( !strrchr( filename, PATH_SEP ) ) {
+        return filename;
+    }
+    const char *dir;
+
+    dir = strrchr( filename, PATH_SEP );
+    return dir ? dir + 1 : filename;
+}
+
+/*
+* StageAlloc: compile staging comes off the high hunk when this thread owns it, so it all goes
+* away with one Hunk_FreeToHighMark. The headless compiler's workers and anything too big for
+* what's left of the hunk get the heap instead, onHunk says which one it was.
+*/
+static void *StageAlloc( uint64_t size, const char *name, bool *onHunk )
+{
+    void *buf;
+
+    *onHunk = false;
+    if ( Hunk_Available() && size <= Hunk_MemoryRemaining() ) {
+        buf = Hunk_HighAllocName( (int)size, name );
+        if ( buf ) {
+            *onHunk = true;
+            return buf;
+        }
+    }
+    return GetMemory( size );
+}
+
+static void StageFree( void *buf, bool onHunk )
+{
+    if ( !onHunk ) {
+        FreeMemory( buf );
+    }
+}
+
+/*
+* Map_CompileLevel: writes data out as a .bmf level, doesn't touch any editor state
+*/
+bool Map_CompileLevel( const mapData_t *data, const char *path, uint64_t *levelSize )
+{
+	bmf_t bmf;
+	FileStream file;
+	maptile_t *tiles;
+	mapEntities_t *ents;
+	uint64_t numTiles;
+	bool tilesOnHunk, entsOnHunk;
+	int mark;
+
+	if ( !file.Open( path, "wb" ) ) {
+		Log_FPrintf( SYS_WRN, "Map_CompileLevel: failed to create .bmf file '%s'\n", path );
+		return false;
+	}
+
+	memset( &bmf, 0, sizeof(bmf) );
+	bmf.ident = LEVEL_IDENT;
+    bmf.version = LEVEL_VERSION;
+    bmf.map.ident = MAP_IDENT;
+    bmf.map.version = MAP_VERSION;
+    bmf.tileset.magic = TILE2D_MAGIC;
+    bmf.tileset.version = TILE2D_VERSION;
+
+    bmf.map.mapWidth = data->width;
+    bmf.map.mapHeight = data->height;
+    VectorCopy( bmf.map.ambientLightColor, data->ambientColor );
+
+    memcpy( &bmf.tileset.info, &data->tileset, sizeof( data->tileset ) );
+    N_strncpyz( bmf.tileset.info.texture, GetAbsolutePath( bmf.tileset.info.texture ), sizeof( bmf.tileset.info.texture ) );
+
+	// overwritten later
+    file.Write( &bmf.ident, sizeof( bmf.ident ) );
+    file.Write( &bmf.version, sizeof( bmf.version ) );
+    file.Write( &bmf.map, sizeof( bmf.map ) );
+    file.Write( &bmf.tileset, sizeof( bmf.tileset ) );
+
+    mark = Hunk_Available() ? Hunk_HighMark() : 0;
+
+    // the level format still wants whole tiles
+    tiles = (maptile_t *)StageAlloc( sizeof(*tiles) * ( data->numTiles ? data->numTiles : 1 ), "bmftiles", &tilesOnHunk );
+    numTiles = Tiles_ToMapTiles( &data->tiles, data->numTiles, data->texcoords, data->texcoords ? data->tileset.numTiles : 0, tiles );
+    AddLump( tiles, sizeof(maptile_t) * numTiles, &bmf.map, LUMP_TILES, &file );
+    StageFree( tiles, tilesOnHunk );
+
+    ents = (mapEntities_t *)StageAlloc( sizeof(*ents), "bmfents", &entsOnHunk );
+    Map_PackEntities( data, ents );
+    AddLump( ents->checkpoints, sizeof(mapcheckpoint_t) * ents->numCheckpoints, &bmf.map, LUMP_CHECKPOINTS, &file );
+    AddLump( ents->spawns, sizeof(mapspawn_t) * ents->numSpawns, &bmf.map, LUMP_SPAWNS, &file );
+    AddLump( ents->lights, sizeof(maplight_t) * ents->numLights, &bmf.map, LUMP_LIGHTS, &file );
+    AddLump( data->texcoords, sizeof(spriteCoord_t) * data->tileset.numTiles, &bmf.map, LUMP_SPRITES, &file );
+	AddLump( ents->secrets, sizeof( mapsecret_t ) * ents->numSecrets, &bmf.map, LUMP_SECRETS, &file );
+	StageFree( ents, entsOnHunk );
+
+	if ( Hunk_Available() ) {
+		Hunk_FreeToHighMark( mark );
+	}
+
+	if ( levelSize ) {
+		*levelSize = file.GetPosition();
+	}
+
+	file.Seek( 0, SEEK_SET );
+
+    file.Write( &bmf.ident, sizeof( bmf.ident ) );
+    file.Write( &bmf.version, sizeof( bmf.version ) );
+    file.Write( &bmf.map, sizeof( bmf.map ) );
+    file.Write( &bmf.tileset, sizeof( bmf.tileset ) );
+
+	file.Close();
+
+	return true;
+}
+
+static double MsecSince( const std::chrono::steady_clock::time_point& start )
+{
+	return std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+}
+
+static const char *TexturePath( const char *name, const std::string& assetDir )
+{
+	if ( FileExists( name ) ) {
+		return name;
+	}
+	return va( "%s%c%s", assetDir.c_str(), PATH_SEP, name );
+}
+
+static bool GetTextureSize( const char *name, const std::string& assetDir, int *width, int *height )
+{
+	int channels;
+
+	return stbi_info( TexturePath( name, assetDir ), width, height, &channels );
+}
+
+/*
+===============================================================
+
+Incremental builds: Config/levelcache.json remembers the content
+hash of every compiled map's inputs, maps whose hash didn't change
+since the last build are skipped
+
+===============================================================
+*/
+
+#define LEVELCACHE_VERSION 1
+
+typedef struct {
+	int64_t size;
+	int64_t mtime;
+	uint64_t hash;
+} textureHash_t;
+
+typedef struct {
+	std::unordered_map<std::string, uint64_t> maps;
+	std::unordered_map<std::string, textureHash_t> textures;
+	std::mutex textureLock;
+} levelCache_t;
+
+static const char *s_szTextureKeys[] = { "diffuseMap", "specularMap", "normalMap", "lightMap", "shadowMap" };
+
+static void LoadLevelCache( const char *path, levelCache_t *cache )
+{
+	json data;
+
+	std::ifstream file( path, std::ios::in );
+	if ( !file.is_open() ) {
+		return;
+	}
+
+	try {
+		data = json::parse( file );
+		if ( data.at( "version" ).get<int>() != LEVELCACHE_VERSION || data.at( "levelVersion" ).get<int>() != LEVEL_VERSION ) {
+			Log_Printf( "Level cache '%s' is out of date, rebuilding everything.\n", path );
+			return;
+		}
+		for ( const auto& it : data.at( "maps" ).items() ) {
+			cache->maps[ it.key() ] = it.value().get<uint64_t>();
+		}
+		for ( const auto& it : data.at( "textures" ).items() ) {
+			textureHash_t& tex = cache->textures[ it.key() ];
+			tex.size = it.value().at( "size" );
+			tex.mtime = it.value().at( "mtime" );
+			tex.hash = it.value().at( "hash" );
+		}
+	} catch ( const json::exception& e ) {
+		Log_FPrintf( SYS_WRN, "WARNING: failed to load level cache '%s', what: %s\n", path, e.what() );
+		cache->maps.clear();
+		cache->textures.clear();
+	}
+}
+
+static void SaveLevelCache( const char *path, const levelCache_t *cache )
+{
+	json data;
+	std::string tmpPath;
+
+	data["version"] = LEVELCACHE_VERSION;
+	data["levelVersion"] = LEVEL_VERSION;
+	data["maps"] = json::object();
+	data["textures"] = json::object();
+	for ( const auto& it : cache->maps ) {
+		data["maps"][ it.first ] = it.second;
+	}
+	for ( const auto& it : cache->textures ) {
+		data["textures"][ it.first ] = { { "size", it.second.size }, { "mtime", it.second.mtime }, { "hash", it.second.hash } };
+	}
+
+	// write next to it and rename so an interrupted build can't leave a torn manifest
+	tmpPath = std::string( path ) + ".tmp";
+	{
+		std::ofstream file( tmpPath, std::ios::out | std::ios::trunc );
+		if ( !file.is_open() ) {
+			Log_FPrintf( SYS_WRN, "WARNING: failed to write level cache '%s'\n", tmpPath.c_str() );
+			return;
+		}
+		file.width( 4 );
+		file << data;
+	}
+	if ( rename( tmpPath.c_str(), path ) == -1 ) {
+		Log_FPrintf( SYS_WRN, "WARNING: failed to replace level cache '%s'\n", path );
+	}
+}
+
+/*
+* HashTexture: textures are only reread when their size or modification time changed
+*/
+static uint64_t HashTexture( const char *path, levelCache_t *cache )
+{
+	std::error_code err;
+	textureHash_t tex;
+	void *buffer;
+	uint64_t length;
+
+	tex.size = std::filesystem::file_size( path, err );
+	if ( err ) {
+		return 0;
+	}
+	tex.mtime = std::filesystem::last_write_time( path, err ).time_since_epoch().count();
+
+	{
+		std::lock_guard<std::mutex> lock( cache->textureLock );
+		auto it = cache->textures.find( path );
+		if ( it != cache->textures.end() && it->second.size == tex.size && it->second.mtime == tex.mtime ) {
+			return it->second.hash;
+		}
+	}
+
+	length = LoadFile( path, &buffer );
+	if ( !buffer ) {
+		return 0;
+	}
+	tex.hash = Com_HashBuffer( buffer, length, 0 );
+	FreeMemory( buffer );
+
+	std::lock_guard<std::mutex> lock( cache->textureLock );
+	cache->textures[ path ] = tex;
+
+	return tex.hash;
+}
+
+/*
+* HashMapInputs: hashes the map text (which holds the tileset settings), every texture it
+* references and the options that change the output. The texture keys are tokenized the same
+* way the map loader reads them, and each texture's hash is chained on in key order.
+*/
+static uint64_t HashMapInputs( const char *name, const char *text, uint64_t length, const std::string& assetDir, levelCache_t *cache )
+{
+	char textures[arraylen( s_szTextureKeys )][MAX_NPATH];
+	uint64_t hash, textureHash;
+	const char *p, *tok;
+	uint32_t i;
+
+	hash = Com_HashBuffer( text, length, 0 );
+	hash = Com_HashBuffer( &parm_compression, sizeof(parm_compression), hash );
+
+	memset( textures, 0, sizeof(textures) );
+
+	COM_BeginParseSession( name );
+	p = text;
+	while ( 1 ) {
+		tok = COM_ParseExt( &p, qtrue );
+		if ( !tok[0] ) {
+			break;
+		}
+		for ( i = 0; i < arraylen( s_szTextureKeys ); i++ ) {
+			if ( !N_stricmp( tok, s_szTextureKeys[i] ) ) {
+				break;
+			}
+		}
+		if ( i == arraylen( s_szTextureKeys ) ) {
+			continue;
+		}
+
+		// like the loader, a later key replaces an earlier one and a blank name is no texture
+		tok = COM_ParseExt( &p, qfalse );
+		if ( !tok[0] || tok[0] == ' ' ) {
+			continue;
+		}
+		N_strncpyz( textures[i], tok, sizeof(textures[i]) );
+	}
+
+	for ( i = 0; i < arraylen( s_szTextureKeys ); i++ ) {
+		if ( !textures[i][0] ) {
+			continue;
+		}
+		textureHash = HashTexture( TexturePath( textures[i], assetDir ), cache );
+		hash = Com_HashBuffer( s_szTextureKeys[i], strlen( s_szTextureKeys[i] ), hash );
+		hash = Com_HashBuffer( textures[i], strlen( textures[i] ), hash );
+		hash = Com_HashBuffer( &textureHash, sizeof(textureHash), hash );
+	}
+
+	return hash;
+}
+
+static void CompileMapFile( compileJob_t *job, const std::string& mapDir, const std::string& levelDir, const std::string& assetDir,
+	levelCache_t *cache, bool force )
+{
+	union {
+		void *v;
+		char *b;
+	} f;
+	char levelName[MAX_OSPATH];
+	const char *diffuseMap, *levelPath;
+	mapData_t *data;
+	int width, height;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	job->mapSize = LoadFile( va( "%s%c%s", mapDir.c_str(), PATH_SEP, job->name.c_str() ), &f.v );
+	if ( !f.v ) {
+		job->mapSize = 0;
+		return;
+	}
+
+	COM_StripExtension( job->name.c_str(), levelName, sizeof(levelName) );
+	levelPath = va( "%s%c%s" LEVEL_FILE_EXT, levelDir.c_str(), PATH_SEP, levelName );
+
+	job->hash = HashMapInputs( job->name.c_str(), f.b, job->mapSize, assetDir, cache );
+	if ( !force && job->hash == job->oldHash && FileExists( levelPath ) ) {
+		std::error_code err;
+
+		job->levelSize = std::filesystem::file_size( levelPath, err );
+		job->skipped = true;
+		job->compiled = true;
+		FreeMemory( f.v );
+		return;
+	}
+
+	data = (mapData_t *)GetMemory( sizeof(*data) );
+	if ( !Map_ParseFile( f.b, job->name.c_str(), data, false ) ) {
+		Log_FPrintf( SYS_WRN, "WARNING: failed to parse map '%s'\n", job->name.c_str() );
+		goto done;
+	}
+
+	diffuseMap = data->textureNames[Walnut::TB_DIFFUSEMAP];
+	if ( !diffuseMap[0] || !GetTextureSize( diffuseMap, assetDir, &width, &height )
+		|| !Map_BuildTilesetData( data, width, height ) )
+	{
+		Log_FPrintf( SYS_WRN, "WARNING: map '%s' has no usable tileset, its sprite lump will be empty\n", job->name.c_str() );
+		data->tileset.numTiles = 0;
+	}
+	job->parseMsec = MsecSince( start );
+
+	start = std::chrono::steady_clock::now();
+	job->compiled = Map_CompileLevel( data, levelPath, &job->levelSize );
+	job->compileMsec = MsecSince( start );
+
+done:
+	Map_FreeTiles( data );
+	FreeMemory( data->texcoords, TAG_MAP );
+	FreeMemory( data );
+	FreeMemory( f.v );
+}
+
+static std::string GetProjectAssetDirectory( const char *projectDir )
+{
+	json data;
+	std::string assetDir;
+
+	std::ifstream file( va( "%s%cConfig%cconfig.json", projectDir, PATH_SEP, PATH_SEP ), std::ios::in );
+	if ( file.is_open() ) {
+		try {
+			data = json::parse( file );
+			assetDir = data.at( "assetdirectory" ).get<std::string>();
+		} catch ( const json::exception& e ) {
+			Log_FPrintf( SYS_WRN, "WARNING: bad project config in '%s', what: %s\n", projectDir, e.what() );
+		}
+	}
+
+	if ( assetDir.size() && assetDir.front() == PATH_SEP && FolderExists( assetDir.c_str() ) ) {
+		return assetDir;
+	}
+	if ( assetDir.size() ) {
+		return va( "%s%c%s", projectDir, PATH_SEP, assetDir.c_str() );
+	}
+	return va( "%s%cAssets", projectDir, PATH_SEP );
+}
+
+bool Map_CompileProject( const char *projectDir )
+{
+	std::vector<compileJob_t> jobs;
+	std::string assetDir, mapDir, levelDir, cachePath;
+	uint64_t numCompiled, numSkipped, totalMapSize, totalLevelSize;
+	levelCache_t cache;
+	bool force;
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	assetDir = GetProjectAssetDirectory( projectDir );
+	mapDir = assetDir + PATH_SEP + "maps";
+	levelDir = assetDir + PATH_SEP + "levels";
+	cachePath = va( "%s%cConfig%clevelcache.json", projectDir, PATH_SEP, PATH_SEP );
+	force = CheckParm( "-forcecompile" ) != -1;
+
+	if ( !FolderExists( mapDir.c_str() ) ) {
+		Log_FPrintf( SYS_ERR, "ERROR: project map directory '%s' doesn't exist\n", mapDir.c_str() );
+		return false;
+	}
+	if ( !Q_mkdir( levelDir.c_str() ) ) {
+		Log_FPrintf( SYS_ERR, "ERROR: failed to create level directory '%s'\n", levelDir.c_str() );
+		return false;
+	}
+
+	if ( !force ) {
+		LoadLevelCache( cachePath.c_str(), &cache );
+	}
+
+	try {
+		for ( const auto& it : std::filesystem::directory_iterator{ mapDir } ) {
+			if ( it.is_regular_file() && !N_stricmp( COM_GetExtension( it.path().c_str() ), MAP_FILE_EXT_RAW ) ) {
+				compileJob_t& job = jobs.emplace_back();
+				job.name = it.path().filename().string();
+				job.mapSize = job.levelSize = 0;
+				job.parseMsec = job.compileMsec = 0.0f;
+				job.compiled = job.skipped = false;
+				job.hash = 0;
+
+				auto old = cache.maps.find( job.name );
+				job.oldHash = old != cache.maps.end() ? old->second : 0;
+			}
+		}
+	} catch ( const std::filesystem::filesystem_error& e ) {
+		Log_FPrintf( SYS_ERR, "ERROR: failed to scan '%s', what: %s\n", mapDir.c_str(), e.what() );
+		return false;
+	}
+
+	std::sort( jobs.begin(), jobs.end(), []( const compileJob_t& a, const compileJob_t& b ) { return a.name < b.name; } );
+
+	// the calling thread works through the batch alongside the pool's workers
+	Log_Printf( "Compiling %lu maps from '%s' to '%s' on %i threads...\n", jobs.size(), mapDir.c_str(), levelDir.c_str(),
+		Job_NumWorkers() + 1 );
+
+	Sys_ParallelFor( jobs.size(), [&]( uint64_t i ) {
+		CompileMapFile( &jobs[i], mapDir, levelDir, assetDir, &cache, force );
+	} );
+
+	numCompiled = numSkipped = totalMapSize = totalLevelSize = 0;
+
+	// maps that were deleted or failed drop out of the cache
+	cache.maps.clear();
+
+	Log_Printf( "\n%-32s %12s %12s %10s %10s\n", "map", "map bytes", "level bytes", "parse ms", "write ms" );
+	for ( const auto& it : jobs ) {
+		if ( !it.compiled ) {
+			Log_Printf( "%-32s %12lu %12s %10s %10s\n", it.name.c_str(), it.mapSize, "FAILED", "-", "-" );
+			continue;
+		}
+		cache.maps[ it.name ] = it.hash;
+		totalMapSize += it.mapSize;
+		totalLevelSize += it.levelSize;
+		if ( it.skipped ) {
+			Log_Printf( "%-32s %12lu %12lu %21s\n", it.name.c_str(), it.mapSize, it.levelSize, "up to date" );
+			numSkipped++;
+			continue;
+		}
+		Log_Printf( "%-32s %12lu %12lu %10.2f %10.2f\n", it.name.c_str(), it.mapSize, it.levelSize, it.parseMsec, it.compileMsec );
+		numCompiled++;
+	}
+	Log_Printf( "%lu compiled, %lu up to date, %lu failed, %lu -> %lu bytes in %.2f ms\n", numCompiled, numSkipped,
+		jobs.size() - numCompiled - numSkipped, totalMapSize, totalLevelSize, MsecSince( start ) );
+
+	SaveLevelCache( cachePath.c_str(), &cache );
+
+	return numCompiled + numSkipped == jobs.size();
+}
@@ -0,0 +1,13 @@
+#ifndef __COMPILE__
+#define __COMPILE__
+
+#pragma once
+
+uint64_t LittleLong( uint64_t l );
+
+bool Map_CompileLevel( const mapData_t *data, const char *path, uint64_t *levelSize );
+
+// headless batch compile of every map in <projectDir>/<assets>/maps to <assets>/levels
+bool Map_CompileProject( const char *projectDir );
+
+#endif
@@ -17,6 +17,7 @@ CEditorLayer::~CEditorLayer()
 void CEditorLayer::OnDetach( void )
 {
     Map_Free();
+    Map_Shutdown();
 //    delete g_pProjectManager;
 //    delete g_pConfirmModifiedDlg;
 //    delete g_pPrefsDlg;
@@ -14,7 +14,15 @@
 #include "stream.h"
 #include "Walnut/Image.h"
 #include "shader.h"
+#include "jobs.h"
+#include "texture.h"
+#include "thumbnails.h"
+#include "filewatch.h"
+#include "assetindex.h"
+#include "tiles.h"
+#include "slotmap.h"
 #include "map.h"
+#include "compile.h"
 #include "ImGuiTextEditor.h"
 #include "command.h"
 #include "ContentBrowserPanel.h"
@@ -122,6 +130,7 @@ public:
     
     bool m_bShowConsole;
     bool m_bShowImGuiMetricsWindow;
+    bool m_bShowMemoryStats;
     bool m_bShowTilesetData;
     bool m_bShowShaders;
     bool m_bShowInUseTextures;
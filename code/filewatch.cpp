@@ -0,0 +1,299 @@
+#include "editor.h"
+#include <chrono>
+#include <unordered_map>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#define WATCH_SETTLE_MSEC 100 // how long a path has to be quiet before its events go out
+
+typedef struct {
+    int flags;
+    bool isDirectory;
+    std::chrono::steady_clock::time_point lastEvent;
+} pendingEvent_t;
+
+static std::filesystem::path s_Root;
+static std::unordered_map<std::string, pendingEvent_t> s_Pending;
+static std::vector<std::pair<int, watchFunc_t>> s_Listeners;
+static int s_nNextListener;
+
+#ifdef __linux__
+
+#define WATCH_MASK ( IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR )
+
+static int s_nWatchFd = -1;
+static std::unordered_map<int, std::string> s_WatchDirs; // inotify watch descriptor to the directory it watches
+
+static void Watch_Queue( const std::string& path, int flags, bool isDirectory )
+{
+    pendingEvent_t& event = s_Pending[path];
+
+    event.flags |= flags;
+    event.isDirectory = isDirectory;
+    event.lastEvent = std::chrono::steady_clock::now();
+}
+
+/*
+* Watch_AddDirectory: inotify isn't recursive, every directory below the root gets its own watch.
+* Files found in a directory that only just appeared are reported as created, they may have been
+* written before the watch was in place.
+*/
+static void Watch_AddDirectory( const std::filesystem::path& directory, bool reportContents )
+{
+    std::error_code error;
+    int wd;
+
+    wd = inotify_add_watch( s_nWatchFd, directory.c_str(), WATCH_MASK );
+    if ( wd == -1 ) {
+        Log_FPrintf( SYS_WRN, "WARNING: failed to watch directory '%s', %s\n", directory.c_str(), strerror( errno ) );
+        return;
+    }
+    s_WatchDirs[wd] = directory.string();
+
+    for ( const auto& it : std::filesystem::directory_iterator{ directory, error } ) {
+        if ( it.is_directory( error ) ) {
+            Watch_AddDirectory( it.path(), reportContents );
+        } else if ( reportContents ) {
+            Watch_Queue( it.path().string(), WATCH_CREATED, false );
+        }
+    }
+}
+
+static void Watch_RemoveDirectory( const std::string& directory )
+{
+    for ( auto it = s_WatchDirs.begin(); it != s_WatchDirs.end(); ) {
+        if ( it->second == directory || ( it->second.size() > directory.size() && it->second[ directory.size() ] == PATH_SEP
+            && !it->second.compare( 0, directory.size(), directory ) ) )
+        {
+            inotify_rm_watch( s_nWatchFd, it->first );
+            it = s_WatchDirs.erase( it );
+        } else {
+            ++it;
+        }
+    }
+}
+
+static void Watch_RemoveAll( void )
+{
+    for ( const auto& it : s_WatchDirs ) {
+        inotify_rm_watch( s_nWatchFd, it.first );
+    }
+    s_WatchDirs.clear();
+}
+
+void Watch_Init( void )
+{
+    if ( s_nWatchFd != -1 ) {
+        return;
+    }
+
+    s_nWatchFd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+    if ( s_nWatchFd == -1 ) {
+        Log_FPrintf( SYS_WRN, "WARNING: inotify_init1 failed, %s. Changes made outside the editor won't be picked up.\n",
+            strerror( errno ) );
+        return;
+    }
+    if ( !s_Root.empty() ) {
+        Watch_AddDirectory( s_Root, false );
+    }
+}
+
+void Watch_Shutdown( void )
+{
+    if ( s_nWatchFd == -1 ) {
+        return;
+    }
+    Watch_RemoveAll();
+    close( s_nWatchFd );
+    s_nWatchFd = -1;
+    s_Pending.clear();
+}
+
+void Watch_SetRoot( const std::filesystem::path& root )
+{
+    std::filesystem::path normal = root.lexically_normal();
+
+    // no trailing separator, every path handed out is built by appending to a watched directory
+    if ( !normal.has_filename() && normal.has_parent_path() ) {
+        normal = normal.parent_path();
+    }
+    if ( normal == s_Root ) {
+        return;
+    }
+    s_Root = normal;
+    s_Pending.clear();
+
+    if ( s_nWatchFd == -1 ) {
+        return;
+    }
+    Watch_RemoveAll();
+    Watch_AddDirectory( s_Root, false );
+    Log_Printf( "Watching %lu directories under '%s'\n", s_WatchDirs.size(), s_Root.c_str() );
+}
+
+/*
+* Watch_ReadEvents: drains the inotify queue without blocking
+*/
+static void Watch_ReadEvents( void )
+{
+    alignas(struct inotify_event) char buffer[16384];
+    const struct inotify_event *event;
+    ssize_t length;
+    int flags;
+
+    while ( ( length = read( s_nWatchFd, buffer, sizeof(buffer) ) ) > 0 ) {
+        for ( const char *p = buffer; p < buffer + length; p += sizeof(*event) + event->len ) {
+            event = (const struct inotify_event *)p;
+
+            if ( event->mask & IN_Q_OVERFLOW ) {
+                Log_FPrintf( SYS_WRN, "WARNING: file watcher queue overflowed, rescanning '%s'\n", s_Root.c_str() );
+                Watch_Queue( s_Root.string(), WATCH_RESCAN, true );
+                continue;
+            }
+
+            const auto dir = s_WatchDirs.find( event->wd );
+            if ( dir == s_WatchDirs.end() ) {
+                continue;
+            }
+            if ( event->mask & IN_IGNORED ) {
+                // the directory itself went away, its parent reports the removal
+                s_WatchDirs.erase( dir );
+                continue;
+            }
+            if ( !event->len ) {
+                continue;
+            }
+
+            const std::string path = dir->second + PATH_SEP + event->name;
+            const bool isDirectory = event->mask & IN_ISDIR;
+
+            flags = 0;
+            if ( event->mask & ( IN_CREATE | IN_MOVED_TO ) ) {
+                flags |= WATCH_CREATED;
+                if ( isDirectory ) {
+                    Watch_AddDirectory( path, true );
+                }
+            }
+            if ( event->mask & ( IN_DELETE | IN_MOVED_FROM ) ) {
+                flags |= WATCH_REMOVED;
+                if ( isDirectory && ( event->mask & IN_MOVED_FROM ) ) {
+                    // moved somewhere else, possibly out of the project, its watches would report the old paths
+                    Watch_RemoveDirectory( path );
+                }
+            }
+            if ( event->mask & IN_CLOSE_WRITE ) {
+                flags |= WATCH_MODIFIED;
+            }
+            if ( flags ) {
+                Watch_Queue( path, flags, isDirectory );
+            }
+        }
+    }
+}
+
+bool Watch_IsActive( void ) {
+    return s_nWatchFd != -1;
+}
+
+uint32_t Watch_NumDirectories( void ) {
+    return s_WatchDirs.size();
+}
+
+#else
+
+void Watch_Init( void ) {
+    Log_Printf( "File watching isn't supported on this platform, changes made outside the editor won't be picked up.\n" );
+}
+
+void Watch_Shutdown( void ) {
+}
+
+void Watch_SetRoot( const std::filesystem::path& root ) {
+    s_Root = root;
+}
+
+static void Watch_ReadEvents( void ) {
+}
+
+bool Watch_IsActive( void ) {
+    return false;
+}
+
+uint32_t Watch_NumDirectories( void ) {
+    return 0;
+}
+
+#endif
+
+const std::filesystem::path& Watch_GetRoot( void ) {
+    return s_Root;
+}
+
+/*
+* Watch_Poll: called once a frame by the application, hands the events of every path that has
+* settled to the listeners
+*/
+void Watch_Poll( void )
+{
+    std::vector<watchEvent_t> ready;
+    std::error_code error;
+
+    if ( !Watch_IsActive() ) {
+        return;
+    }
+    Watch_ReadEvents();
+    if ( s_Pending.empty() ) {
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    for ( auto it = s_Pending.begin(); it != s_Pending.end(); ) {
+        if ( now - it->second.lastEvent < std::chrono::milliseconds( WATCH_SETTLE_MSEC ) ) {
+            ++it;
+            continue;
+        }
+
+        watchEvent_t& event = ready.emplace_back();
+        event.path = it->first;
+        event.flags = it->second.flags;
+        event.isDirectory = it->second.isDirectory;
+
+        // a save through a temporary file shows up as the target being replaced, a temporary
+        // file that came and went within the burst is nobody's business
+        if ( ( event.flags & ( WATCH_CREATED | WATCH_REMOVED ) ) == ( WATCH_CREATED | WATCH_REMOVED ) ) {
+            if ( std::filesystem::exists( event.path, error ) ) {
+                event.flags = ( event.flags & ~WATCH_REMOVED ) | WATCH_MODIFIED;
+            } else {
+                ready.pop_back();
+            }
+        }
+        it = s_Pending.erase( it );
+    }
+
+    // a listener may add or remove listeners
+    const std::vector<std::pair<int, watchFunc_t>> listeners = s_Listeners;
+    for ( const auto& event : ready ) {
+        for ( const auto& it : listeners ) {
+            it.second( event );
+        }
+    }
+}
+
+int Watch_AddListener( watchFunc_t func )
+{
+    s_Listeners.emplace_back( ++s_nNextListener, std::move( func ) );
+    return s_nNextListener;
+}
+
+void Watch_RemoveListener( int handle )
+{
+    for ( auto it = s_Listeners.begin(); it != s_Listeners.end(); ++it ) {
+        if ( it->first == handle ) {
+            s_Listeners.erase( it );
+            return;
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef __FILEWATCH__
+#define __FILEWATCH__
+
+#pragma once
+
+#include <string>
+#include <functional>
+#include <filesystem>
+
+/*
+===============================================================
+
+File watcher: follows everything under the current project's
+asset directory and tells the editor's caches what changed on
+disk. Bursts of events for one path, like an external tool
+saving through a temporary file, are folded into one event
+once the path has been quiet for a moment.
+
+===============================================================
+*/
+
+enum {
+    WATCH_CREATED   = 0x1, // new, or replaced by a rename, either way the contents are new
+    WATCH_MODIFIED  = 0x2,
+    WATCH_REMOVED   = 0x4,
+    WATCH_RESCAN    = 0x8 // events were lost, anything under path may have changed
+};
+
+typedef struct {
+    std::string path;
+    int flags;
+    bool isDirectory;
+} watchEvent_t;
+
+typedef std::function<void( const watchEvent_t& )> watchFunc_t;
+
+void Watch_Init( void );
+void Watch_Shutdown( void );
+void Watch_SetRoot( const std::filesystem::path& root );
+const std::filesystem::path& Watch_GetRoot( void );
+void Watch_Poll( void );
+
+int Watch_AddListener( watchFunc_t func );
+void Watch_RemoveListener( int handle );
+
+// false when the platform has no watcher, callers fall back to checking for themselves
+bool Watch_IsActive( void );
+uint32_t Watch_NumDirectories( void );
+
+#endif
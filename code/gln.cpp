@@ -25,6 +25,10 @@
 
 #include <bzlib.h>
 #include <zlib.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <filesystem>
 #endif
 
 #ifndef BFF_TOOL
@@ -130,8 +134,8 @@ static void do_backtrace( void )
 const char *va( const char *fmt, ... )
 {
 	va_list argptr;
-	static char string[8][MAX_VA_BUFFER];
-    static int index = 0;
+	static thread_local char string[8][MAX_VA_BUFFER];
+    static thread_local int index = 0;
 	char *buf;
 
 	buf = string[ index % 8 ];
@@ -222,30 +226,22 @@ void SafeRead( void *data, uint64_t size, IDataStream *stream )
 	}
 }
 
-bff_t *bffOpenRead( const char *path )
+static bff_t *bffOpenReadLegacy( const char *path )
 {
 	FileStream file;
 	bff_t *bff;
 
-	Log_Printf( "Loading BFF archive file '%s' in read mode...\n", path );
-
 	if ( !file.Open( path, "rb" ) ) {
 		Sys_MessageBox( "BFF Tool", va( "Failed to open BFF archive file '%s' in read mode", path ), MB_OK );
 		return NULL;
 	}
 
-	if ( file.GetLength() < sizeof(bff->header) ) {
-		Sys_MessageBox( "BFF Tool", va( "BFF archive file '%s' isn't large enough to contain a header", path ), MB_OK );
-		return NULL;
-	}
-
 	bff = (bff_t *)GetMemory( sizeof(*bff) );
 
 	SafeRead( &bff->header, sizeof(bff->header), &file );
 
 	bff->chunkList = (bff_chunk_t *)GetMemory( sizeof(*bff->chunkList) * bff->header.numChunks );
 	bff->numChunks = bff->header.numChunks;
-	memcpy( &bff->header, &bff->header, sizeof(bff->header) );
 
 	SafeRead( bff->bffGamename, sizeof(bff->bffGamename), &file );
 
@@ -276,187 +272,588 @@ bff_t *bffOpenRead( const char *path )
 
 	file.Close();
 
-	Log_Printf( "Done.\n" );
+	return bff;
+}
+
+/*
+* bffCheckIndex: the table of contents, hash table and names have to fit in the file, and the
+* hash table needs at least one free slot or looking up a missing name never ends. Checked one
+* block at a time against what's left of the file so nothing can overflow.
+*/
+static bool bffCheckIndex( const bffheader_t *header, const bffindex_t *index, uint64_t mappingSize )
+{
+	uint64_t left;
+
+	if ( header->numChunks < 0 || index->tocOffset < 0 || index->namesSize < 1 ) {
+		return false;
+	}
+	if ( index->hashTableSize <= 0 || index->hashTableSize <= header->numChunks
+		|| ( index->hashTableSize & ( index->hashTableSize - 1 ) ) != 0 )
+	{
+		return false;
+	}
+
+	left = mappingSize;
+	if ( (uint64_t)index->tocOffset > left ) {
+		return false;
+	}
+	left -= index->tocOffset;
+	if ( (uint64_t)header->numChunks > left / sizeof(bfftoc_t) ) {
+		return false;
+	}
+	left -= sizeof(bfftoc_t) * header->numChunks;
+	if ( (uint64_t)index->hashTableSize > left / sizeof(int32_t) ) {
+		return false;
+	}
+	left -= sizeof(int32_t) * index->hashTableSize;
+
+	return (uint64_t)index->namesSize <= left;
+}
+
+/*
+* bffCheckChunk: a chunk's payload has to lie inside the file and decompress into a sane amount of
+* memory, checked once here so bffGetChunk can trust the table of contents
+*/
+static bool bffCheckChunk( const bfftoc_t *toc, uint64_t mappingSize )
+{
+	if ( toc->fileofs < 0 || toc->size < 0 || (uint64_t)toc->size > mappingSize
+		|| (uint64_t)toc->fileofs > mappingSize - (uint64_t)toc->size )
+	{
+		return false;
+	}
+	if ( toc->uncompressedSize < 0 || toc->uncompressedSize > BFF_MAX_CHUNK_SIZE ) {
+		return false;
+	}
+	return toc->compression != COMPRESS_NONE || toc->uncompressedSize == toc->size;
+}
+
+/*
+* bffOpenRead: v2 archives are mapped and only their table of contents is validated, chunks
+* are touched when they're asked for. Legacy archives are still read into memory in full.
+*/
+bff_t *bffOpenRead( const char *path )
+{
+	const byte *mapping;
+	const bffindex_t *index;
+	uint64_t mappingSize;
+	bffheader_t header;
+	bff_t *bff;
+
+	Log_Printf( "Loading BFF archive file '%s' in read mode...\n", path );
+
+	mapping = (const byte *)Sys_MapFile( path, &mappingSize );
+	if ( !mapping ) {
+		Sys_MessageBox( "BFF Tool", va( "Failed to open BFF archive file '%s' in read mode", path ), MB_OK );
+		return NULL;
+	}
+
+	if ( mappingSize < sizeof(header) ) {
+		Sys_UnmapFile( mapping, mappingSize );
+		Sys_MessageBox( "BFF Tool", va( "BFF archive file '%s' isn't large enough to contain a header", path ), MB_OK );
+		return NULL;
+	}
+
+	memcpy( &header, mapping, sizeof(header) );
+	if ( header.ident != BFF_IDENT || header.magic != HEADER_MAGIC ) {
+		Sys_UnmapFile( mapping, mappingSize );
+		Sys_MessageBox( "BFF Tool", va( "BFF archive file '%s' has a bad identifier", path ), MB_OK );
+		return NULL;
+	}
+
+	if ( header.version == BFF_VERSION_LEGACY ) {
+		Sys_UnmapFile( mapping, mappingSize );
+		bff = bffOpenReadLegacy( path );
+		if ( bff ) {
+			Log_Printf( "Done.\n" );
+		}
+		return bff;
+	}
+
+	if ( header.version != BFF_VERSION ) {
+		Sys_UnmapFile( mapping, mappingSize );
+		Sys_MessageBox( "BFF Tool", va( "BFF archive file '%s' has an unsupported version (%i.%i)", path,
+			header.version >> 8, header.version & 0xff ), MB_OK );
+		return NULL;
+	}
+
+	index = (const bffindex_t *)( mapping + sizeof(header) );
+	if ( mappingSize < sizeof(header) + sizeof(*index) || !bffCheckIndex( &header, index, mappingSize ) ) {
+		Sys_UnmapFile( mapping, mappingSize );
+		Sys_MessageBox( "BFF Tool", va( "Failed to load BFF archive file '%s', table of contents invalid", path ), MB_OK );
+		return NULL;
+	}
+
+	bff = (bff_t *)GetMemory( sizeof(*bff) );
+	memcpy( &bff->header, &header, sizeof(header) );
+	N_strncpyz( bff->bffGamename, index->bffGamename, sizeof(bff->bffGamename) );
+
+	bff->numChunks = header.numChunks;
+	bff->mapping = mapping;
+	bff->mappingSize = mappingSize;
+	bff->toc = (const bfftoc_t *)( mapping + index->tocOffset );
+	bff->hashTable = (const int32_t *)( bff->toc + header.numChunks );
+	bff->hashTableSize = index->hashTableSize;
+	bff->names = (const char *)( bff->hashTable + index->hashTableSize );
+	bff->chunkList = (bff_chunk_t *)GetMemory( sizeof(*bff->chunkList) * ( bff->numChunks ? bff->numChunks : 1 ) );
+
+	if ( bff->names[ index->namesSize - 1 ] != '\0' ) {
+		bffClose( bff );
+		Sys_MessageBox( "BFF Tool", va( "Failed to load BFF archive file '%s', chunk names invalid", path ), MB_OK );
+		return NULL;
+	}
+	for ( int64_t i = 0; i < bff->numChunks; i++ ) {
+		if ( bff->toc[i].nameOffset < 0 || bff->toc[i].nameOffset >= index->namesSize ) {
+			bffClose( bff );
+			Sys_MessageBox( "BFF Tool", va( "Failed to load BFF archive file '%s', chunk names invalid", path ), MB_OK );
+			return NULL;
+		}
+		if ( !bffCheckChunk( &bff->toc[i], mappingSize ) ) {
+			bffClose( bff );
+			Sys_MessageBox( "BFF Tool", va( "Failed to load BFF archive file '%s', chunk %li is invalid", path, i ), MB_OK );
+			return NULL;
+		}
+	}
+
+	Log_Printf( "Done, %li chunks.\n", bff->numChunks );
 
 	return bff;
 }
 
-FILE *bffOpenWrite( const char *path, bffheader_t *h )
+/*
+* bffFindChunk: returns the index of the chunk or -1
+*/
+int64_t bffFindChunk( const bff_t *archive, const char *name )
+{
+	uint64_t hash, mask, slot;
+	int32_t index;
+
+	if ( !archive->mapping ) {
+		for ( int64_t i = 0; i < archive->numChunks; i++ ) {
+			if ( !strcmp( archive->chunkList[i].chunkName, name ) ) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	hash = Com_HashBuffer( name, strlen( name ), 0 );
+	mask = archive->hashTableSize - 1;
+	slot = hash & mask;
+	for ( int64_t probes = 0; probes < archive->hashTableSize; probes++, slot = ( slot + 1 ) & mask ) {
+		index = archive->hashTable[ slot ];
+		if ( index < 0 || index >= archive->numChunks ) {
+			return -1;
+		}
+		if ( archive->toc[ index ].nameHash == hash && !strcmp( archive->names + archive->toc[ index ].nameOffset, name ) ) {
+			return index;
+		}
+	}
+	return -1;
+}
+
+/*
+* bffGetChunk: uncompressed v2 chunks point straight into the mapped file, compressed ones are
+* inflated on first use and kept until the archive is closed. Not safe to call from several
+* threads on the same archive.
+*/
+const void *bffGetChunk( bff_t *archive, const char *name, uint64_t *size )
+{
+	const bfftoc_t *toc;
+	bff_chunk_t *chunk;
+	int64_t index;
+
+	index = bffFindChunk( archive, name );
+	if ( index == -1 ) {
+		return NULL;
+	}
+
+	chunk = &archive->chunkList[ index ];
+	if ( !archive->mapping ) {
+		*size = chunk->chunkSize;
+		return chunk->chunkBuffer;
+	}
+
+	// bffOpenRead has already checked the chunk's range and sizes
+	toc = &archive->toc[ index ];
+
+	if ( toc->compression == COMPRESS_NONE ) {
+		*size = toc->size;
+		return archive->mapping + toc->fileofs;
+	}
+
+	if ( !chunk->chunkBuffer ) {
+		chunk->chunkBuffer = (char *)GetMemory( toc->uncompressedSize );
+		if ( !DecompressBlock( archive->mapping + toc->fileofs, toc->size, chunk->chunkBuffer, toc->uncompressedSize, toc->compression ) ) {
+			Log_FPrintf( SYS_WRN, "WARNING: failed to decompress BFF chunk '%s'\n", name );
+			FreeMemory( chunk->chunkBuffer );
+			chunk->chunkBuffer = NULL;
+			return NULL;
+		}
+		chunk->chunkSize = toc->uncompressedSize;
+	}
+
+	*size = chunk->chunkSize;
+	return chunk->chunkBuffer;
+}
+
+struct bffwrite_s
 {
 	FILE *fp;
+	char path[MAX_OSPATH];
+	bffheader_t header;
+	bffindex_t index;
+	std::vector<bfftoc_t> toc;
+	std::string names;
+	std::unordered_map<uint64_t, uint64_t> payloads; // content hash -> toc entry already holding it
+	uint64_t numDuplicates;
+	uint64_t duplicateBytes;
+};
+
+static void bffPad( FILE *fp )
+{
+	static const byte zero[BFF_CHUNK_ALIGN] = { 0 };
+	long pos;
 
-	fp = fopen( path, "wb" );
+	pos = ftell( fp );
+	if ( pos % BFF_CHUNK_ALIGN ) {
+		SafeWrite( zero, BFF_CHUNK_ALIGN - ( pos % BFF_CHUNK_ALIGN ), fp );
+	}
+}
+
+bffwrite_t *bffOpenWrite( const char *path, const char *gamename )
+{
+	bffwrite_t *archive;
+	FILE *fp;
+
+	// read back as well as written, a payload that looks like a duplicate is compared against the copy on disk
+	fp = fopen( path, "w+b" );
 	if ( !fp ) {
 		Sys_MessageBox( "BFF Tool", va( "Failed to create BFF archive file '%s'", path ), MB_OK );
 		return NULL;
 	}
 
-	memset( h, 0, sizeof(*h) );
-	h->magic = HEADER_MAGIC;
-	h->numChunks = 0;
-	h->compression = parm_compression;
-	h->ident = BFF_IDENT;
-	h->version = BFF_VERSION;
+	archive = new bffwrite_t;
+	archive->fp = fp;
+	N_strncpyz( archive->path, path, sizeof(archive->path) );
+
+	memset( &archive->header, 0, sizeof(archive->header) );
+	archive->header.magic = HEADER_MAGIC;
+	archive->header.numChunks = 0;
+	archive->header.compression = parm_compression;
+	archive->header.ident = BFF_IDENT;
+	archive->header.version = BFF_VERSION;
+
+	archive->numDuplicates = 0;
+	archive->duplicateBytes = 0;
+
+	memset( &archive->index, 0, sizeof(archive->index) );
+	N_strncpyz( archive->index.bffGamename, gamename, sizeof(archive->index.bffGamename) );
 	
 	// will be overwritten
-	SafeWrite( h, sizeof(*h), fp );
+	SafeWrite( &archive->header, sizeof(archive->header), fp );
+	SafeWrite( &archive->index, sizeof(archive->index), fp );
 
-	return fp;
+	return archive;
 }
 
-void bffWriteChunk( const char *name, const void *data, int size, bffheader_t *h, FILE *fp )
+/*
+* bffPayloadMatches: a matching hash and size only make a duplicate likely, the payload already in
+* the archive is read back and compared before a chunk is pointed at it
+*/
+static bool bffPayloadMatches( bffwrite_t *archive, const bfftoc_t *other, const void *data, uint64_t size, int compression )
 {
-	int64_t nameLength, bufSize;
+	byte buffer[65536];
+	const byte *p;
+	uint64_t offset, length;
+	bool match;
 
-	Log_Printf( "Writing chunk %s (%i bytes)...\n", name, size );
+	if ( other->compression != compression || (uint64_t)other->size != size ) {
+		return false;
+	}
 
-	nameLength = strlen( name ) + 1;
-	bufSize = size;
+	fflush( archive->fp );
+	if ( fseek( archive->fp, other->fileofs, SEEK_SET ) != 0 ) {
+		fseek( archive->fp, 0, SEEK_END );
+		return false;
+	}
 
-	SafeWrite( &nameLength, sizeof(nameLength), fp );
-	SafeWrite( name, nameLength, fp );
-	SafeWrite( &bufSize, sizeof(bufSize), fp );
-	SafeWrite( data, size, fp );
+	match = true;
+	p = (const byte *)data;
+	for ( offset = 0; offset < size; offset += length ) {
+		length = size - offset < sizeof(buffer) ? size - offset : sizeof(buffer);
+		if ( fread( buffer, 1, length, archive->fp ) != length || memcmp( buffer, p + offset, length ) ) {
+			match = false;
+			break;
+		}
+	}
 
-	h->numChunks++;
+	fseek( archive->fp, 0, SEEK_END );
+	return match;
 }
 
-void bffClose( bff_t *archive )
+/*
+* bffWriteStored: adds a chunk whose payload is already in its stored form, identical payloads
+* are only written once and shared between table of contents entries
+*/
+static void bffWriteStored( bffwrite_t *archive, const char *name, uint64_t contentHash, const void *data, uint64_t size,
+	uint64_t uncompressedSize, int compression )
 {
-	for ( int64_t i = 0; i < archive->numChunks; i++ ) {
-		if ( archive->chunkList[i].chunkName ) {
-			free( archive->chunkList[i].chunkName );
-			archive->chunkList[i].chunkName = NULL;
-		}
-		if ( archive->chunkList[i].chunkBuffer ) {
-			free( archive->chunkList[i].chunkBuffer );
-			archive->chunkList[i].chunkBuffer = NULL;
+	bfftoc_t *toc;
+
+	toc = &archive->toc.emplace_back();
+	toc->nameHash = Com_HashBuffer( name, strlen( name ), 0 );
+	toc->nameOffset = archive->names.size();
+	toc->size = size;
+	toc->uncompressedSize = uncompressedSize;
+	toc->compression = compression;
+
+	archive->names.append( name, strlen( name ) + 1 );
+
+	auto it = archive->payloads.find( contentHash );
+	if ( it != archive->payloads.end() && archive->toc[ it->second ].uncompressedSize == (int64_t)uncompressedSize
+		&& bffPayloadMatches( archive, &archive->toc[ it->second ], data, size, compression ) )
+	{
+		const bfftoc_t *other = &archive->toc[ it->second ];
+
+		toc->fileofs = other->fileofs;
+		toc->size = other->size;
+		toc->compression = other->compression;
+		archive->numDuplicates++;
+		archive->duplicateBytes += uncompressedSize;
+		return;
+	}
+	archive->payloads[ contentHash ] = archive->toc.size() - 1;
+
+	bffPad( archive->fp );
+	toc->fileofs = ftell( archive->fp );
+	SafeWrite( data, size, archive->fp );
+}
+
+void bffWriteChunk( bffwrite_t *archive, const char *name, const void *data, uint64_t size )
+{
+	Log_Printf( "Writing chunk %s (%lu bytes)...\n", name, size );
+
+	bffWriteStored( archive, name, Com_HashBuffer( data, size, 0 ), data, size, size, COMPRESS_NONE );
+}
+
+/*
+* bffCloseWrite: writes the table of contents and the final header, then frees the writer
+*/
+bool bffCloseWrite( bffwrite_t *archive )
+{
+	std::vector<int32_t> hashTable;
+	uint64_t mask, slot;
+	bool ok;
+
+	archive->index.hashTableSize = 1;
+	while ( archive->index.hashTableSize < (int64_t)archive->toc.size() * 2 ) {
+		archive->index.hashTableSize <<= 1;
+	}
+	mask = archive->index.hashTableSize - 1;
+
+	hashTable.resize( archive->index.hashTableSize, -1 );
+	for ( int32_t i = 0; i < (int32_t)archive->toc.size(); i++ ) {
+		const bfftoc_t *toc = &archive->toc[i];
+
+		for ( slot = toc->nameHash & mask; hashTable[ slot ] != -1; slot = ( slot + 1 ) & mask ) {
+			const bfftoc_t *other = &archive->toc[ hashTable[ slot ] ];
+			if ( other->nameHash == toc->nameHash && !strcmp( &archive->names[ other->nameOffset ], &archive->names[ toc->nameOffset ] ) ) {
+				Log_FPrintf( SYS_WRN, "WARNING: duplicate BFF chunk '%s', keeping the last one\n", &archive->names[ toc->nameOffset ] );
+				break;
+			}
 		}
+		hashTable[ slot ] = i;
+	}
+
+	if ( archive->names.empty() ) {
+		archive->names.push_back( '\0' );
+	}
+
+	bffPad( archive->fp );
+	archive->index.tocOffset = ftell( archive->fp );
+	archive->index.namesOffset = 0;
+	archive->index.namesSize = archive->names.size();
+	archive->header.numChunks = archive->toc.size();
+
+	if ( archive->toc.size() ) {
+		SafeWrite( archive->toc.data(), sizeof(bfftoc_t) * archive->toc.size(), archive->fp );
+	}
+	SafeWrite( hashTable.data(), sizeof(int32_t) * hashTable.size(), archive->fp );
+	SafeWrite( archive->names.data(), archive->names.size(), archive->fp );
+
+	fseek( archive->fp, 0, SEEK_SET );
+	SafeWrite( &archive->header, sizeof(archive->header), archive->fp );
+	SafeWrite( &archive->index, sizeof(archive->index), archive->fp );
+
+	ok = !ferror( archive->fp );
+	if ( fclose( archive->fp ) != 0 || !ok ) {
+		Log_FPrintf( SYS_ERR, "ERROR: failed to write BFF archive file '%s'\n", archive->path );
+		ok = false;
 	}
-	free( archive );
+
+	delete archive;
+
+	return ok;
 }
 
-double Sys_DoubleTime( void ) {
-	return (double)clock() / 1000.0f;
+/*
+===============================================================
+
+Packer: files are read, hashed and compressed on every core a batch
+at a time, then the calling thread appends that batch's payloads to
+the archive in order before the next batch starts
+
+===============================================================
+*/
+
+#define BFF_PACK_BATCH_BYTES (256*1024*1024)
+#define BFF_PACK_MIN_COMPRESS 256 // not worth a compressor's header below this
+
+typedef struct {
+	const char *path;
+	void *data;
+	char *stored;
+	uint64_t size;
+	uint64_t storedSize;
+	uint64_t contentHash;
+	int compression;
+	const char *compressError;
+} bffPackItem_t;
+
+static const char *CompressBlock( const void *buf, uint64_t buflen, char **out, uint64_t *outlen, int compression );
+
+/*
+* bffPackLoad: runs on a worker, so a compression failure is only recorded for the writer to report
+*/
+static void bffPackLoad( bffPackItem_t *item )
+{
+	uint64_t length;
+
+	length = LoadFile( item->path, &item->data );
+	if ( !item->data ) {
+		return;
+	}
+
+	item->size = length;
+	item->contentHash = Com_HashBuffer( item->data, item->size, 0 );
+	item->stored = (char *)item->data;
+	item->storedSize = item->size;
+	item->compression = COMPRESS_NONE;
+
+	if ( parm_compression != COMPRESS_NONE && item->size >= BFF_PACK_MIN_COMPRESS ) {
+		char *compressed;
+		uint64_t compressedLength;
+
+		compressedLength = 0;
+		item->compressError = CompressBlock( item->data, item->size, &compressed, &compressedLength, parm_compression );
+		if ( compressed ) {
+			if ( compressedLength < item->size ) {
+				item->stored = compressed;
+				item->storedSize = compressedLength;
+				item->compression = parm_compression;
+			} else {
+				FreeMemory( compressed );
+			}
+		}
+	}
 }
 
-void Sys_LoadAsset( const char *title, float *progress, const std::function<void( void )>& loadFunc )
+/*
+* bffPackFiles: writes every file to a v2 archive, chunks are named by their path relative to baseDir
+*/
+bool bffPackFiles( const char *path, const char *gamename, const char *baseDir, const std::vector<std::string>& files )
 {
-	int result;
-	std::mutex loadLock;
-	ImGuiIO& io = ImGui::GetIO();
+	std::vector<bffPackItem_t> batch;
+	bffwrite_t *archive;
+	uint64_t first, last, batchBytes, baseLength, rawBytes;
+	const char *name;
+	bool ok;
 
-	ImGui::OpenPopup( "Loading Asset" );
-	std::thread loadThread( loadFunc );
-	while ( *progress < 100.0f ) {
+	archive = bffOpenWrite( path, gamename );
+	if ( !archive ) {
+		return false;
+	}
 
-		events.EventLoop();
+	Log_Printf( "Packing %lu files from '%s' into '%s'...\n", files.size(), baseDir, path );
+
+	ok = true;
+	rawBytes = 0;
+	baseLength = strlen( baseDir );
+	for ( first = 0; first < files.size(); first = last ) {
+		// a batch is capped in bytes so huge asset sets don't have to fit in memory at once
+		batchBytes = 0;
+		for ( last = first; last < files.size() && ( last == first || batchBytes < BFF_PACK_BATCH_BYTES ); last++ ) {
+			std::error_code err;
+			batchBytes += std::filesystem::file_size( files[ last ], err );
+		}
 
-		for ( auto& layer : g_pApplication->m_LayerStack ) {
-			layer->OnUpdate( g_pApplication->m_TimeStep );
+		batch.resize( last - first );
+		for ( uint64_t i = 0; i < batch.size(); i++ ) {
+			memset( &batch[i], 0, sizeof(batch[i]) );
+			batch[i].path = files[ first + i ].c_str();
 		}
 
-		// Start the Dear ImGui frame
-		ImGui_ImplOpenGL3_NewFrame();
-		ImGui_ImplSDL2_NewFrame();
-		ImGui::NewFrame();
+		Sys_ParallelFor( batch.size(), [&]( uint64_t i ) { bffPackLoad( &batch[i] ); } );
 
-		{
-			static ImGuiDockNodeFlags dockspace_flags = ImGuiDockNodeFlags_None;
-
-			// We are using the ImGuiWindowFlags_NoDocking flag to make the parent window not dockable into,
-			// because it would be confusing to have two docking targets within each others.
-			ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoDocking;
-			if (g_pApplication->m_MenubarCallback)
-				window_flags |= ImGuiWindowFlags_MenuBar;
-
-			const ImGuiViewport* viewport = ImGui::GetMainViewport();
-			ImGui::SetNextWindowPos(viewport->WorkPos);
-			ImGui::SetNextWindowSize(viewport->WorkSize);
-			ImGui::SetNextWindowViewport(viewport->ID);
-			ImGui::PushStyleVar(ImGuiStyleVar_WindowRounding, 0.0f);
-			ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, 0.0f);
-			window_flags |= ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove;
-			window_flags |= ImGuiWindowFlags_NoBringToFrontOnFocus | ImGuiWindowFlags_NoNavFocus;
-
-			// When using ImGuiDockNodeFlags_PassthruCentralNode, DockSpace() will render our background
-			// and handle the pass-thru hole, so we ask Begin() to not render a background.
-			if (dockspace_flags & ImGuiDockNodeFlags_PassthruCentralNode)
-				window_flags |= ImGuiWindowFlags_NoBackground;
-
-			// Important: note that we proceed even if Begin() returns false (aka window is collapsed).
-			// This is because we want to keep our DockSpace() active. If a DockSpace() is inactive,
-			// all active windows docked into it will lose their parent and become undocked.
-			// We cannot preserve the docking relationship between an active window and an inactive docking, otherwise
-			// any change of dockspace/settings would lead to windows being stuck in limbo and never being visible.
-			ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.0f, 0.0f));
-			ImGui::Begin("DockSpace Demo", nullptr, window_flags);
-			ImGui::PopStyleVar();
-
-			ImGui::PopStyleVar(2);
-
-			// Submit the DockSpace
-			ImGuiIO& io = ImGui::GetIO();
-			if (io.ConfigFlags & ImGuiConfigFlags_DockingEnable) {
-				ImGuiID dockspace_id = ImGui::GetID("VulkanAppDockspace");
-				ImGui::DockSpace(dockspace_id, ImVec2(0.0f, 0.0f), dockspace_flags);
+		for ( auto& it : batch ) {
+			if ( !it.data ) {
+				Log_FPrintf( SYS_ERR, "ERROR: failed to read '%s', it won't be in the archive\n", it.path );
+				ok = false;
+				continue;
+			}
+			if ( it.compressError ) {
+				Log_FPrintf( SYS_WRN, "WARNING: failed to compress '%s', storing it raw: %s\n", it.path, it.compressError );
 			}
 
-			if ( g_pApplication->m_MenubarCallback ) {
-				if ( ImGui::BeginMenuBar() ) {
-					g_pApplication->m_MenubarCallback();
-					ImGui::EndMenuBar();
+			name = it.path;
+			if ( !strncmp( name, baseDir, baseLength ) ) {
+				name += baseLength;
+				while ( *name == '/' || *name == '\\' ) {
+					name++;
 				}
 			}
 
-			for ( auto& layer : g_pApplication->m_LayerStack ) {
-				layer->OnUIRender();
+			bffWriteStored( archive, name, it.contentHash, it.stored, it.storedSize, it.size, it.compression );
+			rawBytes += it.size;
+
+			if ( it.stored != it.data ) {
+				FreeMemory( it.stored );
 			}
-			
-			ImGui::End();
+			FreeMemory( it.data );
 		}
+	}
 
-		loadLock.lock();
-		if ( ImGui::BeginPopupModal( "Loading Asset" ) ) {
-			ImGui::Text( "Loading %s [%.03f / 100.0]...", title, *progress );
-			ImGui::ProgressBar( *progress );
+	Log_Printf( "%lu chunks, %lu duplicates sharing %lu bytes, %lu bytes of data packed into %li bytes of chunks.\n", archive->toc.size(),
+		archive->numDuplicates, archive->duplicateBytes, rawBytes, ftell( archive->fp ) );
 
-			if ( *progress >= 100.0f ) {
-				ImGui::CloseCurrentPopup();
-			}
+	if ( !bffCloseWrite( archive ) ) {
+		return false;
+	}
 
-			ImGui::EndPopup();
-		}
-		loadLock.unlock();
-
-		// Rendering
-		ImGui::Render();
-		ImDrawData* main_draw_data = ImGui::GetDrawData();
-		const bool main_is_minimized = ( main_draw_data->DisplaySize.x <= 0.0f || main_draw_data->DisplaySize.y <= 0.0f );
-		if (!main_is_minimized) {
-			ImGui_ImplOpenGL3_RenderDrawData( main_draw_data );
-		}
+	return ok;
+}
 
-		// Update and Render additional Platform Windows
-		if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
-		{
-			ImGui::UpdatePlatformWindows();
-			ImGui::RenderPlatformWindowsDefault();
+void bffClose( bff_t *archive )
+{
+	for ( int64_t i = 0; i < archive->numChunks; i++ ) {
+		if ( archive->chunkList[i].chunkName ) {
+			FreeMemory( archive->chunkList[i].chunkName );
+			archive->chunkList[i].chunkName = NULL;
 		}
-
-		// Present Main Platform Window
-		if (!main_is_minimized) {
-//			ImGui_ImplOpenGL3_RenderDrawData( main_draw_data );
+		if ( archive->chunkList[i].chunkBuffer ) {
+			FreeMemory( archive->chunkList[i].chunkBuffer );
+			archive->chunkList[i].chunkBuffer = NULL;
 		}
-
-		float time = g_pApplication->GetTime();
-		g_pApplication->m_FrameTime = time - g_pApplication->m_LastFrameTime;
-		g_pApplication->m_TimeStep = glm::min<float>( g_pApplication->m_FrameTime, 0.0333f );
-		g_pApplication->m_LastFrameTime = time;
-		SDL_GL_SwapWindow( g_pApplication->m_WindowHandle );
 	}
+	if ( archive->mapping ) {
+		Sys_UnmapFile( archive->mapping, archive->mappingSize );
+	}
+	FreeMemory( archive->chunkList );
+	FreeMemory( archive );
+}
 
-	loadThread.join();
+double Sys_DoubleTime( void ) {
+	return (double)clock() / 1000.0f;
 }
 
 int N_stricmp( const char *s1, const char *s2 ) 
@@ -513,6 +910,52 @@ void N_strncpyz (char *dest, const char *src, size_t count)
 #endif
 }
 
+/*
+* GLN_InitCompression: picks the compression used for levels and archives, "-compression none|zlib|bzip2"
+*/
+void GLN_InitCompression( void )
+{
+	parm_compression = CheckParm( "-compression" );
+
+	if ( parm_compression != -1 && parm_compression + 1 < myargc ) {
+		if ( !N_stricmp( myargv[parm_compression+1], "none" ) ) {
+			parm_compression = COMPRESS_NONE;
+			Log_Printf( "Manual compression override, lumps will be stored uncompressed.\n" );
+		} else if ( !N_stricmp( myargv[parm_compression+1], "zlib" ) ) {
+			parm_compression = COMPRESS_ZLIB;
+			Log_Printf( "Manual compression override for zlib.\n" );
+		} else if ( !N_stricmp( myargv[parm_compression+1], "bzip2" ) ) {
+			parm_compression = COMPRESS_BZIP2;
+			Log_Printf( "Manual compression override for bzip2.\n" );
+		} else {
+			Log_FPrintf( SYS_WRN, "WARNING: invalid compression format provided '%s', defaulting to zlib\n", myargv[parm_compression+1] );
+			parm_compression = COMPRESS_ZLIB;
+		}
+	}
+	else {
+		parm_compression = COMPRESS_ZLIB;
+		Log_Printf( "Using ZLib compression.\n" );
+	}
+}
+
+/*
+* Com_HashBuffer: 64-bit FNV-1a, pass the previous result as the seed to chain buffers, 0 starts a new hash
+*/
+uint64_t Com_HashBuffer( const void *data, uint64_t size, uint64_t seed )
+{
+	const byte *p;
+	uint64_t hash, i;
+
+	p = (const byte *)data;
+	hash = seed ? seed : 0xcbf29ce484222325ULL;
+	for ( i = 0; i < size; i++ ) {
+		hash ^= p[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
 int CheckParm( const char *name )
 {
 	int i;
@@ -645,7 +1088,7 @@ static inline const char *bzip2_strerror( int err )
 	case BZ_DATA_ERROR: return "(BZ_DATA_ERROR) buffer provided to bzip2 was corrupted";
 	case BZ_MEM_ERROR: return "(BZ_MEM_ERROR) memory allocation request made by bzip2 failed";
 	case BZ_DATA_ERROR_MAGIC: return "(BZ_DATA_ERROR_MAGIC) buffer was not compressed with bzip2, it did not contain \"BZA\"";
-	case BZ_IO_ERROR: return va("(BZ_IO_ERROR) failure to read or write, file I/O error");
+	case BZ_IO_ERROR: return "(BZ_IO_ERROR) failure to read or write, file I/O error";
 	case BZ_UNEXPECTED_EOF: return "(BZ_UNEXPECTED_EOF) unexpected end of data stream";
 	case BZ_OUTBUFF_FULL: return "(BZ_OUTBUFF_FULL) buffer overflow";
 	case BZ_SEQUENCE_ERROR: return "(BZ_SEQUENCE_ERROR) bad function call error, please report this bug";
@@ -688,11 +1131,13 @@ static char *Compress_BZIP2( void *buf, uint64_t buflen, uint64_t *outlen )
 
 	Log_Printf( "Compressing %lu bytes with bzip2...\n", buflen );
 
-	len = buflen;
-	out = (char *)GetMemory( buflen );
+	// bzip2 guarantees the output never exceeds 1% + 600 bytes of the input
+	len = buflen + ( buflen / 100 ) + 600;
+	out = (char *)GetMemory( len );
 
-	ret = BZ2_bzBuffToBuffCompress( out, &len, (char *)buf, buflen, 9, 4, 50 );
+	ret = BZ2_bzBuffToBuffCompress( out, &len, (char *)buf, buflen, 9, 0, 50 );
 	if ( !CheckBZIP2( ret, buflen, "Compression" ) ) {
+		FreeMemory( out );
 		return (char *)buf;
 	}
 
@@ -734,10 +1179,11 @@ static void zfreeMemory( voidpf opaque, voidpf address )
 static char *Compress_ZLIB( void *buf, uint64_t buflen, uint64_t *outlen )
 {
 	char *out, *newbuf;
-	const uint64_t expectedLen = buflen / 2;
+	uLongf len;
 	int ret;
 
-	out = (char *)GetMemory( buflen );
+	len = compressBound( buflen );
+	out = (char *)GetMemory( len );
 
 #if 0
 	stream.zalloc = zalloc;
@@ -784,11 +1230,14 @@ static char *Compress_ZLIB( void *buf, uint64_t buflen, uint64_t *outlen )
 #endif
 	Log_Printf( "Compressing %lu bytes with zlib...\n", buflen );
 
-	ret = compress2( (Bytef *)out, (uLongf *)outlen, (const Bytef *)buf, buflen, Z_BEST_COMPRESSION );
+	ret = compress2( (Bytef *)out, &len, (const Bytef *)buf, buflen, Z_BEST_COMPRESSION );
 	if ( ret != Z_OK ) {
 		Sys_MessageBox( "ZLib Compression Failure", va( "Failure on compression of %lu bytes. ZLIB error reason:\n\t%s", buflen, zError( ret ) ),
 			MB_OK );
+		FreeMemory( out );
+		return (char *)buf;
 	}
+	*outlen = len;
 	
 	Log_Printf( "Successful compression of %lu to %lu bytes with zlib.\n", buflen, *outlen );
 	newbuf = (char *)GetMemory( *outlen );
@@ -874,6 +1323,225 @@ char *Decompress( void *buf, uint64_t buflen, uint64_t *outlen, int compression
 	return (char *)buf;
 }
 
+/*
+* Sys_ParallelFor: runs func once for every index in [0, count), spread over the job system. The
+* range is cut into a few chunks per thread so one slow index doesn't hold the rest up, and the
+* caller works through chunks too until they're all done, so nesting is fine.
+*/
+void Sys_ParallelFor( uint64_t count, const std::function<void( uint64_t )>& func )
+{
+	jobGroup_t group;
+	uint64_t numChunks, chunkSize;
+
+	numChunks = (uint64_t)Job_NumWorkers() + 1;
+	if ( numChunks > count ) {
+		numChunks = count;
+	}
+	if ( numChunks < 2 ) {
+		for ( uint64_t i = 0; i < count; i++ ) {
+			func( i );
+		}
+		return;
+	}
+
+	numChunks *= 4;
+	if ( numChunks > count ) {
+		numChunks = count;
+	}
+	chunkSize = ( count + numChunks - 1 ) / numChunks;
+
+	for ( uint64_t first = 0; first < count; first += chunkSize ) {
+		const uint64_t last = first + chunkSize < count ? first + chunkSize : count;
+
+		Job_Add( &group, Job_CurrentPriority(), [&func, first, last]( void ) {
+			for ( uint64_t i = first; i < last; i++ ) {
+				func( i );
+			}
+		} );
+	}
+	Job_Wait( &group );
+}
+
+/*
+* CompressBlock: compresses a single block into a buffer of its own. It neither logs nor opens a
+* message box so any worker can run it, on failure it returns the library's reason and leaves *out NULL.
+*/
+static const char *CompressBlock( const void *buf, uint64_t buflen, char **out, uint64_t *outlen, int compression )
+{
+	int ret;
+
+	*out = NULL;
+	switch ( compression ) {
+	case COMPRESS_ZLIB: {
+		uLongf len = compressBound( buflen );
+		*out = (char *)GetMemory( len );
+		ret = compress2( (Bytef *)*out, &len, (const Bytef *)buf, buflen, Z_BEST_COMPRESSION );
+		if ( ret != Z_OK ) {
+			FreeMemory( *out );
+			*out = NULL;
+			return zError( ret );
+		}
+		*outlen = len;
+		return NULL; }
+	case COMPRESS_BZIP2: {
+		// bzip2 guarantees the output never exceeds 1% + 600 bytes of the input
+		unsigned int len = buflen + ( buflen / 100 ) + 600;
+		*out = (char *)GetMemory( len );
+		ret = BZ2_bzBuffToBuffCompress( *out, &len, (char *)buf, buflen, 9, 0, 50 );
+		if ( ret != BZ_OK ) {
+			FreeMemory( *out );
+			*out = NULL;
+			return bzip2_strerror( ret );
+		}
+		*outlen = len;
+		return NULL; }
+	default:
+		break;
+	};
+	return "unknown compression type";
+}
+
+/*
+* CompressBlocks: splits buf into blocks of blockSize bytes and compresses them independently on
+* all cores. The returned buffer holds a lumpblock_t table followed by the block data. Returns NULL
+* if compression failed or didn't make anything smaller, in which case the data should be stored raw.
+* A failure's reason goes to *error for the caller to report, it stays NULL if the data just didn't shrink.
+*/
+char *CompressBlocks( const void *buf, uint64_t buflen, uint64_t blockSize, int compression, uint64_t *outlen, uint32_t *numBlocks,
+	const char **error )
+{
+	std::vector<char *> blocks;
+	std::vector<uint64_t> blockLengths;
+	std::vector<const char *> blockErrors;
+	lumpblock_t *table;
+	uint64_t count, total, ofs;
+	const char *failed;
+	char *out;
+
+	if ( error ) {
+		*error = NULL;
+	}
+	if ( compression == COMPRESS_NONE || !buflen || !blockSize ) {
+		return NULL;
+	}
+
+	count = ( buflen + blockSize - 1 ) / blockSize;
+	blocks.resize( count );
+	blockLengths.resize( count );
+	blockErrors.resize( count );
+
+	// workers only record what went wrong, it's handed back once all of them are done
+	Sys_ParallelFor( count, [&]( uint64_t i ) {
+		const char *data = (const char *)buf + i * blockSize;
+		const uint64_t len = ( i == count - 1 ) ? buflen - i * blockSize : blockSize;
+
+		blockErrors[i] = CompressBlock( data, len, &blocks[i], &blockLengths[i], compression );
+	} );
+
+	failed = NULL;
+	total = sizeof(*table) * count;
+	for ( uint64_t i = 0; i < count; i++ ) {
+		if ( !blocks[i] ) {
+			if ( !failed ) {
+				failed = blockErrors[i];
+			}
+			continue;
+		}
+		total += blockLengths[i];
+	}
+
+	if ( failed || total >= buflen ) {
+		if ( error ) {
+			*error = failed;
+		}
+		for ( uint64_t i = 0; i < count; i++ ) {
+			FreeMemory( blocks[i] );
+		}
+		return NULL;
+	}
+
+	out = (char *)GetMemory( total );
+	table = (lumpblock_t *)out;
+	ofs = sizeof(*table) * count;
+	for ( uint64_t i = 0; i < count; i++ ) {
+		table[i].fileofs = ofs;
+		table[i].length = blockLengths[i];
+		memcpy( out + ofs, blocks[i], blockLengths[i] );
+		ofs += blockLengths[i];
+		FreeMemory( blocks[i] );
+	}
+
+	*outlen = total;
+	*numBlocks = count;
+
+	return out;
+}
+
+/*
+* DecompressBlock: decompresses a single block into a caller provided buffer, outlen must be
+* the exact uncompressed size of the block
+*/
+bool DecompressBlock( const void *buf, uint64_t buflen, void *out, uint64_t outlen, int compression )
+{
+	switch ( compression ) {
+	case COMPRESS_NONE:
+		if ( buflen != outlen ) {
+			return false;
+		}
+		memcpy( out, buf, outlen );
+		return true;
+	case COMPRESS_ZLIB: {
+		uLongf len = outlen;
+		return uncompress( (Bytef *)out, &len, (const Bytef *)buf, buflen ) == Z_OK && len == outlen; }
+	case COMPRESS_BZIP2: {
+		unsigned int len = outlen;
+		return BZ2_bzBuffToBuffDecompress( (char *)out, &len, (char *)buf, buflen, 0, 0 ) == BZ_OK && len == outlen; }
+	default:
+		break;
+	};
+	return false;
+}
+
+/*
+* DecompressBlocks: inverse of CompressBlocks, decompresses every block of a lump in parallel
+*/
+char *DecompressBlocks( const void *buf, uint64_t buflen, uint64_t blockSize, uint32_t numBlocks, uint64_t outlen, int compression )
+{
+	const lumpblock_t *table;
+	std::atomic<bool> failed;
+	char *out;
+
+	table = (const lumpblock_t *)buf;
+	if ( buflen < sizeof(*table) * numBlocks || ( outlen + blockSize - 1 ) / blockSize != numBlocks ) {
+		Log_FPrintf( SYS_WRN, "DecompressBlocks: bad block table\n" );
+		return NULL;
+	}
+	for ( uint32_t i = 0; i < numBlocks; i++ ) {
+		if ( table[i].fileofs > buflen || table[i].length > buflen - table[i].fileofs ) {
+			Log_FPrintf( SYS_WRN, "DecompressBlocks: block %u out of range\n", i );
+			return NULL;
+		}
+	}
+
+	out = (char *)GetMemory( outlen );
+	failed = false;
+
+	Sys_ParallelFor( numBlocks, [&]( uint64_t i ) {
+		const uint64_t len = ( i == numBlocks - 1 ) ? outlen - i * blockSize : blockSize;
+		if ( !DecompressBlock( (const char *)buf + table[i].fileofs, table[i].length, out + i * blockSize, len, compression ) ) {
+			failed = true;
+		}
+	} );
+
+	if ( failed ) {
+		Log_FPrintf( SYS_WRN, "DecompressBlocks: failed to decompress %lu bytes\n", buflen );
+		FreeMemory( out );
+		return NULL;
+	}
+
+	return out;
+}
+
 
 void Sys_SetWindowTitle( const char *title )
 {
@@ -966,38 +1634,188 @@ int Sys_MessageBox( const char *title, const char *message, unsigned flags )
 		break; }
 	};
 
-	boxData.window = NULL;
-	boxData.title = title;
-	boxData.message = message;
-	boxData.numbuttons = numButtons;
-	boxData.buttons = buttonData;
+	boxData.window = NULL;
+	boxData.title = title;
+	boxData.message = message;
+	boxData.numbuttons = numButtons;
+	boxData.buttons = buttonData;
+
+	switch ( iconType ) {
+	case MB_ICONERROR:
+		boxData.flags = SDL_MESSAGEBOX_ERROR;
+		break;
+	case MB_ICONWARNING:
+		boxData.flags = SDL_MESSAGEBOX_WARNING;
+		break;
+	case MB_ICONINFORMATION:
+		boxData.flags = SDL_MESSAGEBOX_INFORMATION;
+		break;
+	case MB_ICONQUESTION:
+		break;
+	};
+
+	Log_Printf( "%s: %s\n", title, message );
+	SDL_ShowMessageBox( &boxData, &buttonid );
+	return buttonid;
+}
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
+/*
+* Sys_MapFile: maps a whole file read-only, returns NULL if it can't be opened or is empty
+*/
+const void *Sys_MapFile( const char *path, uint64_t *size )
+{
+#ifdef _WIN32
+	HANDLE file, mapping;
+	LARGE_INTEGER length;
+	void *data;
+
+	file = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( file == INVALID_HANDLE_VALUE ) {
+		return NULL;
+	}
+	if ( !GetFileSizeEx( file, &length ) || !length.QuadPart ) {
+		CloseHandle( file );
+		return NULL;
+	}
+	mapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	CloseHandle( file );
+	if ( !mapping ) {
+		return NULL;
+	}
+	data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	CloseHandle( mapping );
+	if ( !data ) {
+		return NULL;
+	}
+
+	*size = length.QuadPart;
+	return data;
+#else
+	struct stat fdata;
+	void *data;
+	int fd;
+
+	fd = open( path, O_RDONLY );
+	if ( fd == -1 ) {
+		return NULL;
+	}
+	if ( fstat( fd, &fdata ) == -1 || !fdata.st_size ) {
+		close( fd );
+		return NULL;
+	}
+	data = mmap( NULL, fdata.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close( fd );
+	if ( data == MAP_FAILED ) {
+		return NULL;
+	}
+
+	*size = fdata.st_size;
+	return data;
+#endif
+}
+
+void Sys_UnmapFile( const void *data, uint64_t size )
+{
+#ifdef _WIN32
+	UnmapViewOfFile( data );
+#else
+	munmap( (void *)data, size );
+#endif
+}
+
+static uint64_t Sys_PageSize( void )
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+
+	GetSystemInfo( &info );
+	return info.dwPageSize;
+#else
+	return sysconf( _SC_PAGESIZE );
+#endif
+}
+
+/*
+* Sys_ReservePages: zeroed memory straight from the OS, pages are only committed once they're
+* touched so large arrays cost nothing up front. Release it with Sys_ReleasePages.
+*/
+void *Sys_ReservePages( uint64_t size )
+{
+	void *data;
+
+	if ( !size ) {
+		return NULL;
+	}
+
+#ifdef _WIN32
+	data = VirtualAlloc( NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE );
+	if ( !data ) {
+		Error( "Sys_ReservePages: failed to allocate %lu bytes", size );
+	}
+#else
+	data = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+	if ( data == MAP_FAILED ) {
+		Error( "Sys_ReservePages: failed to allocate %lu bytes", size );
+	}
+#endif
+
+	return data;
+}
 
-	switch ( iconType ) {
-	case MB_ICONERROR:
-		boxData.flags = SDL_MESSAGEBOX_ERROR;
-		break;
-	case MB_ICONWARNING:
-		boxData.flags = SDL_MESSAGEBOX_WARNING;
-		break;
-	case MB_ICONINFORMATION:
-		boxData.flags = SDL_MESSAGEBOX_INFORMATION;
-		break;
-	case MB_ICONQUESTION:
-		break;
-	};
+/*
+* Sys_ResetPages: zeroes a range of Sys_ReservePages memory, whole pages inside it are handed back
+* to the OS instead of being written to
+*/
+void Sys_ResetPages( void *data, uint64_t size )
+{
+	uintptr_t start, end, pageStart, pageEnd, pageSize;
 
-	Log_Printf( "%s: %s\n", title, message );
-	SDL_ShowMessageBox( &boxData, &buttonid );
-	return buttonid;
+	if ( !size ) {
+		return;
+	}
+
+	pageSize = Sys_PageSize();
+	start = (uintptr_t)data;
+	end = start + size;
+	pageStart = ( start + pageSize - 1 ) & ~( pageSize - 1 );
+	pageEnd = end & ~( pageSize - 1 );
+
+	if ( pageStart >= pageEnd ) {
+		memset( data, 0, size );
+		return;
+	}
+
+	memset( data, 0, pageStart - start );
+	memset( (void *)pageEnd, 0, end - pageEnd );
+#ifdef _WIN32
+	VirtualFree( (void *)pageStart, pageEnd - pageStart, MEM_DECOMMIT );
+	VirtualAlloc( (void *)pageStart, pageEnd - pageStart, MEM_COMMIT, PAGE_READWRITE );
+#else
+	madvise( (void *)pageStart, pageEnd - pageStart, MADV_DONTNEED );
+#endif
 }
 
+void Sys_ReleasePages( void *data, uint64_t size )
+{
+	if ( !data ) {
+		return;
+	}
 #ifdef _WIN32
-#define WIN32_LEAN_AND_MEAN
-#include <windows.h>
+	VirtualFree( data, 0, MEM_RELEASE );
 #else
-#include <unistd.h>
-#include <sys/stat.h>
+	munmap( data, size );
 #endif
+}
 
 bool FolderExists( const char *name )
 {
@@ -1083,10 +1901,13 @@ uint64_t LoadFile( const char *filename, void **buffer )
     length = ftello64( fp );
     fseek( fp, 0L, SEEK_SET );
 
-    buf = GetMemory( length );
+    // always zero terminated, and an empty file is an empty string rather than a failed read
+    buf = GetMemory( length + 1 );
     *buffer = buf;
 
-    SafeRead( buf, length, fp );
+    if ( length ) {
+        SafeRead( buf, length, fp );
+    }
 
     fclose( fp );
 
@@ -1109,52 +1930,243 @@ void WriteFile( const char *filename, const void *buffer, uint64_t length )
 
 #endif
 
-void *GetMemory( uint64_t size )
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+
+/*
+===============================================================
+
+Tagged heap accounting: every thread keeps its own counters so an
+allocation never touches shared state, readers add them all up.
+Threads register once on their first allocation and hand their
+counts over to s_RetiredTags when they exit.
+
+===============================================================
+*/
+
+// only the owning thread writes its counters, readers on other threads load them relaxed
+typedef struct {
+    std::atomic<int64_t> bytes;
+    std::atomic<int64_t> liveBlocks;
+    std::atomic<uint64_t> totalAllocs;
+} memTagCounter_t;
+
+class CMemThreadTags
 {
-    void *buf;
+public:
+    CMemThreadTags( void );
+    ~CMemThreadTags();
 
-    buf = malloc( size );
-    if ( !buf ) {
-        Error( "GetMemory: memory request for %i bytes failed!", size );
+    memTagCounter_t m_Tags[NUM_MEMTAGS];
+    CMemThreadTags *m_pNext;
+};
+
+static std::mutex s_MemTagLock;
+static CMemThreadTags *s_pMemThreads;
+static memTagStats_t s_RetiredTags[NUM_MEMTAGS];
+static int64_t s_MemTagPeaks[NUM_MEMTAGS];
+static thread_local CMemThreadTags s_ThreadTags;
+
+static const char *s_MemTagNames[NUM_MEMTAGS] = {
+    "General",
+    "Map",
+    "Render",
+    "Undo",
+    "Texture",
+    "UI",
+    "Log"
+};
+
+CMemThreadTags::CMemThreadTags( void )
+{
+    std::lock_guard<std::mutex> lock{ s_MemTagLock };
+
+    for ( auto& it : m_Tags ) {
+        it.bytes.store( 0, std::memory_order_relaxed );
+        it.liveBlocks.store( 0, std::memory_order_relaxed );
+        it.totalAllocs.store( 0, std::memory_order_relaxed );
     }
+    m_pNext = s_pMemThreads;
+    s_pMemThreads = this;
+}
 
-    memset( buf, 0, size );
+CMemThreadTags::~CMemThreadTags()
+{
+    std::lock_guard<std::mutex> lock{ s_MemTagLock };
+    CMemThreadTags **it;
+    int i;
 
-    return buf;
+    for ( it = &s_pMemThreads; *it; it = &( *it )->m_pNext ) {
+        if ( *it == this ) {
+            *it = m_pNext;
+            break;
+        }
+    }
+    for ( i = 0; i < NUM_MEMTAGS; i++ ) {
+        s_RetiredTags[i].bytes += m_Tags[i].bytes.load( std::memory_order_relaxed );
+        s_RetiredTags[i].liveBlocks += m_Tags[i].liveBlocks.load( std::memory_order_relaxed );
+        s_RetiredTags[i].totalAllocs += m_Tags[i].totalAllocs.load( std::memory_order_relaxed );
+    }
 }
 
-#ifdef _WIN32
-#include <malloc.h>
-#else
-#include <malloc.h>
-#endif
+/*
+* memBlock_t: sits in front of every tracked block and keeps the size that was asked for, the heap's
+* usable size is often larger and a resize must only zero past what the caller could have written
+*/
+typedef struct alignas( alignof( std::max_align_t ) ) {
+    uint64_t size;
+} memBlock_t;
+
+static inline memBlock_t *Mem_Block( void *buf ) {
+    return (memBlock_t *)buf - 1;
+}
+
+static inline void Mem_Count( memtag_t tag, int64_t bytes, int64_t blocks )
+{
+    memTagCounter_t *counter;
+
+    counter = &s_ThreadTags.m_Tags[ (unsigned)tag < NUM_MEMTAGS ? tag : TAG_GENERAL ];
+    // a single writer, so a plain load and store is enough and keeps the allocation path free of locked instructions
+    counter->bytes.store( counter->bytes.load( std::memory_order_relaxed ) + bytes, std::memory_order_relaxed );
+    counter->liveBlocks.store( counter->liveBlocks.load( std::memory_order_relaxed ) + blocks, std::memory_order_relaxed );
+    if ( blocks > 0 ) {
+        counter->totalAllocs.store( counter->totalAllocs.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+    }
+}
+
+void *GetMemory( uint64_t size, memtag_t tag )
+{
+    memBlock_t *block;
+
+    // calloc gets big blocks straight from the OS already zeroed instead of writing every page
+    block = (memBlock_t *)calloc( 1, sizeof(*block) + size );
+    if ( !block ) {
+        Error( "GetMemory: memory request for %lu bytes failed!", size );
+    }
+    block->size = size;
 
-void *GetResizedMemory( void *ptr, uint64_t size )
+    Mem_Count( tag, size, 1 );
+
+    return block + 1;
+}
+
+/*
+* GetResizedMemory: realloc underneath so the block can grow in place when the heap allows it,
+* only the bytes past the old requested size are zeroed
+*/
+void *GetResizedMemory( void *ptr, uint64_t size, memtag_t tag )
 {
+    memBlock_t *block;
     uint64_t oldsize;
-    void *p;
 
-    p = GetMemory( size );
+    if ( !ptr ) {
+        return GetMemory( size, tag );
+    }
 
-    if ( ptr ) {
-#ifdef _WIN32
-        oldsize = _msize( ptr );
-#else
-        oldsize = malloc_usable_size( ptr );
-#endif
-        memcpy( p, ptr, size <= oldsize ? size : oldsize );
+    oldsize = Mem_Block( ptr )->size;
+    block = (memBlock_t *)realloc( Mem_Block( ptr ), sizeof(*block) + size );
+    if ( !block ) {
+        Error( "GetResizedMemory: memory request for %lu bytes failed!", size );
+    }
+    block->size = size;
 
-        free( ptr );
+    if ( size > oldsize ) {
+        memset( (byte *)( block + 1 ) + oldsize, 0, size - oldsize );
     }
+    Mem_Count( tag, (int64_t)size - (int64_t)oldsize, 0 );
 
-    return p;
+    return block + 1;
 }
 
-void FreeMemory( void *buf )
+void FreeMemory( void *buf, memtag_t tag )
 {
     if ( buf ) {
-        free( buf );
+        Mem_Count( tag, -(int64_t)Mem_Block( buf )->size, -1 );
+        free( Mem_Block( buf ) );
+    }
+}
+
+void *GetUntrackedMemory( uint64_t size )
+{
+    void *buf;
+
+    buf = calloc( 1, size );
+    if ( !buf ) {
+        Error( "GetUntrackedMemory: memory request for %lu bytes failed!", size );
+    }
+    return buf;
+}
+
+void FreeUntrackedMemory( void *buf )
+{
+    free( buf );
+}
+
+const char *Mem_TagName( memtag_t tag )
+{
+    return (unsigned)tag < NUM_MEMTAGS ? s_MemTagNames[tag] : "Unknown";
+}
+
+/*
+* Mem_GetTagStats: a block freed on another thread than it was allocated on shows up as a negative
+* count in one and a positive in the other, so only the sum means anything
+*/
+void Mem_GetTagStats( memTagStats_t stats[NUM_MEMTAGS] )
+{
+    std::lock_guard<std::mutex> lock{ s_MemTagLock };
+    const CMemThreadTags *it;
+    int i;
+
+    for ( i = 0; i < NUM_MEMTAGS; i++ ) {
+        stats[i].bytes = s_RetiredTags[i].bytes;
+        stats[i].liveBlocks = s_RetiredTags[i].liveBlocks;
+        stats[i].totalAllocs = s_RetiredTags[i].totalAllocs;
+    }
+    for ( it = s_pMemThreads; it; it = it->m_pNext ) {
+        for ( i = 0; i < NUM_MEMTAGS; i++ ) {
+            stats[i].bytes += it->m_Tags[i].bytes.load( std::memory_order_relaxed );
+            stats[i].liveBlocks += it->m_Tags[i].liveBlocks.load( std::memory_order_relaxed );
+            stats[i].totalAllocs += it->m_Tags[i].totalAllocs.load( std::memory_order_relaxed );
+        }
+    }
+    for ( i = 0; i < NUM_MEMTAGS; i++ ) {
+        stats[i].peakBytes = s_MemTagPeaks[i] > stats[i].bytes ? s_MemTagPeaks[i] : stats[i].bytes;
+    }
+}
+
+/*
+* Mem_SampleTags: peaks only move when this runs, the editor calls it once a frame
+*/
+void Mem_SampleTags( void )
+{
+    memTagStats_t stats[NUM_MEMTAGS];
+    int i;
+
+    Mem_GetTagStats( stats );
+
+    std::lock_guard<std::mutex> lock{ s_MemTagLock };
+    for ( i = 0; i < NUM_MEMTAGS; i++ ) {
+        s_MemTagPeaks[i] = stats[i].peakBytes;
+    }
+}
+
+void Mem_PrintTags( void (*print)( const char *fmt, ... ) )
+{
+    memTagStats_t stats[NUM_MEMTAGS];
+    int64_t total;
+    int i;
+
+    Mem_GetTagStats( stats );
+
+    total = 0;
+    print( "%-8s %14s %14s %10s %12s\n", "tag", "bytes", "peak", "blocks", "allocs" );
+    for ( i = 0; i < NUM_MEMTAGS; i++ ) {
+        print( "%-8s %14li %14li %10li %12lu\n", s_MemTagNames[i], stats[i].bytes, stats[i].peakBytes, stats[i].liveBlocks,
+            stats[i].totalAllocs );
+        total += stats[i].bytes;
     }
+    print( "%li bytes tracked\n", total );
 }
 
 #ifndef BFF_TOOL
@@ -1237,6 +2249,9 @@ uint64_t Com_GenerateHashValue( const char *fname, const uint64_t size )
 
 #ifndef BFF_TOOL
 static int s_hLogFile;
+
+// compression and loading workers print too
+static std::recursive_mutex s_LogLock;
 #endif
 
 extern "C" void Sys_FPrintf_VA( int level, const char *text, va_list args )
@@ -1249,6 +2264,8 @@ extern "C" void Sys_FPrintf_VA( int level, const char *text, va_list args )
 	const unsigned int length = strlen( buf );
 
 #ifndef BFF_TOOL
+	std::lock_guard<std::recursive_mutex> lock( s_LogLock );
+
 	if ( s_hLogFile ) {
 #ifdef _WIN32
 		_write( s_hLogFile, buf, length );
@@ -1433,13 +2450,14 @@ Parsing
 ===============================================================
 */
 
-static	char	com_token[MAX_TOKEN_CHARS];
-static	char	com_parsename[MAX_TOKEN_CHARS];
-static	uint64_t com_lines;
-static  uint64_t com_tokenline;
+// parse state is per-thread so maps can be parsed on worker threads
+static	thread_local char	com_token[MAX_TOKEN_CHARS];
+static	thread_local char	com_parsename[MAX_TOKEN_CHARS];
+static	thread_local uint64_t com_lines;
+static  thread_local uint64_t com_tokenline;
 
 // for complex parser
-tokenType_t		com_tokentype;
+thread_local tokenType_t		com_tokentype;
 
 void COM_BeginParseSession( const char *name )
 {
@@ -1468,7 +2486,7 @@ const char *COM_Parse( const char **data_p )
 void COM_ParseError( const char *format, ... )
 {
 	va_list argptr;
-	static char string[4096];
+	static thread_local char string[4096];
 
 	va_start( argptr, format );
 	vsprintf (string, format, argptr);
@@ -1480,7 +2498,7 @@ void COM_ParseError( const char *format, ... )
 void COM_ParseWarning( const char *format, ... )
 {
 	va_list argptr;
-	static char string[4096];
+	static thread_local char string[4096];
 
 	va_start( argptr, format );
 	vsprintf (string, format, argptr);
@@ -2083,6 +3101,9 @@ int Hex( char c )
 
 #define	HUNK_SENTINAL	0x1df001ed
 
+// only reserved up front, pages are committed as the hunk grows into them
+#define HUNK_RESERVE_SIZE ( 512 * 1024 * 1024 )
+
 typedef struct
 {
 	int		sentinal;
@@ -2099,6 +3120,79 @@ int		hunk_high_used;
 qboolean	hunk_tempactive;
 int		hunk_tempmark;
 
+// the marks assume strictly nested use, so only the thread that called Hunk_Init may touch the hunk
+static std::thread::id hunk_owner;
+
+/*
+==============
+Hunk_Init
+==============
+*/
+void Hunk_Init( void )
+{
+	hunk_base = (byte *)Sys_ReservePages( HUNK_RESERVE_SIZE );
+	hunk_size = HUNK_RESERVE_SIZE;
+	hunk_low_used = 0;
+	hunk_high_used = 0;
+	hunk_tempactive = qfalse;
+	hunk_owner = std::this_thread::get_id();
+
+	Log_Printf( "Hunk_Init: reserved %i MiB\n", hunk_size / ( 1024 * 1024 ) );
+}
+
+void Hunk_Shutdown( void )
+{
+	if ( !hunk_base ) {
+		return;
+	}
+	Sys_ReleasePages( hunk_base, hunk_size );
+	hunk_base = NULL;
+	hunk_size = 0;
+	hunk_low_used = 0;
+	hunk_high_used = 0;
+}
+
+/*
+==============
+Hunk_Available
+
+False before Hunk_Init and on any thread other than the one that owns the hunk,
+callers that can run on workers fall back to the heap then
+==============
+*/
+bool Hunk_Available( void )
+{
+	return hunk_base && std::this_thread::get_id() == hunk_owner;
+}
+
+void Hunk_GetUsage( int *lowUsed, int *highUsed, int *size )
+{
+	*lowUsed = hunk_low_used;
+	*highUsed = hunk_high_used;
+	*size = hunk_size;
+}
+
+/*
+==============
+Hunk_MemoryRemaining
+
+The largest single allocation that still fits, after its header and rounding
+==============
+*/
+uint64_t Hunk_MemoryRemaining( void )
+{
+	const int64_t remaining = (int64_t)hunk_size - hunk_low_used - hunk_high_used - (int64_t)sizeof(hunk_t) - 15;
+
+	return remaining > 0 ? (uint64_t)remaining : 0;
+}
+
+static void Hunk_CheckThread( const char *func )
+{
+	if ( !Hunk_Available() ) {
+		Error( "%s: hunk used before Hunk_Init or off of the main thread", func );
+	}
+}
+
 /*
 ==============
 Hunk_Check
@@ -2126,9 +3220,10 @@ Hunk_Print
 
 If "all" is specified, every single allocation is printed.
 Otherwise, allocations with the same name will be totaled up before printing.
+Output goes through print so the memory panel can draw it as well as the log.
 ==============
 */
-void Hunk_Print (qboolean all)
+void Hunk_Print( qboolean all, void (*print)( const char *fmt, ... ) )
 {
 	hunk_t	*h, *next, *endlow, *starthigh, *endhigh;
 	int		count, sum;
@@ -2145,8 +3240,8 @@ void Hunk_Print (qboolean all)
 	starthigh = (hunk_t *)(hunk_base + hunk_size - hunk_high_used);
 	endhigh = (hunk_t *)(hunk_base + hunk_size);
 
-	Log_Printf ("          :%8i total hunk size\n", hunk_size);
-	Log_Printf ("-------------------------\n");
+	print ("          :%8i total hunk size\n", hunk_size);
+	print ("-------------------------\n");
 
 	while (1)
 	{
@@ -2155,9 +3250,9 @@ void Hunk_Print (qboolean all)
 	//
 		if ( h == endlow )
 		{
-			Log_Printf ("-------------------------\n");
-			Log_Printf ("          :%8i REMAINING\n", hunk_size - hunk_low_used - hunk_high_used);
-			Log_Printf ("-------------------------\n");
+			print ("-------------------------\n");
+			print ("          :%8i REMAINING\n", hunk_size - hunk_low_used - hunk_high_used);
+			print ("-------------------------\n");
 			h = starthigh;
 		}
 		
@@ -2185,7 +3280,7 @@ void Hunk_Print (qboolean all)
 	//
 		memcpy (name, h->name, 8);
 		if (all)
-			Log_Printf ("%8p :%8i %8s\n",h, h->size, name);
+			print ("%8p :%8i %8s\n",h, h->size, name);
 			
 	//
 	// print the total
@@ -2194,7 +3289,7 @@ void Hunk_Print (qboolean all)
 		strncmp (h->name, next->name, 8) )
 		{
 			if (!all)
-				Log_Printf ("          :%8i %8s (TOTAL)\n",sum, name);
+				print ("          :%8i %8s (TOTAL)\n",sum, name);
 			count = 0;
 			sum = 0;
 		}
@@ -2202,8 +3297,8 @@ void Hunk_Print (qboolean all)
 		h = next;
 	}
 
-	Log_Printf ("-------------------------\n");
-	Log_Printf ("%8i total blocks\n", totalblocks);
+	print ("-------------------------\n");
+	print ("%8i total blocks\n", totalblocks);
 	
 }
 
@@ -2215,7 +3310,8 @@ Hunk_AllocName
 void *Hunk_AllocName( int size, const char *name )
 {
 	hunk_t	*h;
-	
+
+	Hunk_CheckThread( "Hunk_AllocName" );
 #if !defined(NDEBUG) || defined(_DEBUG)
 	Hunk_Check ();
 #endif
@@ -2261,7 +3357,8 @@ void Hunk_FreeToLowMark( int mark )
 	if ( mark < 0 || mark > hunk_low_used ) {
 		Error( "Hunk_FreeToLowMark: bad mark %i", mark );
     }
-	memset( hunk_base + mark, 0, hunk_low_used - mark );
+	// big loads give their pages back instead of being cleared by hand
+	Sys_ResetPages( hunk_base + mark, hunk_low_used - mark );
 	hunk_low_used = mark;
 }
 
@@ -2284,7 +3381,7 @@ void Hunk_FreeToHighMark( int mark )
 	if ( mark < 0 || mark > hunk_high_used ) {
 		Error( "Hunk_FreeToHighMark: bad mark %i", mark );
     }
-	memset( hunk_base + hunk_size - hunk_high_used, 0, hunk_high_used - mark );
+	Sys_ResetPages( hunk_base + hunk_size - hunk_high_used, hunk_high_used - mark );
 	hunk_high_used = mark;
 }
 
@@ -2301,6 +3398,7 @@ void *Hunk_HighAllocName( int size, const char *name )
 	if ( size < 0 ) {
 	    Error( "Hunk_HighAllocName: bad size: %i", size );
     }
+	Hunk_CheckThread( "Hunk_HighAllocName" );
 
 	if ( hunk_tempactive ) {
 		Hunk_FreeToHighMark( hunk_tempmark );
@@ -2358,5 +3456,166 @@ void *Hunk_TempAlloc( int size )
 	return buf;
 }
 
+/*
+=================
+LoadHunkFile
+
+LoadFile, but the buffer comes off the high hunk and is zero terminated, it goes away
+with the caller's Hunk_FreeToHighMark. Returns 0 and a NULL buffer on failure.
+=================
+*/
+uint64_t LoadHunkFile( const char *filename, void **buffer )
+{
+	uint64_t length;
+	FILE *fp;
+
+	*buffer = NULL;
+
+	fp = fopen( filename, "rb" );
+	if ( !fp ) {
+		Log_Printf( "failed to load file '%s' in read-only mode.\n", filename );
+		return 0;
+	}
+
+	fseek( fp, 0L, SEEK_END );
+	length = ftello64( fp );
+	fseek( fp, 0L, SEEK_SET );
+
+	if ( length + 1 > (uint64_t)( hunk_size - hunk_low_used - hunk_high_used ) ) {
+		Log_Printf( "LoadHunkFile: '%s' doesn't fit in the hunk\n", filename );
+		fclose( fp );
+		return 0;
+	}
+
+	*buffer = Hunk_HighAllocName( length + 1, "file" );
+	if ( !*buffer ) {
+		fclose( fp );
+		return 0;
+	}
+	( (char *)*buffer )[length] = '\0';
+	if ( length ) {
+		SafeRead( *buffer, length, fp );
+	}
+
+	fclose( fp );
+
+	return length;
+}
+
+
+/*
+===============================================================
+
+Frame arena: a bump allocator reset once per editor frame, for
+scratch data that would otherwise hit malloc every frame
+
+===============================================================
+*/
+
+typedef struct {
+    byte *base;
+    uint64_t size;
+    uint64_t used;
+    uint64_t lastFrame;
+    uint64_t peak;
+
+    // allocations that didn't fit, freed on the next reset
+    std::vector<void *> overflow;
+    uint64_t overflowBytes;
+    bool warned;
+
+    std::thread::id owner;
+} frameArena_t;
+
+static frameArena_t s_FrameArena;
+
+/*
+* Frame_Init: size is only reserved, pages get committed the first time a frame reaches them
+*/
+void Frame_Init( uint64_t size )
+{
+    s_FrameArena.base = (byte *)Sys_ReservePages( size );
+    s_FrameArena.size = size;
+    s_FrameArena.used = 0;
+    s_FrameArena.owner = std::this_thread::get_id();
+}
+
+void Frame_Shutdown( void )
+{
+    Frame_Reset();
+    Sys_ReleasePages( s_FrameArena.base, s_FrameArena.size );
+    s_FrameArena.base = NULL;
+    s_FrameArena.size = 0;
+}
+
+void Frame_Reset( void )
+{
+    s_FrameArena.lastFrame = s_FrameArena.used + s_FrameArena.overflowBytes;
+    if ( s_FrameArena.lastFrame > s_FrameArena.peak ) {
+        s_FrameArena.peak = s_FrameArena.lastFrame;
+    }
+
+    for ( auto *it : s_FrameArena.overflow ) {
+        FreeMemory( it );
+    }
+    s_FrameArena.overflow.clear();
+    s_FrameArena.overflowBytes = 0;
+    s_FrameArena.used = 0;
+}
+
+void *Frame_Alloc( uint64_t size )
+{
+    void *buf;
+
+    if ( std::this_thread::get_id() != s_FrameArena.owner ) {
+        Error( "Frame_Alloc: called outside of the main thread" );
+    }
+
+    size = ( size + 15 ) & ~15;
+    if ( s_FrameArena.used + size <= s_FrameArena.size ) {
+        buf = s_FrameArena.base + s_FrameArena.used;
+        s_FrameArena.used += size;
+        return buf;
+    }
+
+    if ( !s_FrameArena.warned ) {
+        Log_FPrintf( SYS_WRN, "WARNING: frame arena of %lu bytes exhausted, falling back to the heap\n", s_FrameArena.size );
+        s_FrameArena.warned = true;
+    }
+    buf = GetMemory( size );
+    s_FrameArena.overflow.emplace_back( buf );
+    s_FrameArena.overflowBytes += size;
+
+    return buf;
+}
+
+/*
+* Frame_Printf: like va(), but the string lasts for the whole frame instead of the next 8 calls
+*/
+const char *Frame_Printf( const char *fmt, ... )
+{
+    va_list argptr;
+    char *buf;
+    int length;
+
+    va_start( argptr, fmt );
+    length = vsnprintf( NULL, 0, fmt, argptr );
+    va_end( argptr );
+
+    buf = (char *)Frame_Alloc( length + 1 );
+
+    va_start( argptr, fmt );
+    vsnprintf( buf, length + 1, fmt, argptr );
+    va_end( argptr );
+
+    return buf;
+}
+
+void Frame_GetUsage( uint64_t *lastFrame, uint64_t *peak, uint64_t *capacity )
+{
+    *lastFrame = s_FrameArena.lastFrame;
+    *peak = s_FrameArena.peak;
+    *capacity = s_FrameArena.size;
+}
 
 #endif
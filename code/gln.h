@@ -15,6 +15,7 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <list>
 #include <unordered_map>
 #include "imgui.h"
 #include "imgui_internal.h"
@@ -60,9 +61,12 @@ FORCEINLINE void Swap( T& a, T& b ) {
 #define HEADER_MAGIC 0x5f3759df
 #define BFF_IDENT (('B'<<24)+('F'<<16)+('F'<<8)+'I')
 #define MAX_BFFPATH 256
-#define BFF_VERSION_MAJOR 0
-#define BFF_VERSION_MINOR 1
+#define BFF_VERSION_MAJOR 2
+#define BFF_VERSION_MINOR 0
 #define BFF_VERSION ((BFF_VERSION_MAJOR<<8)+BFF_VERSION_MINOR)
+#define BFF_VERSION_LEGACY ((0<<8)+1) // chunks stored back to back, no table of contents
+#define BFF_CHUNK_ALIGN 16
+#define BFF_MAX_CHUNK_SIZE (1LL<<31) // a table of contents asking for more than this to decompress into is damaged
 
 typedef struct
 {
@@ -81,15 +85,51 @@ typedef struct
 	int16_t version;
 } bffheader_t;
 
+/*
+* v2 archives follow the header with this, the chunk data sits between it and
+* the table of contents, which is written last:
+*   bfftoc_t toc[numChunks]
+*   int32_t hashTable[hashTableSize] (index into toc or -1, linear probing)
+*   char names[namesSize]
+*/
+typedef struct
+{
+	char bffGamename[MAX_BFFPATH];
+	int64_t tocOffset;
+	int64_t hashTableSize; // always a power of two
+	int64_t namesOffset; // relative to the start of the names block
+	int64_t namesSize;
+} bffindex_t;
+
+typedef struct
+{
+	uint64_t nameHash;
+	int64_t nameOffset;
+	int64_t fileofs;
+	int64_t size; // bytes stored in the file
+	int64_t uncompressedSize;
+	int64_t compression;
+} bfftoc_t;
+
 typedef struct
 {
 	char bffGamename[MAX_BFFPATH];
 	bffheader_t header;
 	
 	int64_t numChunks;
-	bff_chunk_t* chunkList;
+	bff_chunk_t* chunkList; // legacy archives hold everything here, v2 only caches decompressed chunks
+
+	// v2 only, everything points into the mapped file
+	const byte *mapping;
+	uint64_t mappingSize;
+	const bfftoc_t *toc;
+	const int32_t *hashTable;
+	const char *names;
+	int64_t hashTableSize;
 } bff_t;
 
+typedef struct bffwrite_s bffwrite_t;
+
 #define VALDEN_VERSION "1.1.0"
 #define VALDEN_ABOUTMSG "This is the official map/level editor for \"The Nomad\" game"
 
@@ -153,13 +193,45 @@ void DoTextEditor( const char *filename, int cursorpos );
 void ExitApp( void );
 void GLN_CheckAutoSave( void );
 void GLN_Init( void );
+void GLN_InitCompression( void );
+uint64_t Com_HashBuffer( const void *data, uint64_t size, uint64_t seed );
 qboolean GLN_LoadProject( const char *projectfile );
 
 void Sys_SetWindowTitle( const char *title );
 
-void *GetMemory( uint64_t size );
-void *GetResizedMemory( void *ptr, uint64_t size );
-void FreeMemory( void *ptr );
+/*
+* memtag_t: who a heap allocation belongs to, only used for accounting. A block has to be freed or resized
+* with the tag it was allocated with or the counts drift.
+*/
+typedef enum {
+    TAG_GENERAL,
+    TAG_MAP,
+    TAG_RENDER,
+    TAG_UNDO,
+    TAG_TEXTURE,
+    TAG_UI,
+    TAG_LOG,
+
+    NUM_MEMTAGS
+} memtag_t;
+
+typedef struct {
+    int64_t bytes;
+    int64_t peakBytes; // highest bytes seen by Mem_SampleTags
+    int64_t liveBlocks;
+    uint64_t totalAllocs;
+} memTagStats_t;
+
+void *GetMemory( uint64_t size, memtag_t tag = TAG_GENERAL );
+void *GetResizedMemory( void *ptr, uint64_t size, memtag_t tag = TAG_GENERAL );
+void FreeMemory( void *ptr, memtag_t tag = TAG_GENERAL );
+void *GetUntrackedMemory( uint64_t size );
+void FreeUntrackedMemory( void *ptr );
+
+const char *Mem_TagName( memtag_t tag );
+void Mem_SampleTags( void );
+void Mem_GetTagStats( memTagStats_t stats[NUM_MEMTAGS] );
+void Mem_PrintTags( void (*print)( const char *fmt, ... ) );
 
 qboolean ConfirmModified( void );
 
@@ -167,13 +239,30 @@ const char *va( const char *fmt, ... );
 char *CopyString( const char *str );
 
 double Sys_DoubleTime( void );
-void Sys_LoadAsset( const char *title, float *progress, const std::function<void( void )>& loadFunc );
+void Sys_ParallelFor( uint64_t count, const std::function<void( uint64_t )>& func );
+
+char *Compress( void *buf, uint64_t buflen, uint64_t *outlen, int compression );
+char *Decompress( void *buf, uint64_t buflen, uint64_t *outlen, int compression );
+char *CompressBlocks( const void *buf, uint64_t buflen, uint64_t blockSize, int compression, uint64_t *outlen, uint32_t *numBlocks,
+	const char **error = NULL );
+bool DecompressBlock( const void *buf, uint64_t buflen, void *out, uint64_t outlen, int compression );
+char *DecompressBlocks( const void *buf, uint64_t buflen, uint64_t blockSize, uint32_t numBlocks, uint64_t outlen, int compression );
 
 bff_t *bffOpenRead( const char *path );
-FILE *bffOpenWrite( const char *path, bffheader_t *h );
-void bffWriteChunk( const char *name, const void *data, int size, bffheader_t *h, FILE *fp );
+int64_t bffFindChunk( const bff_t *archive, const char *name );
+const void *bffGetChunk( bff_t *archive, const char *name, uint64_t *size );
+bffwrite_t *bffOpenWrite( const char *path, const char *gamename );
+void bffWriteChunk( bffwrite_t *archive, const char *name, const void *data, uint64_t size );
+bool bffCloseWrite( bffwrite_t *archive );
+bool bffPackFiles( const char *path, const char *gamename, const char *baseDir, const std::vector<std::string>& files );
 void bffClose( bff_t *archive );
 
+const void *Sys_MapFile( const char *path, uint64_t *size );
+void Sys_UnmapFile( const void *data, uint64_t size );
+void *Sys_ReservePages( uint64_t size );
+void Sys_ResetPages( void *data, uint64_t size );
+void Sys_ReleasePages( void *data, uint64_t size );
+
 bool Parse3DMatrix( const char **buf_p, int z, int y, int x, float *m );
 bool Parse2DMatrix( const char **buf_p, int y, int x, float *m );
 bool Parse1DMatrix( const char **buf_p, int x, float *m );
@@ -186,6 +275,12 @@ const char *COM_GetExtension( const char *name );
 uint64_t Com_GenerateHashValue( const char *fname, const uint64_t size );
 
 void Hunk_Init( void );
+void Hunk_Shutdown( void );
+bool Hunk_Available( void );
+void Hunk_Print( qboolean all, void (*print)( const char *fmt, ... ) );
+void Hunk_GetUsage( int *lowUsed, int *highUsed, int *size );
+uint64_t Hunk_MemoryRemaining( void );
+uint64_t LoadHunkFile( const char *filename, void **buffer );
 
 void *Hunk_Alloc( int size );
 void *Hunk_AllocName( int size, const char *name );
@@ -200,6 +295,14 @@ void Hunk_FreeToLowMark( int mark );
 int Hunk_HighMark( void );
 void Hunk_FreeToHighMark( int mark );
 
+// per-frame scratch memory for the main thread, everything in it is gone after the next Frame_Reset
+void Frame_Init( uint64_t size );
+void Frame_Shutdown( void );
+void Frame_Reset( void );
+void *Frame_Alloc( uint64_t size );
+const char *Frame_Printf( const char *fmt, ... );
+void Frame_GetUsage( uint64_t *lastFrame, uint64_t *peak, uint64_t *capacity );
+
 #define IMAGE_FILEDLG_FILTERS \
 	".jpg,.jpeg,.png,.bmp,.tga,.webp," \
 	"Jpeg Files (*.jpeg *.jpg){.jpeg,.jpg}," \
@@ -228,7 +331,7 @@ typedef enum {
 	TK_EOF,
 } tokenType_t;
 
-extern tokenType_t com_tokentype;
+extern thread_local tokenType_t com_tokentype;
 
 #define MAX_TOKEN_CHARS 1024
 
@@ -287,20 +390,21 @@ typedef enum
 #undef new
 #undef delete
 
+// the C++ runtime frees some blocks it allocated itself through these, so they can't be tracked
 inline void *operator new( size_t sz ) {
-    return GetMemory( sz );
+    return GetUntrackedMemory( sz );
 }
 
 inline void *operator new[]( size_t sz ) {
-    return GetMemory( sz );
+    return GetUntrackedMemory( sz );
 }
 
 inline void operator delete( void *ptr ) {
-    FreeMemory( ptr );
+    FreeUntrackedMemory( ptr );
 }
 
 inline void operator delete[]( void *ptr, size_t ) {
-    FreeMemory( ptr );
+    FreeUntrackedMemory( ptr );
 }
 #endif
 
@@ -312,4 +416,67 @@ using Reference = std::shared_ptr<T>;
 template<typename T>
 using Ref = std::shared_ptr<T>;
 
+/*
+* CFrameAllocator: hands STL containers memory from the frame arena, nothing is ever freed
+* so a container using it must not outlive the frame it was made in
+*/
+template<typename T>
+class CFrameAllocator
+{
+public:
+    typedef T value_type;
+
+    CFrameAllocator( void ) = default;
+    template<typename U>
+    CFrameAllocator( const CFrameAllocator<U>& ) { }
+
+    T *allocate( size_t n ) {
+        return (T *)Frame_Alloc( sizeof(T) * n );
+    }
+    void deallocate( T *, size_t ) {
+    }
+
+    template<typename U>
+    bool operator==( const CFrameAllocator<U>& ) const { return true; }
+    template<typename U>
+    bool operator!=( const CFrameAllocator<U>& ) const { return false; }
+};
+
+template<typename T>
+using FrameVector = std::vector<T, CFrameAllocator<T>>;
+
+/*
+* CTagAllocator: puts an STL container's storage on the books under tag
+*/
+template<typename T, memtag_t tag>
+class CTagAllocator
+{
+public:
+    typedef T value_type;
+
+    template<typename U>
+    struct rebind {
+        typedef CTagAllocator<U, tag> other;
+    };
+
+    CTagAllocator( void ) = default;
+    template<typename U>
+    CTagAllocator( const CTagAllocator<U, tag>& ) { }
+
+    T *allocate( size_t n ) {
+        return (T *)GetMemory( sizeof(T) * n, tag );
+    }
+    void deallocate( T *ptr, size_t ) {
+        FreeMemory( ptr, tag );
+    }
+
+    template<typename U>
+    bool operator==( const CTagAllocator<U, tag>& ) const { return true; }
+    template<typename U>
+    bool operator!=( const CTagAllocator<U, tag>& ) const { return false; }
+};
+
+template<typename T, memtag_t tag>
+using TagVector = std::vector<T, CTagAllocator<T, tag>>;
+
 #endif
\ No newline at end of file
@@ -85,6 +85,10 @@ typedef enum { qfalse = 0, qtrue = 1 } qboolean;
 // the minimum size in bytes a lump should be before compressing it
 #define COMPRESSED_LUMP_SIZE (4*1024*1024)
 
+// compressed lumps are split into blocks of this many (uncompressed) bytes,
+// each one can be decompressed on its own
+#define LUMP_BLOCK_SIZE (1024*1024)
+
 #define COMPRESS_NONE 0
 #define COMPRESS_ZLIB 1
 #define COMPRESS_BZIP2 2
@@ -117,9 +121,21 @@ typedef enum {
 
 typedef struct {
     uint64_t fileofs;
-    uint64_t length;
+    uint64_t length; // uncompressed length
+    uint64_t compressedLength; // bytes on disk (block table included), same as length if stored raw
+    uint32_t compression; // COMPRESS_NONE, COMPRESS_ZLIB or COMPRESS_BZIP2
+    uint32_t numBlocks; // 0 if stored raw
 } lump_t;
 
+//
+// lumpblock_t: a compressed lump begins with numBlocks of these, every block
+// except the last one decompresses to exactly LUMP_BLOCK_SIZE bytes
+//
+typedef struct {
+    uint64_t fileofs; // relative to the start of the lump
+    uint64_t length; // compressed length
+} lumpblock_t;
+
 #define TEX2D_IDENT (('D'<<16)+('2'<<8)+'T')
 #define TEX2D_VERSION 1
 
@@ -328,7 +344,7 @@ typedef struct {
 } mapheader_t;
 
 #define LEVEL_IDENT (('M'<<24)+('F'<<16)+('F'<<8)+'B')
-#define LEVEL_VERSION 0
+#define LEVEL_VERSION 1
 
 typedef struct {
     uint32_t ident;
@@ -65,12 +65,10 @@ void CMapRenderer::OnUpdate( float timestep ) {
 
     ImGui::End();
     */
-//    m_RenderThread = std::thread( &CMapRenderer::DrawMap, this );
 }
 
 void CMapRenderer::OnUIRender( void ) {
     DrawMap();
-//    m_RenderThread.join();
 }
 
 static void WorldToGL( const glm::vec2& pos, Vertex *vertices )
@@ -90,30 +88,32 @@ static void WorldToGL( const glm::vec2& pos, Vertex *vertices )
     }
 }
 
-static GLint GetUniform( const std::string& name )
+static GLint GetUniform( const char *name )
 {
+    const uint64_t hash = Com_HashBuffer( name, strlen( name ), 0 );
     GLint location;
 
-    auto it = g_pMapDrawer->m_UniformCache.find( name );
-    if ( it != g_pMapDrawer->m_UniformCache.end() ) {
-        if ( it->second == -1 ) { // try again
-            location = glGetUniformLocation( g_pMapDrawer->m_Shader, name.c_str() );
+    const auto range = g_pMapDrawer->m_UniformCache.equal_range( hash );
+    for ( auto it = range.first; it != range.second; ++it ) {
+        if ( strcmp( it->second.name.c_str(), name ) ) {
+            continue;
+        }
+        if ( it->second.location == -1 ) { // try again
+            location = glGetUniformLocation( g_pMapDrawer->m_Shader, name );
             if ( location == -1 ) {
                 return -1;
             }
-            it->second = location;
-            return location;
-        } else {
-            return it->second;
+            it->second.location = location;
         }
+        return it->second.location;
     }
 
-    location = glGetUniformLocation( g_pMapDrawer->m_Shader, name.c_str() );
+    location = glGetUniformLocation( g_pMapDrawer->m_Shader, name );
     if ( location == -1 ) {
-        Log_Printf( "WARNING: Failed to get uniform location of '%s'\n", name.c_str() );
+        Log_Printf( "WARNING: Failed to get uniform location of '%s'\n", name );
     }
 
-    g_pMapDrawer->m_UniformCache[name] = location;
+    g_pMapDrawer->m_UniformCache.emplace( hash, CMapRenderer::uniformSlot_t{ name, location } );
     return location;
 }
 
@@ -149,21 +149,22 @@ struct GPULight {
 void CMapRenderer::DrawMap( void )
 {
     uint32_t y, x;
-    uint32_t i;
+    uint32_t i, numLights;
     float width;
     glm::vec2 pos;
     Vertex *vtx;
     GPULight tempLight;
     const ImGuiViewport *view;
+    uint64_t numQuads, quad;
+    int32_t sprite;
 
     if ( !mapData ) {
         return;
     }
-    /*
+    // a new map, or one whose tileset failed to build, has nothing to draw with
     if ( !mapData->textures[Walnut::TB_DIFFUSEMAP] || !mapData->texcoords ) {
         return;
     }
-    */
 
     m_Projection = glm::ortho( -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f );
     const glm::mat4 transpose = glm::translate( glm::mat4( 1.0f ), m_CameraPos )
@@ -196,9 +197,12 @@ void CMapRenderer::DrawMap( void )
     glUniform1i( GetUniform( "u_UseAmbientOcclusionMapping" ), mapData->textures[Walnut::TB_SHADOWMAP] ? 1 : 0 );
     glUniform3f( GetUniform( "u_CameraPos" ), m_CameraPos.x, m_CameraPos.y, m_CameraPos.z );
 
-    glUniform1i( GetUniform( "u_NumLights" ), mapData->numLights );
+    glUniform1i( GetUniform( "u_NumLights" ), mapData->lightSlots.numUsed );
     glBindBuffer( GL_UNIFORM_BUFFER, m_LightBuffer );
-    for ( i = 0; i < mapData->numLights; i++ ) {
+    for ( i = 0, numLights = 0; i < mapData->lightSlots.numSlots; i++ ) {
+        if ( !mapData->lightSlots.used[i] ) {
+            continue;
+        }
         memcpy( tempLight.color, mapData->lights[i].color, sizeof( vec4_t ) );
         tempLight.origin[0] = mapData->lights[i].origin[0];
         tempLight.origin[1] = mapData->lights[i].origin[1];
@@ -209,7 +213,7 @@ void CMapRenderer::DrawMap( void )
         tempLight.quadratic = mapData->lights[i].quadratic;
         tempLight.range = mapData->lights[i].range;
 
-        glBufferSubData( GL_UNIFORM_BUFFER, sizeof( GPULight ) * i, sizeof( GPULight ), &tempLight );
+        glBufferSubData( GL_UNIFORM_BUFFER, sizeof( GPULight ) * numLights++, sizeof( GPULight ), &tempLight );
     }
     glBindBuffer( GL_UNIFORM_BUFFER, 0 );
 
@@ -247,9 +251,15 @@ void CMapRenderer::DrawMap( void )
 
             WorldToGL( pos, vtx );
 
+            // tiles imported against a bigger tileset may point past this one
+            sprite = mapData->tiles.index[y * mapData->width + x];
+            if ( sprite < 0 || (uint32_t)sprite >= mapData->tileset.numTiles ) {
+                sprite = -1;
+            }
+
             for ( i = 0; i < 4; i++ ) {
-                vtx[i].uv[0] = mapData->texcoords[mapData->tiles[y * mapData->width + x].index][i][0];
-                vtx[i].uv[1] = mapData->texcoords[mapData->tiles[y * mapData->width + x].index][i][1];
+                vtx[i].uv[0] = sprite != -1 ? mapData->texcoords[sprite][i][0] : 0.0f;
+                vtx[i].uv[1] = sprite != -1 ? mapData->texcoords[sprite][i][1] : 0.0f;
 
                 vtx[i].worldPos[0] = x;
                 vtx[i].worldPos[1] = y;
@@ -268,9 +278,30 @@ void CMapRenderer::DrawMap( void )
             vtx += 4;
         }
     }
-    glBufferSubData( GL_ARRAY_BUFFER, 0, sizeof(Vertex) * mapData->width * mapData->height * 4, m_pVertices );
-    glBufferSubData( GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(uint32_t) * mapData->width * mapData->height * 6, m_pIndices );
-    glDrawElements( GL_TRIANGLES, mapData->width * mapData->height * 6, GL_UNSIGNED_INT, NULL );
+    numQuads = mapData->width * mapData->height;
+    if ( numQuads > m_nIndexedQuads ) {
+        for ( quad = m_nIndexedQuads; quad < numQuads; quad++ ) {
+            m_pIndices[quad * 6 + 0] = quad * 4 + 0;
+            m_pIndices[quad * 6 + 1] = quad * 4 + 1;
+            m_pIndices[quad * 6 + 2] = quad * 4 + 2;
+
+            m_pIndices[quad * 6 + 3] = quad * 4 + 3;
+            m_pIndices[quad * 6 + 4] = quad * 4 + 2;
+            m_pIndices[quad * 6 + 5] = quad * 4 + 0;
+        }
+        glBufferSubData( GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * m_nIndexedQuads * 6, sizeof(uint32_t) * ( numQuads - m_nIndexedQuads ) * 6,
+            &m_pIndices[m_nIndexedQuads * 6] );
+        m_nIndexedQuads = numQuads;
+    }
+
+    glBufferSubData( GL_ARRAY_BUFFER, 0, sizeof(Vertex) * numQuads * 4, m_pVertices );
+    glDrawElements( GL_TRIANGLES, numQuads * 6, GL_UNSIGNED_INT, NULL );
+
+    // switched to a smaller map, hand the vertex pages the old one used back to the OS
+    if ( numQuads < m_nVertexHighWater ) {
+        Sys_ResetPages( &m_pVertices[numQuads * 4], sizeof(Vertex) * ( m_nVertexHighWater - numQuads ) * 4 );
+    }
+    m_nVertexHighWater = numQuads;
 
     if ( mapData->textures[Walnut::TB_NORMALMAP] ) {
         glActiveTexture( GL_TEXTURE1 );
@@ -373,7 +404,6 @@ static void CheckFramebuffer( void )
 
 void CMapRenderer::OnAttach( void )
 {
-    uint32_t i, offset;
     GLuint vertShader;
     GLuint fragShader;
 
@@ -386,22 +416,12 @@ void CMapRenderer::OnAttach( void )
     m_nCameraRotation = 0.0f;
     m_nCameraZoom = 9.5f;
 
-    m_pVertices = (Vertex *)GetMemory( sizeof(Vertex) * MAX_MAP_WIDTH * MAX_MAP_HEIGHT * 4 );
-    m_pIndices = (uint32_t *)GetMemory( sizeof(uint32_t) * MAX_MAP_WIDTH * MAX_MAP_HEIGHT * 6 );
-
-    offset = 0;
-    const uint32_t maxIndices = MAX_MAP_WIDTH * MAX_MAP_HEIGHT * 6;
-    for ( i = 0; i < maxIndices; i += 6 ) {
-        m_pIndices[i + 0] = offset + 0;
-        m_pIndices[i + 1] = offset + 1;
-        m_pIndices[i + 2] = offset + 2;
-
-        m_pIndices[i + 3] = offset + 3;
-        m_pIndices[i + 4] = offset + 2;
-        m_pIndices[i + 5] = offset + 0;
-
-        offset += 4;
-    }
+    // sized for the largest map but only the pages the current map draws into get committed,
+    // indices are generated as bigger maps show up
+    m_pVertices = (Vertex *)Sys_ReservePages( sizeof(Vertex) * MAX_MAP_WIDTH * MAX_MAP_HEIGHT * 4 );
+    m_pIndices = (uint32_t *)Sys_ReservePages( sizeof(uint32_t) * MAX_MAP_WIDTH * MAX_MAP_HEIGHT * 6 );
+    m_nIndexedQuads = 0;
+    m_nVertexHighWater = 0;
 
     glGenBuffers( 1, &m_LightBuffer );
     glBindBuffer( GL_UNIFORM_BUFFER, m_LightBuffer );
@@ -488,8 +508,8 @@ void CMapRenderer::OnAttach( void )
 
 void CMapRenderer::OnDetach( void )
 {
-    FreeMemory( m_pVertices );
-    FreeMemory( m_pIndices );
+    Sys_ReleasePages( m_pVertices, sizeof(Vertex) * MAX_MAP_WIDTH * MAX_MAP_HEIGHT * 4 );
+    Sys_ReleasePages( m_pIndices, sizeof(uint32_t) * MAX_MAP_WIDTH * MAX_MAP_HEIGHT * 6 );
 
     glDeleteBuffers( 1, &m_LightBuffer );
     glDeleteBuffers( 1, &m_VertexBuffer );
@@ -36,14 +36,20 @@ public:
 
     void DrawMap( void );
 
-    std::unordered_map<std::string, GLint> m_UniformCache;
-    std::thread m_RenderThread;
-    std::mutex m_RenderLock;
+    typedef struct {
+        std::string name;
+        GLint location;
+    } uniformSlot_t;
+
+    // keyed by name hash so lookups don't build a std::string, the stored name tells colliding uniforms apart
+    std::unordered_multimap<uint64_t, uniformSlot_t> m_UniformCache;
 
     void *m_pIconBuf;
 
     Vertex *m_pVertices;
     uint32_t *m_pIndices;
+    uint64_t m_nIndexedQuads; // how much of m_pIndices has been generated and uploaded
+    uint64_t m_nVertexHighWater; // quads written into m_pVertices by the last frame
 
     int m_nTileSelectX;
     int m_nTileSelectY;
@@ -79,7 +85,7 @@ public:
     GLuint m_ColorBuffer;
     GLuint m_DepthBuffer;
 
-    static inline std::vector<char> g_CommandConsoleString;
+    static inline TagVector<char, TAG_LOG> g_CommandConsoleString;
 };
 
 extern std::shared_ptr<CMapRenderer> g_pMapDrawer;
@@ -9,7 +9,7 @@ CInfoDataDlg::CInfoDataDlg( void )
 
 void CInfoDataDlg::CreateLevelData( void )
 {
-    m_LevelDatas.emplace_back( GetMemory( sizeof( levelData_t ) ) );
+    m_LevelDatas.emplace_back( GetMemory( sizeof( levelData_t ), TAG_UI ) );
     m_pCurrent = m_LevelDatas.end() - 1;
 
     g_pMapInfoDlg->SetModified( true, false );
@@ -0,0 +1,314 @@
+#include "editor.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+typedef struct {
+    jobFunc_t func;
+    jobGroup_t *group;
+    jobPriority_t priority;
+} job_t;
+
+typedef struct {
+    std::mutex lock;
+    std::deque<job_t> jobs[NUM_JOB_PRIORITIES];
+} jobQueue_t;
+
+/*
+* jobPool_t: lives on the heap rather than in a static so exiting through Error() with jobs in
+* flight doesn't run destructors on threads and mutexes the workers are still using
+*/
+typedef struct {
+    std::thread *threads;
+    jobQueue_t *queues; // one per worker, or a single one nobody owns with no workers
+    int numWorkers;
+    int numQueues;
+
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    std::atomic<int> queued[NUM_JOB_PRIORITIES];
+    std::atomic<int> active;
+    std::atomic<uint32_t> nextQueue;
+    std::atomic<bool> quit;
+
+    std::mutex mainLock;
+    std::vector<jobFunc_t> mainTasks;
+} jobPool_t;
+
+static jobPool_t *s_pJobs;
+static thread_local int s_nWorkerIndex = -1;
+static thread_local jobPriority_t s_nCurrentPriority = JOB_PRIORITY_INTERACTIVE;
+
+static int Job_TotalQueued( void )
+{
+    int total;
+
+    total = 0;
+    for ( int i = 0; i < NUM_JOB_PRIORITIES; i++ ) {
+        total += s_pJobs->queued[i].load( std::memory_order_relaxed );
+    }
+    return total;
+}
+
+/*
+* Job_Take: pulls the most urgent job it can find, the caller's own queue first
+*/
+static bool Job_Take( job_t *out )
+{
+    const int self = s_nWorkerIndex;
+
+    for ( int p = 0; p < NUM_JOB_PRIORITIES; p++ ) {
+        if ( !s_pJobs->queued[p].load( std::memory_order_relaxed ) ) {
+            continue;
+        }
+
+        if ( self != -1 ) {
+            jobQueue_t *queue = &s_pJobs->queues[self];
+            std::lock_guard<std::mutex> lock{ queue->lock };
+
+            if ( !queue->jobs[p].empty() ) {
+                *out = std::move( queue->jobs[p].back() );
+                queue->jobs[p].pop_back();
+                s_pJobs->queued[p]--;
+                return true;
+            }
+        }
+
+        for ( int i = 1; i <= s_pJobs->numQueues; i++ ) {
+            jobQueue_t *queue = &s_pJobs->queues[ ( self + i + s_pJobs->numQueues ) % s_pJobs->numQueues ];
+            std::lock_guard<std::mutex> lock{ queue->lock };
+
+            if ( !queue->jobs[p].empty() ) {
+                *out = std::move( queue->jobs[p].front() );
+                queue->jobs[p].pop_front();
+                s_pJobs->queued[p]--;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+static void Job_Run( job_t& job )
+{
+    const jobPriority_t oldPriority = s_nCurrentPriority;
+
+    s_pJobs->active++;
+    s_nCurrentPriority = job.priority;
+    if ( !job.group || !job.group->cancelled.load( std::memory_order_relaxed ) ) {
+        job.func();
+    }
+    s_nCurrentPriority = oldPriority;
+    s_pJobs->active--;
+
+    if ( job.group && job.group->pending.fetch_sub( 1, std::memory_order_acq_rel ) == 1 ) {
+        // whoever is sitting in Job_Wait on this group
+        std::lock_guard<std::mutex> lock{ s_pJobs->sleepLock };
+        s_pJobs->wake.notify_all();
+    }
+}
+
+static void Job_WorkerLoop( int index )
+{
+    job_t job;
+
+    s_nWorkerIndex = index;
+    while ( !s_pJobs->quit.load( std::memory_order_relaxed ) ) {
+        if ( Job_Take( &job ) ) {
+            Job_Run( job );
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock{ s_pJobs->sleepLock };
+        s_pJobs->wake.wait( lock, []( void ) { return s_pJobs->quit.load() || Job_TotalQueued() > 0; } );
+    }
+}
+
+void Job_Init( int numThreads )
+{
+    if ( s_pJobs ) {
+        return;
+    }
+
+    if ( numThreads <= 0 ) {
+        numThreads = (int)std::thread::hardware_concurrency() - 1;
+    }
+    if ( numThreads < 0 ) {
+        numThreads = 0;
+    }
+
+    s_pJobs = new jobPool_t;
+    for ( int i = 0; i < NUM_JOB_PRIORITIES; i++ ) {
+        s_pJobs->queued[i] = 0;
+    }
+    s_pJobs->active = 0;
+    s_pJobs->nextQueue = 0;
+    s_pJobs->quit = false;
+    s_pJobs->numWorkers = numThreads;
+    s_pJobs->numQueues = numThreads > 0 ? numThreads : 1;
+    s_pJobs->queues = new jobQueue_t[ s_pJobs->numQueues ];
+    s_pJobs->threads = new std::thread[ numThreads ];
+
+    for ( int i = 0; i < numThreads; i++ ) {
+        s_pJobs->threads[i] = std::thread( Job_WorkerLoop, i );
+    }
+
+    Log_Printf( "Job system started with %i worker threads\n", numThreads );
+}
+
+/*
+* Job_Shutdown: stops the workers after their current job, anything still queued is dropped
+* without running and continuations that never got their frame are discarded
+*/
+void Job_Shutdown( void )
+{
+    if ( !s_pJobs ) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{ s_pJobs->sleepLock };
+        s_pJobs->quit = true;
+        s_pJobs->wake.notify_all();
+    }
+    for ( int i = 0; i < s_pJobs->numWorkers; i++ ) {
+        s_pJobs->threads[i].join();
+    }
+
+    delete[] s_pJobs->threads;
+    delete[] s_pJobs->queues;
+    delete s_pJobs;
+    s_pJobs = NULL;
+}
+
+/*
+* Job_Add: queues func to run on the pool. Jobs added from a worker go on that worker's own
+* queue so nested work stays warm in its cache, everything else is spread round robin. group
+* may be NULL for fire and forget work.
+*/
+void Job_Add( jobGroup_t *group, jobPriority_t priority, jobFunc_t func )
+{
+    jobQueue_t *queue;
+
+    if ( group ) {
+        group->pending.fetch_add( 1, std::memory_order_relaxed );
+    }
+
+    if ( !s_pJobs ) {
+        // headless tools that never started the pool
+        if ( !group || !group->cancelled.load() ) {
+            func();
+        }
+        if ( group ) {
+            group->pending--;
+        }
+        return;
+    }
+
+    if ( s_nWorkerIndex != -1 ) {
+        queue = &s_pJobs->queues[ s_nWorkerIndex ];
+    } else {
+        queue = &s_pJobs->queues[ s_pJobs->nextQueue++ % s_pJobs->numQueues ];
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{ queue->lock };
+        queue->jobs[priority].push_back( job_t{ std::move( func ), group, priority } );
+    }
+    s_pJobs->queued[priority]++;
+
+    {
+        std::lock_guard<std::mutex> lock{ s_pJobs->sleepLock };
+    }
+    s_pJobs->wake.notify_one();
+}
+
+/*
+* Job_Wait: blocks until every job in group has finished, running queued jobs on the calling
+* thread in the meantime so waiting from inside a job can't starve the pool
+*/
+void Job_Wait( jobGroup_t *group )
+{
+    job_t job;
+
+    while ( group->pending.load( std::memory_order_acquire ) > 0 ) {
+        if ( s_pJobs && Job_Take( &job ) ) {
+            Job_Run( job );
+            continue;
+        }
+        if ( !s_pJobs ) {
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock{ s_pJobs->sleepLock };
+        s_pJobs->wake.wait( lock, [group]( void ) {
+            return group->pending.load( std::memory_order_acquire ) <= 0 || Job_TotalQueued() > 0;
+        } );
+    }
+}
+
+void Job_Cancel( jobGroup_t *group ) {
+    group->cancelled = true;
+}
+
+bool Job_Cancelled( const jobGroup_t *group ) {
+    return group->cancelled.load( std::memory_order_relaxed );
+}
+
+bool Job_Done( const jobGroup_t *group ) {
+    return group->pending.load( std::memory_order_acquire ) <= 0;
+}
+
+void Job_RunOnMainThread( jobFunc_t func )
+{
+    if ( !s_pJobs ) {
+        func();
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock{ s_pJobs->mainLock };
+    s_pJobs->mainTasks.emplace_back( std::move( func ) );
+}
+
+/*
+* Job_RunMainThreadTasks: called once a frame by the application, tasks queued while these run
+* wait for the next frame
+*/
+void Job_RunMainThreadTasks( void )
+{
+    std::vector<jobFunc_t> tasks;
+
+    if ( !s_pJobs ) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{ s_pJobs->mainLock };
+        tasks.swap( s_pJobs->mainTasks );
+    }
+    for ( auto& it : tasks ) {
+        it();
+    }
+}
+
+int Job_NumWorkers( void ) {
+    return s_pJobs ? s_pJobs->numWorkers : 0;
+}
+
+int Job_QueueDepth( jobPriority_t priority ) {
+    return s_pJobs ? s_pJobs->queued[priority].load( std::memory_order_relaxed ) : 0;
+}
+
+int Job_ActiveJobs( void ) {
+    return s_pJobs ? s_pJobs->active.load( std::memory_order_relaxed ) : 0;
+}
+
+bool Job_IsWorker( void ) {
+    return s_nWorkerIndex != -1;
+}
+
+jobPriority_t Job_CurrentPriority( void ) {
+    return s_nCurrentPriority;
+}
@@ -0,0 +1,60 @@
+#ifndef __JOBS__
+#define __JOBS__
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+
+/*
+===============================================================
+
+Job system: one pool of worker threads shared by everything the
+editor does in the background. Each worker owns a deque per
+priority, it pops its own work newest first and steals from the
+other workers oldest first once it runs dry.
+
+===============================================================
+*/
+
+typedef enum {
+    JOB_PRIORITY_INTERACTIVE, // the user is waiting on it, always taken before background work
+    JOB_PRIORITY_BACKGROUND,
+
+    NUM_JOB_PRIORITIES
+} jobPriority_t;
+
+/*
+* jobGroup_t: counts the jobs added against it that haven't finished yet, doubles as the
+* cancellation token for them. Cancelled jobs that haven't started are dropped, ones already
+* running should poll Job_Cancelled and bail out early. A group must outlive its jobs.
+*/
+typedef struct jobGroup_s {
+    std::atomic<int> pending{ 0 };
+    std::atomic<bool> cancelled{ false };
+} jobGroup_t;
+
+typedef std::function<void( void )> jobFunc_t;
+
+// numThreads <= 0 uses one less than the number of cores, the main thread makes up the rest
+void Job_Init( int numThreads );
+void Job_Shutdown( void );
+
+void Job_Add( jobGroup_t *group, jobPriority_t priority, jobFunc_t func );
+void Job_Wait( jobGroup_t *group );
+void Job_Cancel( jobGroup_t *group );
+bool Job_Cancelled( const jobGroup_t *group );
+bool Job_Done( const jobGroup_t *group );
+
+// continuations, run at the top of the next frame on the main thread
+void Job_RunOnMainThread( jobFunc_t func );
+void Job_RunMainThreadTasks( void );
+
+// instrumentation
+int Job_NumWorkers( void );
+int Job_QueueDepth( jobPriority_t priority );
+int Job_ActiveJobs( void );
+bool Job_IsWorker( void );
+jobPriority_t Job_CurrentPriority( void );
+
+#endif
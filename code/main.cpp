@@ -196,6 +196,7 @@ int valdenMain( int argc, char **argv )
 	g_strBitmapsDir = "bitmaps/";
 
 	std::string tempPath;
+	int parm;
 
 #ifdef __unix__
     signal( SIGSEGV, signalCatcher );
@@ -237,6 +238,59 @@ int valdenMain( int argc, char **argv )
 	loki_init_datapath( argv[0] );
 #endif
 
+	myargc = argc;
+	myargv = argv;
+
+	// build every level in a project and exit, doesn't need a display
+	if ( ( parm = CheckParm( "-compileproject" ) ) != -1 ) {
+		if ( parm + 1 >= argc ) {
+			Log_Printf( "usage: %s -compileproject <project directory> [-compression none|zlib|bzip2]\n", argv[0] );
+			return -1;
+		}
+		GLN_InitCompression();
+		Job_Init( 0 );
+		parm = Map_CompileProject( argv[parm + 1] ) ? 0 : 1;
+		Job_Shutdown();
+		return parm;
+	}
+
+	// pack a directory tree into a .bff archive and exit
+	if ( ( parm = CheckParm( "-packarchive" ) ) != -1 ) {
+		std::vector<std::string> files;
+		std::string gamename;
+
+		if ( parm + 2 >= argc ) {
+			Log_Printf( "usage: %s -packarchive <directory> <archive.bff> [-compression none|zlib|bzip2]\n", argv[0] );
+			return -1;
+		}
+		GLN_InitCompression();
+
+		try {
+			// the archive may be written inside the tree it packs, a previous build of it mustn't end up in the new one
+			const std::filesystem::path output = std::filesystem::weakly_canonical( argv[parm + 2] );
+
+			gamename = std::filesystem::canonical( argv[parm + 1] ).filename().string();
+			for ( const auto& it : std::filesystem::recursive_directory_iterator{ argv[parm + 1] } ) {
+				if ( !it.is_regular_file() ) {
+					continue;
+				}
+				if ( it.path().filename() == output.filename() && std::filesystem::weakly_canonical( it.path() ) == output ) {
+					continue;
+				}
+				files.emplace_back( it.path().string() );
+			}
+		} catch ( const std::filesystem::filesystem_error& e ) {
+			Log_Printf( "ERROR: failed to scan '%s', what: %s\n", argv[parm + 1], e.what() );
+			return 1;
+		}
+		std::sort( files.begin(), files.end() );
+
+		Job_Init( 0 );
+		parm = bffPackFiles( argv[parm + 2], gamename.c_str(), argv[parm + 1], files ) ? 0 : 1;
+		Job_Shutdown();
+		return parm;
+	}
+
     if ( SDL_Init( SDL_INIT_VIDEO | SDL_INIT_EVENTS ) < 0 ) {
 		Log_Printf( "ERROR: failed to initialize SDL2 -- %s\n", SDL_GetError() );
 		return -1;
@@ -312,9 +366,6 @@ int valdenMain( int argc, char **argv )
 		Sys_LogFile();
 	}
 
-	myargc = argc;
-	myargv = argv;
-
 	g_pApplication = Walnut::CreateApplication( argc, argv );
 
 	// if the first parameter is a .map, load that
@@ -1,15 +1,22 @@
 #include "editor.h"
 #include <glm/glm.hpp>
 #include "nlohmann/json.hpp"
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
 
 using json = nlohmann::json;
 
 mapData_t *mapData;
-std::vector<mapData_t> g_MapCache;
+std::list<mapData_t> g_MapCache;
 static const char *unnamed_map = "unnamed.map";
-static spriteCoord_t *s_pSpritePOD;
-static maptile_t *s_pTilePOD;
 static bool s_bLoadingMap;
+static uint64_t s_nMapUseCounter;
+static uint32_t s_nEvictSerial;
+
+static void Map_Activate( void );
 
 typedef enum {
     CHUNK_CHECKPOINT,
@@ -23,12 +30,19 @@ typedef enum {
     CHUNK_INVALID
 } chunkType_t;
 
-static bool ParseChunk( const char **text, mapData_t *tmpData )
+void Map_FreeTiles( mapData_t *data )
+{
+    Tiles_Free( &data->tiles );
+}
+
+static bool ParseChunk( const char **text, mapData_t *tmpData, bool loadTextures )
 {
     const char *tok;
     chunkType_t type;
+    uvec3_t tilePos;
 
     type = CHUNK_INVALID;
+    VectorClear( tilePos );
 
     while ( 1 ) {
         tok = COM_ParseExt( text, qtrue );
@@ -40,22 +54,24 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
         if ( tok[0] == '}' ) {
             switch ( type ) {
             case CHUNK_CHECKPOINT:
-                tmpData->numCheckpoints++;
+                Slot_Alloc( &tmpData->checkpointSlots );
                 break;
             case CHUNK_SPAWN:
-                tmpData->numSpawns++;
+                Slot_Alloc( &tmpData->spawnSlots );
                 break;
             case CHUNK_LIGHT:
-                tmpData->numLights++;
+                Slot_Alloc( &tmpData->lightSlots );
                 break;
             case CHUNK_TILE:
+                // x and y are implied by the tile's place in the map, only the elevation is kept
+                Tiles_SetElevation( &tmpData->tiles, tmpData->numTiles, tilePos[2] );
                 tmpData->numTiles++;
                 break;
             case CHUNK_TEXCOORDS:
                 tmpData->tileset.numTiles++;
                 break;
             case CHUNK_SECRET:
-                tmpData->numSecrets++;
+                Slot_Alloc( &tmpData->secretSlots );
                 break;
             };
             break;
@@ -70,21 +86,41 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
                 return false;
             }
             else if ( !N_stricmp( tok, "map_checkpoint" ) ) {
+                if ( tmpData->checkpointSlots.numSlots >= MAX_MAP_CHECKPOINTS ) {
+                    COM_ParseError( "too many checkpoints in map, MAX_MAP_CHECKPOINTS is %i", MAX_MAP_CHECKPOINTS );
+                    return false;
+                }
                 type = CHUNK_CHECKPOINT;
             }
             else if ( !N_stricmp( tok, "map_spawn" ) ) {
+                if ( tmpData->spawnSlots.numSlots >= MAX_MAP_SPAWNS ) {
+                    COM_ParseError( "too many spawns in map, MAX_MAP_SPAWNS is %i", MAX_MAP_SPAWNS );
+                    return false;
+                }
                 type = CHUNK_SPAWN;
             }
             else if ( !N_stricmp(tok, "map_light" ) ) {
+                if ( tmpData->lightSlots.numSlots >= MAX_MAP_LIGHTS ) {
+                    COM_ParseError( "too many lights in map, MAX_MAP_LIGHTS is %i", MAX_MAP_LIGHTS );
+                    return false;
+                }
                 type = CHUNK_LIGHT;
             }
             else if ( !N_stricmp( tok, "texcoords" ) ) {
                 type = CHUNK_TEXCOORDS;
             }
             else if ( !N_stricmp( tok, "map_tile" ) ) {
+                if ( tmpData->numTiles >= tmpData->width * tmpData->height ) {
+                    COM_ParseError( "too many tiles for a %ix%i map", tmpData->width, tmpData->height );
+                    return false;
+                }
                 type = CHUNK_TILE;
             }
             else if ( !N_stricmp( tok, "map_secret" ) ) {
+                if ( tmpData->secretSlots.numSlots >= MAX_MAP_SECRETS ) {
+                    COM_ParseError( "too many secrets in map, MAX_MAP_SECRETS is %i", MAX_MAP_SECRETS );
+                    return false;
+                }
                 type = CHUNK_SECRET;
             }
             else if ( !N_stricmp( tok, "tilesetdata" ) ) {
@@ -108,7 +144,7 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
                 COM_ParseError( "missing parameter for spawn entity type" );
                 return false;
             }
-            tmpData->spawns[tmpData->numSpawns].entitytype = (uint32_t)atoi( tok );
+            tmpData->spawns[tmpData->spawnSlots.numSlots].entitytype = (uint32_t)atoi( tok );
         }
         /*
         //
@@ -179,7 +215,11 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
             else if ( tok[0] == ' ' ) {
                 continue;
             }
-            tmpData->textures[Walnut::TB_DIFFUSEMAP] = new Walnut::Image( tok );
+            N_strncpyz( tmpData->textureNames[Walnut::TB_DIFFUSEMAP], tok, sizeof(tmpData->textureNames[Walnut::TB_DIFFUSEMAP]) );
+            if ( loadTextures ) {
+                Tex_Release( tmpData->textures[Walnut::TB_DIFFUSEMAP] );
+                tmpData->textures[Walnut::TB_DIFFUSEMAP] = Tex_Load( tok );
+            }
         }
         //
         // specularMap <name>
@@ -193,7 +233,11 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
             else if ( tok[0] == ' ' ) {
                 continue;
             }
-            tmpData->textures[Walnut::TB_SPECULARMAP] = new Walnut::Image( tok );
+            N_strncpyz( tmpData->textureNames[Walnut::TB_SPECULARMAP], tok, sizeof(tmpData->textureNames[Walnut::TB_SPECULARMAP]) );
+            if ( loadTextures ) {
+                Tex_Release( tmpData->textures[Walnut::TB_SPECULARMAP] );
+                tmpData->textures[Walnut::TB_SPECULARMAP] = Tex_Load( tok );
+            }
         }
         //
         // normalMap <name>
@@ -207,7 +251,11 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
             else if ( tok[0] == ' ' ) {
                 continue;
             }
-            tmpData->textures[Walnut::TB_NORMALMAP] = new Walnut::Image( tok );
+            N_strncpyz( tmpData->textureNames[Walnut::TB_NORMALMAP], tok, sizeof(tmpData->textureNames[Walnut::TB_NORMALMAP]) );
+            if ( loadTextures ) {
+                Tex_Release( tmpData->textures[Walnut::TB_NORMALMAP] );
+                tmpData->textures[Walnut::TB_NORMALMAP] = Tex_Load( tok );
+            }
         }
         //
         // lightMap <name>
@@ -221,7 +269,11 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
             else if ( tok[0] == ' ' ) {
                 continue;
             }
-            tmpData->textures[Walnut::TB_LIGHTMAP] = new Walnut::Image( tok );
+            N_strncpyz( tmpData->textureNames[Walnut::TB_LIGHTMAP], tok, sizeof(tmpData->textureNames[Walnut::TB_LIGHTMAP]) );
+            if ( loadTextures ) {
+                Tex_Release( tmpData->textures[Walnut::TB_LIGHTMAP] );
+                tmpData->textures[Walnut::TB_LIGHTMAP] = Tex_Load( tok );
+            }
         }
         //
         // shadowMap <name>
@@ -235,7 +287,11 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
             else if ( tok[0] == ' ' ) {
                 continue;
             }
-            tmpData->textures[Walnut::TB_SHADOWMAP] = new Walnut::Image( tok );
+            N_strncpyz( tmpData->textureNames[Walnut::TB_SHADOWMAP], tok, sizeof(tmpData->textureNames[Walnut::TB_SHADOWMAP]) );
+            if ( loadTextures ) {
+                Tex_Release( tmpData->textures[Walnut::TB_SHADOWMAP] );
+                tmpData->textures[Walnut::TB_SHADOWMAP] = Tex_Load( tok );
+            }
         }
         //
         // tileHeight <height>
@@ -257,7 +313,7 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
                 COM_ParseError( "missing parameter for map tile texIndex" );
                 return false;
             }
-            tmpData->tiles[tmpData->numTiles].index = (int32_t)atoi( tok );
+            tmpData->tiles.index[tmpData->numTiles] = (int32_t)atoi( tok );
         }
         //
         // id <entityid>
@@ -272,17 +328,22 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
                 COM_ParseError( "missing parameter for spawn entity id" );
                 return false;
             }
-            tmpData->spawns[tmpData->numSpawns].entityid = atoi( tok );
+            tmpData->spawns[tmpData->spawnSlots.numSlots].entityid = atoi( tok );
 
             bool valid = false;
-            for ( const auto& it : g_pProjectManager->GetProject()->m_EntityList[tmpData->spawns[tmpData->numSpawns].entitytype] ) {
-                if ( it.m_Id == tmpData->spawns[tmpData->numSpawns].entityid ) {
-                    valid = true;
-                    break;
+            if ( !g_pProjectManager || !g_pProjectManager->GetProject() ) {
+                // the headless compiler doesn't load project entity data
+                valid = true;
+            } else {
+                for ( const auto& it : g_pProjectManager->GetProject()->m_EntityList[tmpData->spawns[tmpData->spawnSlots.numSlots].entitytype] ) {
+                    if ( it.m_Id == tmpData->spawns[tmpData->spawnSlots.numSlots].entityid ) {
+                        valid = true;
+                        break;
+                    }
                 }
             }
             if ( !valid ) {
-                COM_ParseError( "invalid entity id found in map spawn: %u", tmpData->spawns[tmpData->numSpawns].entityid );
+                COM_ParseError( "invalid entity id found in map spawn: %u", tmpData->spawns[tmpData->spawnSlots.numSlots].entityid );
                 return false;
             }
         }
@@ -299,7 +360,7 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
                 COM_ParseError( "missing parameter for tile flags" );
                 return false;
             }
-            tmpData->tiles[tmpData->numTiles].flags = (uint32_t)ParseHex( tok );
+            Tiles_SetFlags( &tmpData->tiles, tmpData->numTiles, (uint32_t)ParseHex( tok ) );
         }
         //
         // sides <sides...>
@@ -310,15 +371,13 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
                 COM_ParseError( "failed to parse sides for map tile" );
                 return false;
             }
-            tmpData->tiles[tmpData->numTiles].sides[DIR_NORTH]       = sides[DIR_NORTH];
-            tmpData->tiles[tmpData->numTiles].sides[DIR_NORTH_EAST]  = sides[DIR_NORTH_EAST];
-            tmpData->tiles[tmpData->numTiles].sides[DIR_EAST]        = sides[DIR_EAST];
-            tmpData->tiles[tmpData->numTiles].sides[DIR_SOUTH_EAST]  = sides[DIR_SOUTH_EAST];
-            tmpData->tiles[tmpData->numTiles].sides[DIR_SOUTH]       = sides[DIR_SOUTH];
-            tmpData->tiles[tmpData->numTiles].sides[DIR_SOUTH_WEST]  = sides[DIR_SOUTH_WEST];
-            tmpData->tiles[tmpData->numTiles].sides[DIR_WEST]        = sides[DIR_WEST];
-            tmpData->tiles[tmpData->numTiles].sides[DIR_NORTH_WEST]  = sides[DIR_NORTH_WEST];
-            tmpData->tiles[tmpData->numTiles].sides[DIR_NULL]        = sides[DIR_NULL];
+            uint32_t mask = 0;
+            for ( int dir = 0; dir < NUMDIRS; dir++ ) {
+                if ( sides[dir] ) {
+                    mask |= ( 1 << dir );
+                }
+            }
+            Tiles_SetSides( &tmpData->tiles, tmpData->numTiles, mask );
         }
         //
         // trigger <checkpoint>
@@ -333,7 +392,7 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
                 COM_ParseError( "missing parameter for secret trigger" );
                 return false;
             }
-            tmpData->secrets[ tmpData->numSecrets ].trigger = atoi( tok );
+            tmpData->secrets[ tmpData->secretSlots.numSlots ].trigger = atoi( tok );
         }
         //
         // pos <x y elevation>
@@ -344,13 +403,13 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
                 COM_ParseError( "chunk type not specified before parameters" );
                 return false;
             } else if ( type == CHUNK_CHECKPOINT ) {
-                xyz = tmpData->checkpoints[tmpData->numCheckpoints].xyz;
+                xyz = tmpData->checkpoints[tmpData->checkpointSlots.numSlots].xyz;
             } else if ( type == CHUNK_SPAWN ) {
-                xyz = tmpData->spawns[tmpData->numSpawns].xyz;
+                xyz = tmpData->spawns[tmpData->spawnSlots.numSlots].xyz;
             } else if ( type == CHUNK_LIGHT ) {
-                xyz = tmpData->lights[ tmpData->numLights ].origin;
+                xyz = tmpData->lights[ tmpData->lightSlots.numSlots ].origin;
             } else if ( type == CHUNK_TILE ) {
-                xyz = tmpData->tiles[tmpData->numTiles].pos;
+                xyz = tilePos;
             }
 
             tok = COM_ParseExt( text, qfalse );
@@ -388,7 +447,7 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
                 COM_ParseError( "missing parameter for angle" );
                 return false;
             }
-            tmpData->lights[tmpData->numLights].angle = atof( tok );
+            tmpData->lights[tmpData->lightSlots.numSlots].angle = atof( tok );
         }
         //
         // brightness <value>
@@ -404,7 +463,7 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
                 COM_ParseError( "missing parameter for brightness" );
                 return false;
             }
-            tmpData->lights[tmpData->numLights].brightness = atof( tok );
+            tmpData->lights[tmpData->lightSlots.numSlots].brightness = atof( tok );
         }
         //
         // color <r g b a>
@@ -415,7 +474,7 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
                 return false;
             }
 
-            if ( !Parse1DMatrix( text, 4, tmpData->lights[tmpData->numLights].color ) ) {
+            if ( !Parse1DMatrix( text, 4, tmpData->lights[tmpData->lightSlots.numSlots].color ) ) {
                 COM_ParseError( "failed to parse light color" );
                 return false;
             }
@@ -433,7 +492,7 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
                 COM_ParseError( "missing parameter for light type" );
                 return false;
             }
-            tmpData->lights[tmpData->numLights].type = atoi( tok );
+            tmpData->lights[tmpData->lightSlots.numSlots].type = atoi( tok );
         }
         //
         // brightness <brightness>
@@ -448,7 +507,7 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
                 COM_ParseError( "missing parameter for light brightness" );
                 return false;
             }
-            tmpData->lights[tmpData->numLights].brightness = atof( tok );
+            tmpData->lights[tmpData->lightSlots.numSlots].brightness = atof( tok );
         }
         //
         // lightLinear <amount>
@@ -463,7 +522,7 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
                 COM_ParseError( "missing parameter for light linear" );
                 return false;
             }
-            tmpData->lights[ tmpData->numLights ].linear = atof( tok );
+            tmpData->lights[ tmpData->lightSlots.numSlots ].linear = atof( tok );
         }
         //
         // lightQuadratic <amount>
@@ -478,7 +537,7 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
                 COM_ParseError( "missing parameter for light quadratic" );
                 return false;
             }
-            tmpData->lights[ tmpData->numLights ].quadratic = atof( tok );
+            tmpData->lights[ tmpData->lightSlots.numSlots ].quadratic = atof( tok );
         }
         //
         // lightConstant <amount>
@@ -493,7 +552,7 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
                 COM_ParseError( "missing parameter for light constant" );
                 return false;
             }
-            tmpData->lights[ tmpData->numLights ].constant = atof( tok );
+            tmpData->lights[ tmpData->lightSlots.numSlots ].constant = atof( tok );
         }
         //
         // range <range>
@@ -508,7 +567,7 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
                 COM_ParseError( "missing parameter for light range" );
                 return false;
             }
-            tmpData->lights[tmpData->numLights].range = atof( tok );
+            tmpData->lights[tmpData->lightSlots.numSlots].range = atof( tok );
         }
         //
         // bindCheckpoint <index>
@@ -523,7 +582,7 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
                 COM_ParseError( "missing parameter for spawn checkpoint binding" );
                 return false;
             }
-            tmpData->spawns[ tmpData->numSpawns ].checkpoint = (uint32_t)atol( tok );
+            tmpData->spawns[ tmpData->spawnSlots.numSlots ].checkpoint = (uint32_t)atol( tok );
         }
         else {
             COM_ParseWarning( "unrecognized token '%s'", tok );
@@ -533,7 +592,34 @@ static bool ParseChunk( const char **text, mapData_t *tmpData )
     return true;
 }
 
-static bool ParseMap(const char **text, const char *path, mapData_t *tmpData)
+/*
+* BindCheckpoints: a freshly parsed map's slots line up with the file's indices, so its checkpoint
+* references can be turned into handles directly. One naming a checkpoint the map doesn't have is
+* left unbound, and falls back to the first checkpoint when the map is next saved.
+*/
+static void BindCheckpoints( mapData_t *tmpData, const char *path )
+{
+    uint32_t i;
+
+    for ( i = 0; i < tmpData->spawnSlots.numSlots; i++ ) {
+        const uint32_t index = tmpData->spawns[i].checkpoint;
+
+        tmpData->spawns[i].checkpoint = Slot_Handle( &tmpData->checkpointSlots, index );
+        if ( tmpData->spawns[i].checkpoint == ENTITY_HANDLE_NONE ) {
+            Log_FPrintf( SYS_WRN, "WARNING: spawn %u in map '%s' is bound to checkpoint %u, which doesn't exist\n", i, path, index );
+        }
+    }
+    for ( i = 0; i < tmpData->secretSlots.numSlots; i++ ) {
+        const uint32_t index = tmpData->secrets[i].trigger;
+
+        tmpData->secrets[i].trigger = Slot_Handle( &tmpData->checkpointSlots, index );
+        if ( tmpData->secrets[i].trigger == ENTITY_HANDLE_NONE ) {
+            Log_FPrintf( SYS_WRN, "WARNING: secret %u in map '%s' is triggered by checkpoint %u, which doesn't exist\n", i, path, index );
+        }
+    }
+}
+
+static bool ParseMap( const char **text, const char *path, mapData_t *tmpData, bool loadTextures )
 {
     const char *tok;
 
@@ -545,9 +631,6 @@ static bool ParseMap(const char **text, const char *path, mapData_t *tmpData)
         return false;
     }
 
-    tmpData->texcoords = s_pSpritePOD;
-    tmpData->tiles = s_pTilePOD;
-
     while ( 1 ) {
         tok = COM_ParseComplex( text, qtrue );
         if ( !tok[0] ) {
@@ -560,7 +643,15 @@ static bool ParseMap(const char **text, const char *path, mapData_t *tmpData)
         }
         // chunk definition
         else if ( tok[0] == '{' ) {
-            if ( !ParseChunk( text, tmpData ) ) {
+            // the map's dimensions always come before its chunks
+            if ( !tmpData->tiles.index ) {
+                if ( tmpData->width <= 0 || tmpData->height <= 0 || tmpData->width > MAX_MAP_WIDTH || tmpData->height > MAX_MAP_HEIGHT ) {
+                    COM_ParseError( "bad map dimensions %ix%i", tmpData->width, tmpData->height );
+                    return false;
+                }
+                Tiles_Alloc( &tmpData->tiles, tmpData->width, tmpData->height );
+            }
+            if ( !ParseChunk( text, tmpData, loadTextures ) ) {
                 return false;
             }
             continue;
@@ -617,26 +708,94 @@ static bool ParseMap(const char **text, const char *path, mapData_t *tmpData)
             COM_ParseWarning( "unrecognized token: '%s'", tok );
         }
     }
+
+    BindCheckpoints( tmpData, path );
+
     return true;
 }
 
+/*
+* PackEntities: copies every live entity of one kind down into out in slot order, remap gets each
+* slot's packed index or -1 for holes
+*/
+template<typename T, uint32_t N>
+static int PackEntities( const T *entities, const slotMap_t<N> *slots, T *out, int *remap )
+{
+    uint32_t i;
+    int count;
+
+    count = 0;
+    for ( i = 0; i < slots->numSlots; i++ ) {
+        if ( !slots->used[i] ) {
+            if ( remap ) {
+                remap[i] = -1;
+            }
+            continue;
+        }
+        if ( remap ) {
+            remap[i] = count;
+        }
+        out[ count++ ] = entities[i];
+    }
+    return count;
+}
+
+void Map_PackEntities( const mapData_t *data, mapEntities_t *out )
+{
+    int checkpointIndex[MAX_MAP_CHECKPOINTS];
+    int slot, i;
+
+    out->numCheckpoints = PackEntities( data->checkpoints, &data->checkpointSlots, out->checkpoints, checkpointIndex );
+    out->numSpawns = PackEntities( data->spawns, &data->spawnSlots, out->spawns, (int *)NULL );
+    out->numLights = PackEntities( data->lights, &data->lightSlots, out->lights, (int *)NULL );
+    out->numSecrets = PackEntities( data->secrets, &data->secretSlots, out->secrets, (int *)NULL );
+
+    // a reference to a removed checkpoint falls back to the first one
+    for ( i = 0; i < out->numSpawns; i++ ) {
+        slot = Slot_Resolve( &data->checkpointSlots, out->spawns[i].checkpoint );
+        out->spawns[i].checkpoint = slot != -1 ? checkpointIndex[slot] : 0;
+    }
+    for ( i = 0; i < out->numSecrets; i++ ) {
+        slot = Slot_Resolve( &data->checkpointSlots, out->secrets[i].trigger );
+        out->secrets[i].trigger = slot != -1 ? checkpointIndex[slot] : 0;
+    }
+}
+
 
 void Map_Init( void ) {
 }
 
+/*
+* Map_ParseFile: parses a map's text into data. If data->tiles.index is NULL the tile store is allocated
+* to the map's size and owned by the caller afterwards. Textures are only created when loadTextures
+* is set, their names are always kept in data->textureNames. Safe to call from worker threads.
+*/
+bool Map_ParseFile( const char *text, const char *name, mapData_t *data, bool loadTextures )
+{
+    const char *ptr;
+
+    ptr = text;
+    return ParseMap( &ptr, name, data, loadTextures );
+}
+
+/*
+* Map_LoadFile: the file text and the parse target are staging and live on the hunk until the load is
+* done, only the tiles, sprites and textures the map keeps are allocated for real
+*/
 void Map_LoadFile( const char *filename, bool fromCommandLine )
 {
     union {
         void *v;
         char *b;
     } f;
-    const char *ptr;
-    const char **text, *tok;
     char path[MAX_OSPATH];
-    mapData_t tmpData;
+    mapData_t *tmpData;
+    int lowMark, highMark;
+
+    const char *baseName = strrchr( filename, PATH_SEP ) ? strrchr( filename, PATH_SEP ) + 1 : filename;
 
     for ( const auto& it : g_MapCache ) {
-        if ( !N_stricmp( it.name, strrchr( filename, PATH_SEP ) + 1 ) ) {
+        if ( !N_stricmp( it.name, baseName ) ) {
             Sys_MessageBox( "Map load Failed", va( "Map file %s is already loaded", filename ), MB_OK | MB_ICONINFORMATION );
             return;
         }
@@ -645,58 +804,34 @@ void Map_LoadFile( const char *filename, bool fromCommandLine )
     snprintf( path, sizeof( path ) - 1, "%s%s%cmaps%c%s"
         , g_pProjectManager->GetProject()->m_FilePath.c_str(),
         g_pProjectManager->GetProject()->m_AssetPath.c_str(), PATH_SEP, PATH_SEP, filename );
-    LoadFile( path, &f.v );
+
+    lowMark = Hunk_LowMark();
+    highMark = Hunk_HighMark();
+
+    LoadHunkFile( path, &f.v );
 
     if ( !f.v ) {
         Sys_MessageBox( "Map Load Failed", va( "Failed to open map file '%s'", path ), MB_OK | MB_ICONWARNING );
+        Hunk_FreeToHighMark( highMark );
         return;
     }
 
-    ptr = f.b;
-    text = &ptr;
-
-    memset( &tmpData, 0, sizeof(tmpData) );
+    tmpData = (mapData_t *)Hunk_AllocName( sizeof(*tmpData), "mapload" );
 
     s_bLoadingMap = true;
 
-    if ( !s_pTilePOD ) {
-        s_pTilePOD = (maptile_t *)GetMemory( sizeof(maptile_t) * MAX_MAP_WIDTH * MAX_MAP_HEIGHT );
-    }
-    if ( !s_pSpritePOD ) {
-        s_pSpritePOD = (spriteCoord_t *)GetMemory( sizeof(spriteCoord_t) * MAX_MAP_WIDTH * MAX_MAP_HEIGHT );
-    }
-
-    if ( ParseMap( text, filename, &tmpData ) ) {
+    // the parser sizes the tile array to the map, the tileset sizes the sprites
+    if ( Map_ParseFile( f.b, filename, tmpData, true ) ) {
         Map_Free();
-        Map_New();
 
         Log_Printf( "Successfully loaded map '%s'\n", filename );
 
-        //
-        // copy everything
-        //
-        N_strncpyz( mapData->name, tmpData.name, sizeof(mapData->name) );
-        mapData->width = tmpData.width;
-        mapData->height = tmpData.height;
-        VectorCopy( mapData->ambientColor, tmpData.ambientColor );
-        mapData->ambientIntensity = tmpData.ambientIntensity;
-        mapData->tiles = s_pTilePOD;
-        mapData->texcoords = s_pSpritePOD;
-        memcpy( mapData->checkpoints, tmpData.checkpoints, sizeof(*mapData->checkpoints) * tmpData.numCheckpoints );
-        memcpy( mapData->spawns, tmpData.spawns, sizeof(*mapData->spawns) * tmpData.numSpawns );
-        memcpy( mapData->lights, tmpData.lights, sizeof(*mapData->lights) * tmpData.numLights );
-        memcpy( mapData->secrets, tmpData.secrets, sizeof( *mapData->secrets ) * tmpData.numSecrets );
-        mapData->numCheckpoints = tmpData.numCheckpoints;
-        mapData->numSpawns = tmpData.numSpawns;
-        mapData->numLights = tmpData.numLights;
-        mapData->numSecrets = tmpData.numSecrets;
-        memcpy( &mapData->tileset, &tmpData.tileset, sizeof(mapData->tileset) );
-
-        for ( uint32_t i = 0; i < Walnut::NUM_TEXTURE_BUNDLES; i++ ) {
-            mapData->textures[Walnut::TB_DIFFUSEMAP + i] = tmpData.textures[Walnut::TB_DIFFUSEMAP + i];
-        }
+        mapData = std::addressof( g_MapCache.emplace_back() );
+        memcpy( mapData, tmpData, sizeof(*mapData) );
+        Map_Resize();
 
         Map_BuildTileset();
+        Map_Activate();
 
         if ( g_pProjectManager->IsLoaded()
             &&  std::find( g_pProjectManager->GetProject()->m_MapList.begin(),
@@ -706,20 +841,26 @@ void Map_LoadFile( const char *filename, bool fromCommandLine )
             g_pProjectManager->GetProject()->m_MapList.emplace_back( mapData );
         }
     } else {
+        Map_FreeTiles( tmpData );
+        FreeMemory( tmpData->texcoords, TAG_MAP );
+        for ( int i = 0; i < Walnut::NUM_TEXTURE_BUNDLES; i++ ) {
+            Tex_Release( tmpData->textures[i] );
+        }
         mapData = NULL;
     }
 
-    s_bLoadingMap = true;
+    s_bLoadingMap = false;
 
-    FreeMemory( f.b );
+    Hunk_FreeToLowMark( lowMark );
+    Hunk_FreeToHighMark( highMark );
 }
 
-static void Map_ArchiveLights( IDataStream *out )
+static void Map_ArchiveLights( IDataStream *out, const mapEntities_t *ents )
 {
     uint32_t i;
     char buf[1024];
 
-    for ( i = 0; i < mapData->numLights; i++ ) {
+    for ( i = 0; i < ents->numLights; i++ ) {
         sprintf( buf,
             "\t{\n"
             "\t\tclassname \"map_light\"\n"
@@ -733,41 +874,41 @@ static void Map_ArchiveLights( IDataStream *out )
             "\t\tcolor ( %f %f %f %f )\n"
             "\t\ttype %i\n"
             "\t}\n"
-        , mapData->lights[i].origin[0], mapData->lights[i].origin[1], mapData->lights[i].origin[2],
-        mapData->lights[i].range, mapData->lights[i].brightness,
-        mapData->lights[i].angle, mapData->lights[i].constant,
-        mapData->lights[i].linear, mapData->lights[i].quadratic,
-        mapData->lights[i].color[0], mapData->lights[i].color[1],
-        mapData->lights[i].color[2], mapData->lights[i].color[3],
-        mapData->lights[i].type );
+        , ents->lights[i].origin[0], ents->lights[i].origin[1], ents->lights[i].origin[2],
+        ents->lights[i].range, ents->lights[i].brightness,
+        ents->lights[i].angle, ents->lights[i].constant,
+        ents->lights[i].linear, ents->lights[i].quadratic,
+        ents->lights[i].color[0], ents->lights[i].color[1],
+        ents->lights[i].color[2], ents->lights[i].color[3],
+        ents->lights[i].type );
         
         out->Write( buf, strlen( buf ) );
     }
 }
 
-static void Map_ArchiveCheckpoints( IDataStream *out )
+static void Map_ArchiveCheckpoints( IDataStream *out, const mapEntities_t *ents )
 {
     uint32_t i;
     char buf[1024];
 
-    for ( i = 0; i < mapData->numCheckpoints; i++ ) {
+    for ( i = 0; i < ents->numCheckpoints; i++ ) {
         sprintf( buf,
             "\t{\n"
             "\t\tclassname \"map_checkpoint\"\n"
             "\t\tpos %i %i %i\n"
             "\t}\n"
-        , mapData->checkpoints[i].xyz[0], mapData->checkpoints[i].xyz[1], mapData->checkpoints[i].xyz[2] );
+        , ents->checkpoints[i].xyz[0], ents->checkpoints[i].xyz[1], ents->checkpoints[i].xyz[2] );
         
         out->Write( buf, strlen( buf ) );
     }
 }
 
-static void Map_ArchiveSpawns( IDataStream *out )
+static void Map_ArchiveSpawns( IDataStream *out, const mapEntities_t *ents )
 {
     uint32_t i;
     char buf[1024];
 
-    for ( i = 0; i < mapData->numSpawns; i++ ) {
+    for ( i = 0; i < ents->numSpawns; i++ ) {
         sprintf( buf,
             "\t{\n"
             "\t\tclassname \"map_spawn\"\n"
@@ -776,8 +917,8 @@ static void Map_ArchiveSpawns( IDataStream *out )
             "\t\tentity %i\n"
             "\t\tbindCheckpoint %u\n"
             "\t}\n"
-        , mapData->spawns[i].xyz[0], mapData->spawns[i].xyz[1], mapData->spawns[i].xyz[2], mapData->spawns[i].entityid, mapData->spawns[i].entitytype,
-        mapData->spawns[i].checkpoint );
+        , ents->spawns[i].xyz[0], ents->spawns[i].xyz[1], ents->spawns[i].xyz[2], ents->spawns[i].entityid, ents->spawns[i].entitytype,
+        ents->spawns[i].checkpoint );
         
         out->Write( buf, strlen( buf ) );
     }
@@ -785,7 +926,7 @@ static void Map_ArchiveSpawns( IDataStream *out )
 
 static void Map_ArchiveTiles( IDataStream *out )
 {
-    uint32_t y, x;
+    const tileStore_t *tiles = &mapData->tiles;
     int i;
     char buf[1024];
 
@@ -798,35 +939,35 @@ static void Map_ArchiveTiles( IDataStream *out )
             "\t\ttexIndex %i\n"
             "\t\tsides ( %i %i %i %i %i %i %i %i %i )\n"
             "\t}\n"
-        , mapData->tiles[i].pos[0], mapData->tiles[i].pos[1], mapData->tiles[i].pos[2],
-        mapData->tiles[i].flags,
-        mapData->tiles[i].index,
-        mapData->tiles[i].sides[DIR_NORTH],
-        mapData->tiles[i].sides[DIR_NORTH_EAST],
-        mapData->tiles[i].sides[DIR_EAST],
-        mapData->tiles[i].sides[DIR_SOUTH_EAST],
-        mapData->tiles[i].sides[DIR_SOUTH],
-        mapData->tiles[i].sides[DIR_SOUTH_WEST],
-        mapData->tiles[i].sides[DIR_WEST],
-        mapData->tiles[i].sides[DIR_NORTH_WEST],
-        mapData->tiles[i].sides[DIR_NULL] );
+        , i % tiles->width, i / tiles->width, tiles->elevation ? tiles->elevation[i] : 0,
+        tiles->flags[i],
+        tiles->index[i],
+        Tiles_HasSide( tiles, i, DIR_NORTH ),
+        Tiles_HasSide( tiles, i, DIR_NORTH_EAST ),
+        Tiles_HasSide( tiles, i, DIR_EAST ),
+        Tiles_HasSide( tiles, i, DIR_SOUTH_EAST ),
+        Tiles_HasSide( tiles, i, DIR_SOUTH ),
+        Tiles_HasSide( tiles, i, DIR_SOUTH_WEST ),
+        Tiles_HasSide( tiles, i, DIR_WEST ),
+        Tiles_HasSide( tiles, i, DIR_NORTH_WEST ),
+        Tiles_HasSide( tiles, i, DIR_NULL ) );
 
         out->Write( buf, strlen( buf ) );
     }
 }
 
-static void Map_ArchiveSecrets( IDataStream *out )
+static void Map_ArchiveSecrets( IDataStream *out, const mapEntities_t *ents )
 {
     int i;
     char buf[1024];
 
-    for ( i = 0; i < mapData->numSecrets; i++ ) {
+    for ( i = 0; i < ents->numSecrets; i++ ) {
         snprintf( buf, sizeof( buf ) - 1,
             "\t{\n"
             "\t\tclassname \"map_secret\"\n"
             "\t\ttrigger %u\n"
             "\t}\n"
-        , mapData->secrets[i].trigger );
+        , ents->secrets[i].trigger );
 
         out->Write( buf, strlen( buf ) );
     }
@@ -874,6 +1015,7 @@ void Map_Save( void )
 {
     FileStream out;
     char outfile[MAX_OSPATH];
+    mapEntities_t *ents;
 
     snprintf( outfile, sizeof( outfile ), "%s%s%cmaps%c%s", g_pProjectManager->GetProject()->m_FilePath.c_str(), g_pProjectManager->GetProject()->m_AssetPath.c_str(),
         PATH_SEP, PATH_SEP, mapData->name );
@@ -925,26 +1067,26 @@ void Map_Save( void )
         out.Write( buf, strlen( buf ) );
     }
 
-    for ( int y = 0; y < mapData->width; y++ ) {
-        for ( int x = 0; x < mapData->height; x++ ) {
-            mapData->tiles[ y * mapData->width + x ].pos[0] = x;
-            mapData->tiles[ y * mapData->width + x ].pos[1] = y;
-        }
-    }
-
     g_pEditor->m_nOldMapHeight = mapData->height;
     g_pEditor->m_nOldMapWidth = mapData->width;
 
-    Map_ArchiveCheckpoints( &out );
-    Map_ArchiveSpawns( &out );
+    ents = (mapEntities_t *)GetMemory( sizeof(*ents), TAG_MAP );
+    Map_PackEntities( mapData, ents );
+
+    Map_ArchiveCheckpoints( &out, ents );
+    Map_ArchiveSpawns( &out, ents );
     Map_ArchiveTiles( &out );
-    Map_ArchiveLights( &out );
-    Map_ArchiveSecrets( &out );
+    Map_ArchiveLights( &out, ents );
+    Map_ArchiveSecrets( &out, ents );
+
+    FreeMemory( ents, TAG_MAP );
 
     out.Write( "}\n", 2 );
 
     out.Close();
 
+    g_pProjectManager->UpdateMapIndex( mapData->name );
+
     if ( std::find( g_pProjectManager->GetProject()->m_MapList.begin(),
         g_pProjectManager->GetProject()->m_MapList.end(), mapData ) == g_pProjectManager->GetProject()->m_MapList.end() )
     {
@@ -958,10 +1100,27 @@ void Map_Save( void )
     g_pMapInfoDlg->m_bMapNameUpdated = false;
 }
 
-void Map_New( void )
+/*
+* Map_Activate: hooks a freshly created or loaded mapData up to the editor
+*/
+static void Map_Activate( void )
 {
-    uint32_t y, x;
+    g_pEditor->m_nOldMapHeight = mapData->height;
+    g_pEditor->m_nOldMapWidth = mapData->width;
+
+    if ( g_pMapInfoDlg ) {
+        g_pMapInfoDlg->SetCurrent( mapData );
+    }
+
+    if ( g_pApplication ) {
+        Sys_SetWindowTitle( mapData->name );
+    }
+
+    Map_Acquire( mapData );
+}
 
+void Map_New( void )
+{
     Map_Free();
 
     mapData = std::addressof( g_MapCache.emplace_back() );
@@ -970,56 +1129,379 @@ void Map_New( void )
 
     mapData->width = 64;
     mapData->height = 64;
-
-    if ( !s_pTilePOD ) {
-        s_pTilePOD = (maptile_t *)GetMemory( sizeof( maptile_t ) * MAX_MAP_WIDTH * MAX_MAP_HEIGHT );
-    }
-    if ( !s_pSpritePOD ) {
-        s_pSpritePOD = (spriteCoord_t *)GetMemory( sizeof( spriteCoord_t ) * MAX_MAP_WIDTH * MAX_MAP_HEIGHT );
-    }
-    mapData->tiles = s_pTilePOD;
-    mapData->texcoords = s_pSpritePOD;
-
-    for ( y = 0; y < MAX_MAP_HEIGHT; y++ ) {
-        for ( x = 0; x < MAX_MAP_WIDTH; x++ ) {
-            mapData->tiles[y * MAX_MAP_WIDTH + x].pos[0] = x;
-            mapData->tiles[y * MAX_MAP_WIDTH + x].pos[1] = y;
-        }
-    }
+    Map_Resize();
 
     mapData->ambientColor[0] = 0.0f;
     mapData->ambientColor[1] = 0.0f;
     mapData->ambientColor[2] = 0.0f;
 
-    g_pEditor->m_nOldMapHeight = mapData->height;
-    g_pEditor->m_nOldMapWidth = mapData->width;
-
     strcpy( mapData->name, unnamed_map );
 
     if ( !g_pProjectManager->IsLoaded() ) {
         g_pProjectManager->GetProject()->m_MapList.emplace_back( mapData );
     }
 
-    if ( g_pMapInfoDlg ) {
-        g_pMapInfoDlg->SetCurrent( mapData );
-    }
-
-    if ( g_pApplication ) {
-        Sys_SetWindowTitle( mapData->name );
-    }
+    Map_Activate();
 }
 
+/*
+* Map_Free: the current map stays in g_MapCache, it's only paged out once the cache runs over budget
+*/
 void Map_Free( void )
 {
     extern bool g_ApplicationRunning;
     if ( !mapData || !g_ApplicationRunning ) {
         return;
     }
-    memset( mapData->tiles, 0, sizeof(*mapData->tiles) * MAX_MAP_WIDTH * MAX_MAP_HEIGHT );
-    memset( mapData->texcoords, 0, sizeof(*mapData->texcoords) * MAX_MAP_WIDTH * MAX_MAP_HEIGHT );
     mapData = NULL;
 }
 
+/*
+* Map_Resize: relayouts the current map's tiles after its width or height changed, keeping
+* whatever overlaps the old dimensions
+*/
+void Map_Resize( void )
+{
+    if ( mapData->evicted && !Map_Acquire( mapData ) ) {
+        return;
+    }
+    if ( mapData->width == mapData->tiles.width && mapData->height == mapData->tiles.height && mapData->tiles.index ) {
+        return;
+    }
+
+    Tiles_Resize( &mapData->tiles, mapData->width, mapData->height );
+    mapData->numTiles = mapData->width * mapData->height;
+}
+
+/*
+===============================================================
+
+Map cache: every open map owns its tiles, once the resident maps
+go over the preferences' budget the least recently used inactive
+ones are written to a temp file and reloaded when selected again
+
+===============================================================
+*/
+
+static uint64_t Map_TileBytes( const mapData_t *data )
+{
+    return Tiles_MemorySize( &data->tiles );
+}
+
+static uint64_t Map_SpriteBytes( const mapData_t *data )
+{
+    return data->texcoords ? sizeof(*data->texcoords) * data->tileset.numTiles : 0;
+}
+
+uint64_t Map_ResidentMemory( void )
+{
+    uint64_t total;
+
+    total = 0;
+    for ( const auto& it : g_MapCache ) {
+        if ( !it.evicted ) {
+            total += Map_TileBytes( &it ) + Map_SpriteBytes( &it );
+        }
+    }
+    return total;
+}
+
+/*
+* Map_Evict: writes data's tiles and sprites out to a temp file and frees them. The page file is the
+* only copy of any unsaved tile edits, so the map stays resident unless all of it was written.
+*/
+static bool Map_Evict( mapData_t *data )
+{
+    uint64_t tileBytes, spriteBytes, header[3];
+    char *buffer, *stored;
+    uint64_t storedLength;
+    FILE *fp;
+    bool ok;
+
+#ifdef _WIN32
+    const int pid = _getpid();
+#else
+    const int pid = getpid();
+#endif
+
+    tileBytes = Tiles_PackedSize( &data->tiles );
+    spriteBytes = Map_SpriteBytes( data );
+
+    N_strncpyz( data->evictPath, ( std::filesystem::temp_directory_path()
+        / va( "valden-%i-%u.tiles", pid, s_nEvictSerial++ ) ).string().c_str(), sizeof(data->evictPath) );
+
+    buffer = (char *)GetMemory( tileBytes + spriteBytes, TAG_MAP );
+    Tiles_Pack( &data->tiles, (byte *)buffer );
+    if ( spriteBytes ) {
+        memcpy( buffer + tileBytes, data->texcoords, spriteBytes );
+    }
+
+    // mostly empty maps shrink to almost nothing
+    storedLength = tileBytes + spriteBytes;
+    stored = Compress( buffer, storedLength, &storedLength, COMPRESS_ZLIB );
+
+    header[0] = tileBytes + spriteBytes;
+    header[1] = stored != buffer ? storedLength : 0;
+    header[2] = tileBytes;
+
+    ok = false;
+    fp = fopen( data->evictPath, "wb" );
+    if ( fp ) {
+        ok = fwrite( header, sizeof(header), 1, fp ) == 1;
+        ok = ok && fwrite( stored, stored != buffer ? storedLength : header[0], 1, fp ) == 1;
+        ok = ( fclose( fp ) == 0 ) && ok;
+    }
+
+    if ( stored != buffer ) {
+        FreeMemory( stored );
+    }
+    FreeMemory( buffer, TAG_MAP );
+
+    if ( !ok ) {
+        Log_FPrintf( SYS_WRN, "WARNING: failed to page out map '%s' to '%s', keeping it in memory\n", data->name, data->evictPath );
+        remove( data->evictPath );
+        data->evictPath[0] = '\0';
+        return false;
+    }
+
+    Map_FreeTiles( data );
+    FreeMemory( data->texcoords, TAG_MAP );
+    data->texcoords = NULL;
+    data->evicted = true;
+
+    // hand the textures back to the cache, they stay resident while some other map still uses them
+    for ( int i = 0; i < Walnut::NUM_TEXTURE_BUNDLES; i++ ) {
+        if ( data->textures[i] ) {
+            N_strncpyz( data->textureNames[i], data->textures[i]->GetName().c_str(), sizeof(data->textureNames[i]) );
+            Tex_Release( data->textures[i] );
+            data->textures[i] = NULL;
+        } else {
+            data->textureNames[i][0] = '\0';
+        }
+    }
+
+    Log_Printf( "Paged out map '%s' (%lu bytes)\n", data->name, tileBytes + spriteBytes );
+
+    return true;
+}
+
+/*
+* Map_ReloadPaged: reads the tiles and sprites Map_Evict wrote out back in, false if the file is
+* missing or doesn't hold what the map expects
+*/
+static bool Map_ReloadPaged( mapData_t *data )
+{
+    union {
+        void *v;
+        char *b;
+        uint64_t *h;
+    } f;
+    uint64_t length, tileBytes, spriteBytes;
+
+    const char *raw;
+    char *buffer;
+
+    length = LoadFile( data->evictPath, &f.v );
+    if ( !f.v || length < sizeof(uint64_t) * 3 ) {
+        Log_FPrintf( SYS_WRN, "WARNING: paged out map file '%s' is missing\n", data->evictPath );
+        FreeMemory( f.v );
+        return false;
+    }
+
+    tileBytes = f.h[2];
+    spriteBytes = sizeof(*data->texcoords) * data->tileset.numTiles;
+    if ( f.h[0] != tileBytes && f.h[0] != tileBytes + spriteBytes ) {
+        Log_FPrintf( SYS_WRN, "WARNING: paged out map file '%s' doesn't match map '%s'\n", data->evictPath, data->name );
+        FreeMemory( f.v );
+        return false;
+    }
+
+    buffer = NULL;
+    raw = f.b + sizeof(uint64_t) * 3;
+    if ( f.h[1] ) {
+        buffer = (char *)GetMemory( f.h[0], TAG_MAP );
+        if ( f.h[1] > length - sizeof(uint64_t) * 3 || !DecompressBlock( raw, f.h[1], buffer, f.h[0], COMPRESS_ZLIB ) ) {
+            Log_FPrintf( SYS_WRN, "WARNING: paged out map file '%s' is corrupt\n", data->evictPath );
+            FreeMemory( buffer, TAG_MAP );
+            FreeMemory( f.v );
+            return false;
+        }
+        raw = buffer;
+    } else if ( f.h[0] > length - sizeof(uint64_t) * 3 ) {
+        Log_FPrintf( SYS_WRN, "WARNING: paged out map file '%s' is truncated\n", data->evictPath );
+        FreeMemory( f.v );
+        return false;
+    }
+
+    if ( !Tiles_Unpack( &data->tiles, (const byte *)raw, tileBytes ) ) {
+        Log_FPrintf( SYS_WRN, "WARNING: paged out map file '%s' is corrupt\n", data->evictPath );
+        Map_FreeTiles( data );
+        FreeMemory( buffer, TAG_MAP );
+        FreeMemory( f.v );
+        return false;
+    }
+    data->texcoords = NULL;
+    if ( f.h[0] != tileBytes ) {
+        data->texcoords = (spriteCoord_t *)GetMemory( spriteBytes, TAG_MAP );
+        memcpy( data->texcoords, raw + tileBytes, spriteBytes );
+    }
+    FreeMemory( buffer, TAG_MAP );
+    FreeMemory( f.v );
+
+    return true;
+}
+
+/*
+* Map_ReloadSource: the paged out copy is unusable so the tiles are read back from the map's own file.
+* Only the tiles were paged out, so the entities, tileset, textures and shader stay as they were and
+* just the tile edits since the map was last saved are lost.
+*/
+static bool Map_ReloadSource( mapData_t *data )
+{
+    union {
+        void *v;
+        char *b;
+    } f;
+    char path[MAX_OSPATH];
+    const char *fileName;
+    mapData_t *tmpData;
+    bool ok;
+
+    // data->name is the map's own name, the project's index knows which file it came from
+    fileName = data->name;
+    for ( const auto& it : g_pProjectManager->GetMapIndex() ) {
+        if ( !N_stricmp( it.name.c_str(), data->name ) ) {
+            fileName = it.fileName.c_str();
+            break;
+        }
+    }
+
+    snprintf( path, sizeof( path ) - 1, "%s%s%cmaps%c%s"
+        , g_pProjectManager->GetProject()->m_FilePath.c_str(),
+        g_pProjectManager->GetProject()->m_AssetPath.c_str(), PATH_SEP, PATH_SEP, fileName );
+
+    LoadFile( path, &f.v );
+    if ( !f.v ) {
+        Log_FPrintf( SYS_WRN, "WARNING: failed to open map file '%s'\n", path );
+        return false;
+    }
+
+    tmpData = (mapData_t *)GetMemory( sizeof(*tmpData) );
+    ok = Map_ParseFile( f.b, fileName, tmpData, false );
+    FreeMemory( f.v );
+
+    if ( ok ) {
+        data->tiles = tmpData->tiles;
+        data->width = tmpData->width;
+        data->height = tmpData->height;
+        data->numTiles = tmpData->numTiles;
+    } else {
+        Map_FreeTiles( tmpData );
+    }
+    FreeMemory( tmpData->texcoords, TAG_MAP );
+    FreeMemory( tmpData );
+
+    return ok;
+}
+
+/*
+* Map_Reload: pages an evicted map back in, false if neither its page file nor its map file could
+* give its tiles back, the map is then left evicted
+*/
+static bool Map_Reload( mapData_t *data )
+{
+    bool fromSource;
+
+    fromSource = !data->evictPath[0] || !Map_ReloadPaged( data );
+    if ( fromSource ) {
+        Log_FPrintf( SYS_WRN, "WARNING: reloading the tiles of map '%s' from its map file, tile changes since it was last saved are lost\n", data->name );
+        if ( !Map_ReloadSource( data ) ) {
+            // keep the page file, it may still be recoverable by hand
+            Log_FPrintf( SYS_WRN, "WARNING: map '%s' can't be paged in or reloaded, leaving it unloaded\n", data->name );
+            return false;
+        }
+    }
+    if ( data->evictPath[0] ) {
+        remove( data->evictPath );
+    }
+    data->evictPath[0] = '\0';
+    data->evicted = false;
+
+    for ( int i = 0; i < Walnut::NUM_TEXTURE_BUNDLES; i++ ) {
+        if ( data->textureNames[i][0] ) {
+            data->textures[i] = Tex_Load( data->textureNames[i] );
+        }
+    }
+
+    // a map read from its file has no sprites until its tileset is built
+    if ( fromSource && data->textures[Walnut::TB_DIFFUSEMAP] ) {
+        Map_BuildTilesetData( data, data->textures[Walnut::TB_DIFFUSEMAP]->GetWidth(), data->textures[Walnut::TB_DIFFUSEMAP]->GetHeight() );
+    }
+
+    Log_Printf( "Paged in map '%s'\n", data->name );
+
+    return true;
+}
+
+static void Map_TrimCache( const mapData_t *keep )
+{
+    uint64_t resident, budget;
+    mapData_t *oldest;
+
+    budget = (uint64_t)g_pPrefsDlg->m_nMapCacheBudget * 1024 * 1024;
+    resident = Map_ResidentMemory();
+
+    while ( resident > budget ) {
+        oldest = NULL;
+        for ( auto& it : g_MapCache ) {
+            if ( it.evicted || std::addressof( it ) == keep || std::addressof( it ) == mapData || !it.tiles.index ) {
+                continue;
+            }
+            if ( !oldest || it.lastUsed < oldest->lastUsed ) {
+                oldest = std::addressof( it );
+            }
+        }
+        if ( !oldest ) {
+            break;
+        }
+
+        const uint64_t size = Map_TileBytes( oldest ) + Map_SpriteBytes( oldest );
+        if ( !Map_Evict( oldest ) ) {
+            break;
+        }
+        resident -= size;
+    }
+}
+
+/*
+* Map_Acquire: marks data as the most recently used map, paging it back in if it was evicted,
+* anything that switches mapData to another open map should go through this. Returns NULL if
+* the map couldn't be paged back in.
+*/
+mapData_t *Map_Acquire( mapData_t *data )
+{
+    if ( !data ) {
+        return NULL;
+    }
+    if ( data->evicted && !Map_Reload( data ) ) {
+        return NULL;
+    }
+    data->lastUsed = ++s_nMapUseCounter;
+
+    Map_TrimCache( data );
+
+    return data;
+}
+
+void Map_Shutdown( void )
+{
+    for ( auto& it : g_MapCache ) {
+        if ( it.evicted ) {
+            remove( it.evictPath );
+        }
+    }
+}
+
 void Map_ImportFile( const char *filename )
 {
     Map_LoadFile( filename );
@@ -1054,8 +1536,6 @@ static void Map_GenerateShader( void )
 
 void Map_BuildTileset( void )
 {
-    uint32_t y, x;
-
     if ( !mapData->textures[Walnut::TB_DIFFUSEMAP] ) {
         Sys_MessageBox( "Tileset Error", "You must provide at least a diffuse texture map to build a tileset", MB_OK );
         g_pMapInfoDlg->m_bTilesetModified = true;
@@ -1072,10 +1552,30 @@ void Map_BuildTileset( void )
         return;
     }
 
-    mapData->textureWidth = mapData->textures[Walnut::TB_DIFFUSEMAP]->GetWidth();
-    mapData->textureHeight = mapData->textures[Walnut::TB_DIFFUSEMAP]->GetHeight();
-    mapData->tileset.tileCountX = mapData->textures[Walnut::TB_DIFFUSEMAP]->GetWidth() / mapData->tileset.tileWidth;
-    mapData->tileset.tileCountY = mapData->textures[Walnut::TB_DIFFUSEMAP]->GetHeight() / mapData->tileset.tileHeight;
+    // the tile count may have changed, size the sprites for the new one
+    FreeMemory( mapData->texcoords, TAG_MAP );
+    mapData->texcoords = NULL;
+
+    Map_BuildTilesetData( mapData, mapData->textures[Walnut::TB_DIFFUSEMAP]->GetWidth(), mapData->textures[Walnut::TB_DIFFUSEMAP]->GetHeight() );
+}
+
+/*
+* Map_BuildTilesetData: generates the tileset's sprite coordinates from the diffuse map's dimensions,
+* doesn't touch any GL state so the headless compiler can use it. If data->texcoords is NULL it's
+* allocated to fit the tileset.
+*/
+bool Map_BuildTilesetData( mapData_t *data, uint32_t textureWidth, uint32_t textureHeight )
+{
+    uint32_t y, x;
+
+    if ( !data->tileset.tileWidth || !data->tileset.tileHeight || !textureWidth || !textureHeight ) {
+        return false;
+    }
+
+    data->textureWidth = textureWidth;
+    data->textureHeight = textureHeight;
+    data->tileset.tileCountX = textureWidth / data->tileset.tileWidth;
+    data->tileset.tileCountY = textureHeight / data->tileset.tileHeight;
 
     auto genCoords = [&](const glm::vec2& sheetDims, const glm::vec2& spriteDims, const glm::vec2& coords, spriteCoord_t *texcoords) {
         const glm::vec2 min = { ( ( coords.x + 1 ) * spriteDims.x ) / sheetDims.x, ( ( coords.y + 1 ) * spriteDims.y ) / sheetDims.y };
@@ -1094,15 +1594,20 @@ void Map_BuildTileset( void )
         (*texcoords)[3][1] = max.y;
     };
 
-    mapData->tileset.numTiles = mapData->tileset.tileCountX * mapData->tileset.tileCountY;
+    data->tileset.numTiles = data->tileset.tileCountX * data->tileset.tileCountY;
+    if ( !data->texcoords ) {
+        data->texcoords = (spriteCoord_t *)GetMemory( sizeof(*data->texcoords) * data->tileset.numTiles, TAG_MAP );
+    }
     
-    for ( y = 0; y < mapData->tileset.tileCountY; y++ ) {
-        for ( x = 0; x < mapData->tileset.tileCountX; x++ ) {
-            genCoords( { mapData->textures[Walnut::TB_DIFFUSEMAP]->GetWidth(), mapData->textures[Walnut::TB_DIFFUSEMAP]->GetHeight() },
-                    { mapData->tileset.tileWidth, mapData->tileset.tileHeight }, { x, y },
-                    &mapData->texcoords[y * mapData->tileset.tileCountX + x] );
+    for ( y = 0; y < data->tileset.tileCountY; y++ ) {
+        for ( x = 0; x < data->tileset.tileCountX; x++ ) {
+            genCoords( { textureWidth, textureHeight },
+                    { data->tileset.tileWidth, data->tileset.tileHeight }, { x, y },
+                    &data->texcoords[y * data->tileset.tileCountX + x] );
         }
     }
+
+    return true;
 }
 
 void Map_SaveSelected( const char *filename );
@@ -3,22 +3,43 @@
 
 #pragma once
 
-typedef vec2_t spriteCoord_t[4];
+/*
+* mapEntities_t: a map's entities packed down to the on-disk layout, holes dropped and checkpoint
+* handles turned back into indices
+*/
+typedef struct {
+    mapcheckpoint_t checkpoints[MAX_MAP_CHECKPOINTS];
+    mapspawn_t spawns[MAX_MAP_SPAWNS];
+    maplight_t lights[MAX_MAP_LIGHTS];
+    mapsecret_t secrets[MAX_MAP_SECRETS];
+
+    int numCheckpoints;
+    int numSpawns;
+    int numLights;
+    int numSecrets;
+} mapEntities_t;
 
 typedef struct {
     char name[MAX_NPATH];
 
+    // indexed by slot, in the editor mapspawn_t::checkpoint and mapsecret_t::trigger are checkpoint handles
     mapcheckpoint_t checkpoints[MAX_MAP_CHECKPOINTS];
     mapspawn_t spawns[MAX_MAP_SPAWNS];
     maplight_t lights[MAX_MAP_LIGHTS];
     mapsecret_t secrets[MAX_MAP_SECRETS];
 
+    slotMap_t<MAX_MAP_CHECKPOINTS> checkpointSlots;
+    slotMap_t<MAX_MAP_SPAWNS> spawnSlots;
+    slotMap_t<MAX_MAP_LIGHTS> lightSlots;
+    slotMap_t<MAX_MAP_SECRETS> secretSlots;
+
     tile2d_info_t tileset;
     spriteCoord_t *texcoords;
-    maptile_t *tiles;
+    tileStore_t tiles; // width x height, numTiles may be smaller while an import is pending
 
     Walnut::CShader *shader;
-    Walnut::Image *textures[Walnut::NUM_TEXTURE_BUNDLES];
+    CTexture *textures[Walnut::NUM_TEXTURE_BUNDLES];
+    char textureNames[Walnut::NUM_TEXTURE_BUNDLES][MAX_OSPATH]; // as written in the map file
 
     vec3_t ambientColor;
     float ambientIntensity;
@@ -30,14 +51,17 @@ typedef struct {
     int height;
 
     int numTiles;
-    int numLights;
-    int numCheckpoints;
-    int numSpawns;
-    int numSecrets;
+
+    // LRU state for the map cache, evicted maps have their tiles and sprites in evictPath
+    uint64_t lastUsed;
+    bool evicted;
+    char evictPath[MAX_OSPATH];
 } mapData_t;
 
 extern mapData_t *mapData;
-extern std::vector<mapData_t> g_MapCache;
+
+// a list so pointers into it held by the project and dialogs stay valid as maps are added
+extern std::list<mapData_t> g_MapCache;
 
 void Map_Init( void );
 void Map_Save( void );
@@ -48,8 +72,18 @@ void Map_Resize( void );
 
 void Map_New( void );
 void Map_Free( void );
+void Map_Shutdown( void );
+void Map_FreeTiles( mapData_t *data );
+
+mapData_t *Map_Acquire( mapData_t *data );
+uint64_t Map_ResidentMemory( void );
 
 void Map_BuildTileset( void );
+bool Map_BuildTilesetData( mapData_t *data, uint32_t textureWidth, uint32_t textureHeight );
+
+void Map_PackEntities( const mapData_t *data, mapEntities_t *out );
+
+bool Map_ParseFile( const char *text, const char *name, mapData_t *data, bool loadTextures );
 
 void Map_ImportFile( const char *filename );
 void Map_SaveSelected( const char *filename );
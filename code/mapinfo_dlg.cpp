@@ -9,8 +9,6 @@
 #define NORMAL_SCALE_XY 0
 #define NORMAL_SCALE_XY_HEIGHT 1
 
-constexpr const byte null_sides[DIR_NULL] = { 0 };
-
 typedef struct {
 	bool active;
 
@@ -80,33 +78,44 @@ static const char *LightTypeToString( int type ) {
 }
 
 static void RemoveSecret( mapsecret_t *secret ) {
+	Slot_Free( &mapData->secretSlots, (uint32_t)( secret - mapData->secrets ) );
 	memset( secret, 0, sizeof( *secret ) );
-	memmove( secret, secret + 1, sizeof( *secret ) * (unsigned)( &mapData->secrets[ mapData->numSecrets - 1 ] - secret ) );
-	mapData->numSecrets--;
 	g_pMapInfoDlg->SetModified( true, true );
 }
 
 static void RemoveCheckpoint( mapcheckpoint_t *checkpoint ) {
+	Slot_Free( &mapData->checkpointSlots, (uint32_t)( checkpoint - mapData->checkpoints ) );
 	memset( checkpoint, 0, sizeof( *checkpoint ) );
-	memmove( checkpoint, checkpoint + 1, sizeof( *checkpoint ) * (unsigned)( &mapData->checkpoints[ mapData->numCheckpoints - 1 ] - checkpoint ) );
-	mapData->numCheckpoints--;
 	g_pMapInfoDlg->SetModified( true, true );
 }
 
 static void RemoveLight( maplight_t *light ) {
+	Slot_Free( &mapData->lightSlots, (uint32_t)( light - mapData->lights ) );
 	memset( light, 0, sizeof( *light ) );
-	memmove( light, light + 1, sizeof( *light ) * (unsigned)( &mapData->lights[ mapData->numLights - 1 ] - light ) );
-	mapData->numLights--;
 	g_pMapInfoDlg->SetModified( true, true );
 }
 
 static void RemoveSpawn( mapspawn_t *spawn ) {
+	Slot_Free( &mapData->spawnSlots, (uint32_t)( spawn - mapData->spawns ) );
 	memset( spawn, 0, sizeof( *spawn ) );
-	memmove( spawn, spawn + 1, sizeof( *spawn ) * (unsigned)( &mapData->spawns[ mapData->numSpawns - 1 ] - spawn ) );
-	mapData->numSpawns--;
 	g_pMapInfoDlg->SetModified( true, true );
 }
 
+/*
+* CheckpointLabel: spawns and secrets hold checkpoint handles, one that no longer resolves means
+* its checkpoint was deleted
+*/
+static const char *CheckpointLabel( entityHandle_t handle )
+{
+	const int slot = Slot_Resolve( &mapData->checkpointSlots, handle );
+
+	return slot != -1 ? Frame_Printf( "Checkpoint #%i", slot ) : "None";
+}
+
+/*
+* DrawVec3Control: id is used across the va() calls below, so callers build it with Frame_Printf
+* rather than va() or it could be overwritten halfway through
+*/
 static void DrawVec3Control( const char *label, const char *id, uvec3_t values, float resetValue = 0.0f )
 {
 	ImGuiIO& io = ImGui::GetIO();
@@ -739,6 +748,27 @@ void CMapInfoDlg::ProjectSettingsDlg( void )
 				}
 			}
 
+			// indexed but never opened, these only get parsed once picked
+			const std::vector<mapData_t *>& openMaps = g_pProjectManager->GetMapList();
+			for ( const auto& it : g_pProjectManager->GetMapIndex() ) {
+				if ( std::find_if( openMaps.begin(), openMaps.end(),
+					[&it]( const mapData_t *map ) { return it.name == map->name; } ) != openMaps.end() )
+				{
+					continue;
+				}
+				if ( ImGui::Selectable( va( "%s##%s", it.name.c_str(), it.fileName.c_str() ), false ) ) {
+					if ( ::ConfirmModified() ) {
+						Map_LoadFile( it.fileName.c_str() );
+					}
+				}
+				if ( ImGui::IsItemHovered() ) {
+					ImGui::SetTooltip( "%s\n%ix%i, %.2f KiB\nTileset: %s\n%u checkpoints, %u spawns, %u lights, %u secrets",
+						it.fileName.c_str(), it.width, it.height, (double)it.fileSize / 1024.0,
+						it.tilesetShader.size() ? it.tilesetShader.c_str() : "none",
+						it.counts[PROJMAP_CHECKPOINTS], it.counts[PROJMAP_SPAWNS], it.counts[PROJMAP_LIGHTS], it.counts[PROJMAP_SECRETS] );
+				}
+			}
+
 			ImGui::EndCombo();
 		}
 
@@ -828,46 +858,50 @@ static const char *EntityTypeToString( entitytype_t type )
 
 void CMapInfoDlg::CreateSpawn( void )
 {
-	if ( mapData->numSpawns >= MAX_MAP_SPAWNS ) {
+	const int slot = Slot_Alloc( &mapData->spawnSlots );
+
+	if ( slot == -1 ) {
 		Log_FPrintf( SYS_WRN, "CMapInfoDlg::CreateSpawn: MAX_MAP_SPAWNS (%i) hit\n", MAX_MAP_SPAWNS );
 		return;
 	}
-	memset( &mapData->spawns[ mapData->numSpawns ], 0, sizeof( mapspawn_t ) );
+	memset( &mapData->spawns[ slot ], 0, sizeof( mapspawn_t ) );
 	SetModified( true, true );
-	mapData->numSpawns++;
 }
 
 void CMapInfoDlg::CreateCheckpoint( void )
 {
-	if ( mapData->numCheckpoints >= MAX_MAP_CHECKPOINTS ) {
+	const int slot = Slot_Alloc( &mapData->checkpointSlots );
+
+	if ( slot == -1 ) {
 		Log_FPrintf( SYS_WRN, "CMapInfoDlg::CreateCheckpoint: MAX_MAP_CHECKPOINTS (%i) hit\n", MAX_MAP_CHECKPOINTS );
 		return;
 	}
-	memset( &mapData->checkpoints[ mapData->numCheckpoints ], 0, sizeof( mapcheckpoint_t ) );
+	memset( &mapData->checkpoints[ slot ], 0, sizeof( mapcheckpoint_t ) );
 	SetModified( true, true );
-	mapData->numCheckpoints++;
 }
 
 void CMapInfoDlg::CreateSecret( void )
 {
-	if ( mapData->numSecrets >= MAX_MAP_SECRETS ) {
+	const int slot = Slot_Alloc( &mapData->secretSlots );
+
+	if ( slot == -1 ) {
 		Log_FPrintf( SYS_WRN, "CMapInfoDlg::CreateSecret: MAX_MAP_SECRETS (%i) hit\n", MAX_MAP_SECRETS );
 		return;
 	}
-	memset( &mapData->secrets[ mapData->numSecrets ], 0, sizeof( mapsecret_t ) );
+	memset( &mapData->secrets[ slot ], 0, sizeof( mapsecret_t ) );
 	SetModified( true, true );
-	mapData->numSecrets++;
 }
 
 void CMapInfoDlg::CreateLight( void )
 {
-	if ( mapData->numLights >= MAX_MAP_LIGHTS ) {
+	const int slot = Slot_Alloc( &mapData->lightSlots );
+
+	if ( slot == -1 ) {
 		Log_FPrintf( SYS_WRN, "CMapInfoDlg::CreateLight: MAX_MAP_LIGHTS (%i) hit\n", MAX_MAP_LIGHTS );
 		return;
 	}
-	memset( &mapData->lights[ mapData->numLights ], 0, sizeof( maplight_t ) );
+	memset( &mapData->lights[ slot ], 0, sizeof( maplight_t ) );
 	SetModified( true, true );
-	mapData->numLights++;
 }
 
 static bool MapIsInProjectList( const char *name )
@@ -893,7 +927,7 @@ void CMapInfoDlg::SetCurrent( mapData_t *data )
 				// already in the list, don't let the user add it twice
 				return;
 			} else if ( !inProjectList && g_pProjectManager->GetProject().get() ) {
-				mapData = data;
+				mapData = Map_Acquire( data );
 				g_pProjectManager->GetProject()->m_MapList.emplace_back( data );
 				return;
 			}
@@ -905,7 +939,8 @@ void CMapInfoDlg::SetCurrent( mapData_t *data )
         }
     }
 
-    mapData = data;
+    // the map list hands back maps that may have been paged out
+    mapData = Map_Acquire( data );
     m_MapList.emplace_back( data );
 
 	bool present = false;
@@ -938,56 +973,66 @@ static inline void ImGui_Quad_TexCoords( const spriteCoord_t *texcoords, ImVec2&
     max = { (*texcoords)[1][0], (*texcoords)[1][1] };
 }
 
-
-uint64_t LittleLong(uint64_t l)
-{
-#ifdef __BIG_ENDIAN__
-	byte b1, b2, b3, b4, b5, b6, b7;
-
-	b1 = l & 0xff;
-	b2 = (l >> 8) & 0xff;
-	b3 = (l >> 16) & 0xff;
-	b4 = (l >> 24) & 0xff;
-	b5 = (l >> 32) & 0xff;
-	b6 = (l >> 40) & 0xff;
-	b7 = (l >> 48) & 0xff;
-
-	return ((uint64_t)b1<<48) + ((uint64_t)b2<<40) + ((uint64_t)b3<<32) + ((uint64_t)b4<<24) + ((uint64_t)b5<<16) + ((uint64_t)b6<<8) + b7;
-#else
-	return l;
-#endif
-}
-
-static void AddLump( const void *data, uint64_t size, mapheader_t *header, int lumpnum, FileStream *file )
+static const struct {
+	uint32_t flag;
+	const char *name;
+} s_SurfaceFlagNames[] = {
+	{ SURFACEPARM_METAL, "Metallic" },
+	{ SURFACEPARM_WOOD, "Wood" },
+	{ SURFACEPARM_FLESH, "Flesh" },
+	{ SURFACEPARM_WATER, "Water" },
+	{ SURFACEPARM_LAVA, "Lava" },
+	{ SURFACEPARM_NOSTEPS, "No Steps" },
+	{ SURFACEPARM_NODLIGHT, "No Dynamic Lighting" },
+	{ SURFACEPARM_NODAMAGE, "No Damage" },
+	{ SURFACEPARM_NOMARKS, "No Marks" },
+	{ SURFACEPARM_NOMISSILE, "No Missile" },
+	{ SURFACEPARM_NONSOLID, "Non Solid" },
+};
+
+static const char *s_SideNames[NUMDIRS] = {
+	"North", "North East", "East", "South East", "South", "South West", "West", "North West", "Inside"
+};
+
+/*
+* DrawTileStatistics: every count here is a popcount over the store's bitplanes, cheap enough to
+* redo each frame even on the largest maps
+*/
+static void DrawTileStatistics( const tileStore_t *tiles )
 {
-    lump_t *lump;
+	FrameVector<uint64_t> collision;
+	uint64_t nonSolid;
+	int i;
 
-    lump = &header->lumps[lumpnum];
-    lump->length = size;
-    lump->fileofs = LittleLong( file->GetPosition() );
+	if ( !tiles->planes ) {
+		ImGui::TextUnformatted( "No Tiles" );
+		return;
+	}
 
-    if ( size == 0 ) {
-        return;
-    }
+	collision.resize( tiles->planeWords );
+	for ( i = 0; i < NUMDIRS; i++ ) {
+		Bits_Or( collision.data(), collision.data(), Tiles_GetPlane( tiles, TILES_SIDE_PLANE( i ) ), tiles->planeWords );
+	}
 
-    file->Write( data, size );
-}
+	ImGui::SeparatorText( "Surface Flags" );
+	for ( const auto& it : s_SurfaceFlagNames ) {
+		ImGui::Text( "%s: %lu", it.name, Tiles_CountPlane( tiles, Tiles_FlagPlane( it.flag ) ) );
+	}
 
-static const char *GetAbsolutePath( const char *filename )
-{
-    if ( !strrchr( filename, PATH_SEP ) ) {
-        return filename;
-    }
-    const char *dir;
+	ImGui::SeparatorText( "Collision Sides" );
+	for ( i = 0; i < NUMDIRS; i++ ) {
+		ImGui::Text( "%s: %lu", s_SideNames[i], Tiles_CountPlane( tiles, TILES_SIDE_PLANE( i ) ) );
+	}
+	ImGui::Text( "Tiles With Collision: %lu", Bits_Count( collision.data(), tiles->planeWords ) );
 
-    dir = strrchr( filename, PATH_SEP );
-    return dir ? dir + 1 : filename;
+	nonSolid = Bits_CountAnd( collision.data(), Tiles_GetPlane( tiles, Tiles_FlagPlane( SURFACEPARM_NONSOLID ) ), tiles->planeWords );
+	if ( nonSolid ) {
+		ImGui::TextColored( ImVec4( 1.0f, 1.0f, 0.0f, 1.0f ), "%lu non solid tiles have collision sides", nonSolid );
+	}
 }
 
 void CMapInfoDlg::CompileMap( const std::string& fileName )
 {
-	bmf_t bmf;
-	FileStream file;
 	char path[MAX_OSPATH];
 	const char *ext;
 
@@ -1003,45 +1048,9 @@ void CMapInfoDlg::CompileMap( const std::string& fileName )
 		N_strncpyz( path, fileName.c_str(), sizeof( path ) - 1 );
 	}
 
-	if ( !file.Open( path, "wb" ) ) {
+	if ( !Map_CompileLevel( mapData, path, NULL ) ) {
 		Error( "CMapInfoDlg::CompileMap: failed to create .bmf file '%s'!", path );
 	}
-
-	bmf.ident = LEVEL_IDENT;
-    bmf.version = LEVEL_VERSION;
-    bmf.map.ident = MAP_IDENT;
-    bmf.map.version = MAP_VERSION;
-    bmf.tileset.magic = TILE2D_MAGIC;
-    bmf.tileset.version = TILE2D_VERSION;
-
-    bmf.map.mapWidth = mapData->width;
-    bmf.map.mapHeight = mapData->height;
-    VectorCopy( bmf.map.ambientLightColor, mapData->ambientColor );
-
-    memcpy( &bmf.tileset.info, &mapData->tileset, sizeof( mapData->tileset ) );
-    N_strncpyz( bmf.tileset.info.texture, GetAbsolutePath( bmf.tileset.info.texture ), sizeof( bmf.tileset.info.texture ) );
-
-	// overwritten later
-    file.Write( &bmf.ident, sizeof( bmf.ident ) );
-    file.Write( &bmf.version, sizeof( bmf.version ) );
-    file.Write( &bmf.map, sizeof( bmf.map ) );
-    file.Write( &bmf.tileset, sizeof( bmf.tileset ) );
-
-    AddLump( mapData->tiles, sizeof(maptile_t) * mapData->numTiles, &bmf.map, LUMP_TILES, &file );
-    AddLump( mapData->checkpoints, sizeof(mapcheckpoint_t) * mapData->numCheckpoints, &bmf.map, LUMP_CHECKPOINTS, &file );
-    AddLump( mapData->spawns, sizeof(mapspawn_t) * mapData->numCheckpoints, &bmf.map, LUMP_SPAWNS, &file );
-    AddLump( mapData->lights, sizeof(maplight_t) * mapData->numLights, &bmf.map, LUMP_LIGHTS, &file );
-    AddLump( mapData->texcoords, sizeof(spriteCoord_t) * mapData->tileset.numTiles, &bmf.map, LUMP_SPRITES, &file );
-	AddLump( mapData->secrets, sizeof( mapsecret_t ) * mapData->numSecrets, &bmf.map, LUMP_SECRETS, &file );
-
-	file.Seek( 0, SEEK_SET );
-
-    file.Write( &bmf.ident, sizeof( bmf.ident ) );
-    file.Write( &bmf.version, sizeof( bmf.version ) );
-    file.Write( &bmf.map, sizeof( bmf.map ) );
-    file.Write( &bmf.tileset, sizeof( bmf.tileset ) );
-
-	file.Close();
 }
 
 void CMapInfoDlg::Draw( void )
@@ -1113,9 +1122,7 @@ void CMapInfoDlg::Draw( void )
 				m_nTileX++;
 			}
 			if ( ImGui::IsKeyPressed( ImGuiKey_Enter, false ) || ImGui::IsKeyPressed( ImGuiKey_KeypadEnter, false ) ) {
-				maptile_t *t = &mapData->tiles[ y * mapData->width + x ];
-				t->index = m_nTileY * mapData->tileset.tileCountX + m_nTileX;
-				memcpy( t->texcoords, mapData->texcoords[ t->index ], sizeof(spriteCoord_t) );
+				mapData->tiles.index[ y * mapData->width + x ] = m_nTileY * mapData->tileset.tileCountX + m_nTileX;
 			}
 
 			y = clamp( y, 0, mapData->height - 1 );
@@ -1126,7 +1133,7 @@ void CMapInfoDlg::Draw( void )
 			if ( ImGui::CollapsingHeader( "Set Tile Sprite" ) ) {
 				uint32_t tileY, tileX;
 				spriteCoord_t *tile;
-				const Walnut::Image *texture = mapData->textures[Walnut::TB_DIFFUSEMAP];
+				const CTexture *texture = mapData->textures[Walnut::TB_DIFFUSEMAP];
 				ImVec2 min, max;
 
 				if ( !texture ) {
@@ -1140,9 +1147,7 @@ void CMapInfoDlg::Draw( void )
 
 							ImGui::PushID( (uintptr_t)tile );
 							if ( ImGui::ImageButton( (ImTextureID)(uintptr_t)texture->GetID(), { 64.0f, 64.0f }, min, max ) ) {
-								maptile_t *t = &mapData->tiles[ y * mapData->width + x ];
-								t->index = tileY * mapData->tileset.tileCountX + tileX;
-								memcpy( t->texcoords, *tile, sizeof(*tile) );
+								mapData->tiles.index[ y * mapData->width + x ] = tileY * mapData->tileset.tileCountX + tileX;
 								m_bMapModified = true;
 								m_bMapNameUpdated = false;
 								(void)0; // NEVER remove this dead code, for some reason, g++ WILL NOT compile it in
@@ -1162,7 +1167,7 @@ void CMapInfoDlg::Draw( void )
 		            const ImVec2 buttonSize = { 86, 48 };
 
 					auto sideButton = [&]( const char *name, dirtype_t dir ) {
-						const bool color = mapData->tiles[ y * mapData->width + x ].sides[dir];
+						const bool color = Tiles_HasSide( &mapData->tiles, y * mapData->width + x, dir );
 						ImGui::TableNextColumn();
 						if ( color ) {
 							ImGui::PushStyleColor( ImGuiCol_Button, ImVec4( 1.0f, 0.0f, 0.0f, 1.0f ) );
@@ -1170,7 +1175,7 @@ void CMapInfoDlg::Draw( void )
 							ImGui::PushStyleColor( ImGuiCol_ButtonHovered, ImVec4( 0.9f, 0.0f, 0.0f, 1.0f ) );
 						}
 						if ( ImGui::Button( name, buttonSize ) ) {
-							mapData->tiles[ y * mapData->width + x ].sides[dir] = !mapData->tiles[ y * mapData->width + x ].sides[dir];
+							Tiles_ToggleSide( &mapData->tiles, y * mapData->width + x, dir );
 							m_bMapModified = true;
 							m_bMapNameUpdated = false;
 						}
@@ -1183,7 +1188,7 @@ void CMapInfoDlg::Draw( void )
 					sideButton( "North", DIR_NORTH );
 					sideButton( "North East", DIR_NORTH_EAST );
 					sideButton( "West", DIR_WEST );
-					sideButton( "Inside", NUMDIRS );
+					sideButton( "Inside", DIR_NULL );
 					sideButton( "East", DIR_EAST );
 					sideButton( "South West", DIR_SOUTH_WEST );
 					sideButton( "South", DIR_SOUTH );
@@ -1191,14 +1196,14 @@ void CMapInfoDlg::Draw( void )
 		        }
 		        ImGui::EndTable();
 
-				const bool clear = memcmp( mapData->tiles[ y * mapData->width + x ].sides, null_sides, sizeof(null_sides) ) == 0;
+				const bool clear = !mapData->tiles.sides[ y * mapData->width + x ];
 				if ( clear ) {
 					ImGui::PushStyleColor( ImGuiCol_Button, ImVec4( 0.75f, 0.75f, 0.75f, 1.0f ) );
 					ImGui::PushStyleColor( ImGuiCol_ButtonActive, ImVec4( 0.75f, 0.75f, 0.75f, 1.0f ) );
 					ImGui::PushStyleColor( ImGuiCol_ButtonHovered, ImVec4( 0.75f, 0.75f, 0.75f, 1.0f ) );
 				}
 		        if ( ImGui::Button( "Clear Collision Sides" ) && !clear ) {
-		            memset( mapData->tiles[ y * mapData->width + x ].sides, 0, sizeof(mapData->tiles[ y * mapData->width + x ].sides) );
+		            Tiles_SetSides( &mapData->tiles, y * mapData->width + x, 0 );
 		        }
 				if ( clear ) {
 					ImGui::PopStyleColor( 3 );
@@ -1207,84 +1212,44 @@ void CMapInfoDlg::Draw( void )
 
 			if ( ImGui::BeginMenu( "Surface Flags" ) ) {
 				if ( MenuItemWithTooltip( "Metallic", "gives this tile special treatement as a metallic object" ) ) {
-					if ( mapData->tiles[y * mapData->width + x].flags & SURFACEPARM_METAL ) {
-						mapData->tiles[y * mapData->width + x].flags &= ~SURFACEPARM_METAL;
-					} else {
-						mapData->tiles[y * mapData->width + x].flags |= SURFACEPARM_METAL;
-					}
+					Tiles_ToggleFlags( &mapData->tiles, y * mapData->width + x, SURFACEPARM_METAL );
 				}
 				if ( MenuItemWithTooltip( "Wood", "gives this tile special treatement as a wood like object" ) ) {
-					if ( mapData->tiles[y * mapData->width + x].flags & SURFACEPARM_WOOD ) {
-						mapData->tiles[y * mapData->width + x].flags &= ~SURFACEPARM_WOOD;
-					} else {
-						mapData->tiles[y * mapData->width + x].flags |= SURFACEPARM_WOOD;
-					}
+					Tiles_ToggleFlags( &mapData->tiles, y * mapData->width + x, SURFACEPARM_WOOD );
 				}
 				if ( MenuItemWithTooltip( "Flesh", "make flesh sounds and effects with this tile" ) ) {
-					if ( mapData->tiles[y * mapData->width + x].flags & SURFACEPARM_FLESH ) {
-						mapData->tiles[y * mapData->width + x].flags &= ~SURFACEPARM_FLESH;
-					} else {
-						mapData->tiles[y * mapData->width + x].flags |= SURFACEPARM_FLESH;
-					}
+					Tiles_ToggleFlags( &mapData->tiles, y * mapData->width + x, SURFACEPARM_FLESH );
 				}
 				if ( MenuItemWithTooltip( "Water", "makes this tile be treated like water (DUH)" ) ) {
-					if ( mapData->tiles[y * mapData->width + x].flags & SURFACEPARM_WATER ) {
-						mapData->tiles[y * mapData->width + x].flags &= ~SURFACEPARM_WATER;
-					} else {
-						mapData->tiles[y * mapData->width + x].flags |= SURFACEPARM_WATER;
-					}
+					Tiles_ToggleFlags( &mapData->tiles, y * mapData->width + x, SURFACEPARM_WATER );
 				}
 				if ( MenuItemWithTooltip( "Lava", "makes this tile be treated like lava (DUH)" ) ) {
-					if ( mapData->tiles[y * mapData->width + x].flags & SURFACEPARM_LAVA ) {
-						mapData->tiles[y * mapData->width + x].flags &= ~SURFACEPARM_LAVA;
-					} else {
-						mapData->tiles[y * mapData->width + x].flags |= SURFACEPARM_LAVA;
-					}
+					Tiles_ToggleFlags( &mapData->tiles, y * mapData->width + x, SURFACEPARM_LAVA );
 				}
 				if ( MenuItemWithTooltip( "No Steps", "no sound is created by walking this tile" ) ) {
-					if ( mapData->tiles[y * mapData->width + x].flags & SURFACEPARM_NOSTEPS ) {
-						mapData->tiles[y * mapData->width + x].flags &= ~SURFACEPARM_NOSTEPS;
-					} else {
-						mapData->tiles[y * mapData->width + x].flags |= SURFACEPARM_NOSTEPS;
-					}
+					Tiles_ToggleFlags( &mapData->tiles, y * mapData->width + x, SURFACEPARM_NOSTEPS );
 				}
 				if ( MenuItemWithTooltip( "No Dynamic Lighting", "disable dynamic lighting for this specific tile" ) ) {
-					if ( mapData->tiles[y * mapData->width + x].flags & SURFACEPARM_NODLIGHT ) {
-						mapData->tiles[y * mapData->width + x].flags &= ~SURFACEPARM_NODLIGHT;
-					} else {
-						mapData->tiles[y * mapData->width + x].flags |= SURFACEPARM_NODLIGHT;
-					}
+					Tiles_ToggleFlags( &mapData->tiles, y * mapData->width + x, SURFACEPARM_NODLIGHT );
 				}
 				if ( MenuItemWithTooltip( "No Damage", "disable fall damage for this specific tile" ) ) {
-					if ( mapData->tiles[y * mapData->width + x].flags & SURFACEPARM_NODAMAGE ) {
-						mapData->tiles[y * mapData->width + x].flags &= ~SURFACEPARM_NODAMAGE;
-					} else {
-						mapData->tiles[y * mapData->width + x].flags |= SURFACEPARM_NODAMAGE;
-					}
+					Tiles_ToggleFlags( &mapData->tiles, y * mapData->width + x, SURFACEPARM_NODAMAGE );
 				}
 				if ( MenuItemWithTooltip( "No Marks", "disable gfx marks for this specific tile" ) ) {
-					if ( mapData->tiles[y * mapData->width + x].flags & SURFACEPARM_NOMARKS ) {
-						mapData->tiles[y * mapData->width + x].flags &= ~SURFACEPARM_NOMARKS;
-					} else {
-						mapData->tiles[y * mapData->width + x].flags |= SURFACEPARM_NOMARKS;
-					}
+					Tiles_ToggleFlags( &mapData->tiles, y * mapData->width + x, SURFACEPARM_NOMARKS );
 				}
 				if ( MenuItemWithTooltip( "No Missile", "missiles will not explode when hitting this tile" ) ) {
-					if ( mapData->tiles[y * mapData->width + x].flags & SURFACEPARM_NOMISSILE ) {
-						mapData->tiles[y * mapData->width + x].flags &= ~SURFACEPARM_NOMISSILE;
-					} else {
-						mapData->tiles[y * mapData->width + x].flags |= SURFACEPARM_NOMISSILE;
-					}
+					Tiles_ToggleFlags( &mapData->tiles, y * mapData->width + x, SURFACEPARM_NOMISSILE );
 				}
 
-				const bool clearFlags = !mapData->tiles[y * mapData->width + x].flags;
+				const bool clearFlags = !mapData->tiles.flags[y * mapData->width + x];
 				if ( clearFlags ) {
 					ImGui::PushStyleColor( ImGuiCol_Button, ImVec4( 0.75f, 0.75f, 0.75f, 1.0f ) );
 					ImGui::PushStyleColor( ImGuiCol_ButtonActive, ImVec4( 0.75f, 0.75f, 0.75f, 1.0f ) );
 					ImGui::PushStyleColor( ImGuiCol_ButtonHovered, ImVec4( 0.75f, 0.75f, 0.75f, 1.0f ) );
 				}
 				if ( ImGui::Button( "Clear Surface Flags" ) ) {
-					mapData->tiles[y * mapData->width + x].flags = 0;
+					Tiles_SetFlags( &mapData->tiles, y * mapData->width + x, 0 );
 					m_bMapModified = true;
 					m_bMapNameUpdated = false;
 				}
@@ -1294,14 +1259,14 @@ void CMapInfoDlg::Draw( void )
 				ImGui::EndMenu();
 			}
 
-			const bool clearFlags = !mapData->tiles[y * mapData->width + x].flags;
+			const bool clearFlags = !mapData->tiles.flags[y * mapData->width + x];
 			if ( clearFlags ) {
 				ImGui::PushStyleColor( ImGuiCol_Button, ImVec4( 0.75f, 0.75f, 0.75f, 1.0f ) );
 				ImGui::PushStyleColor( ImGuiCol_ButtonActive, ImVec4( 0.75f, 0.75f, 0.75f, 1.0f ) );
 				ImGui::PushStyleColor( ImGuiCol_ButtonHovered, ImVec4( 0.75f, 0.75f, 0.75f, 1.0f ) );
 			}
 			if ( ImGui::Button( "Clear All Tile Flags" ) ) {
-				mapData->tiles[y * mapData->width + x].flags = 0;
+				Tiles_SetFlags( &mapData->tiles, y * mapData->width + x, 0 );
 				m_bMapModified = true;
 				m_bMapNameUpdated = false;
 			}
@@ -1341,7 +1306,7 @@ void CMapInfoDlg::Draw( void )
 	if ( m_bHasCheckpointWindow ) {
 		if ( ImGui::Begin( "Editing Checkpoint", &m_bHasCheckpointWindow, ImGuiWindowFlags_AlwaysAutoResize ) ) {
 			ImGui::SeparatorText( va( "checkpoint %u", (unsigned)( m_pCheckpointEdit - mapData->checkpoints ) ) );
-			DrawVec3Control( "Position", va( "EditCheckpoint%u", i ), m_pCheckpointEdit->xyz );
+			DrawVec3Control( "Position", Frame_Printf( "EditCheckpoint%u", i ), m_pCheckpointEdit->xyz );
 			if ( ImGui::Button( va( "DELETE##CheckpointWindowDeleteButton%u", (unsigned)( m_pCheckpointEdit - mapData->checkpoints ) ) ) ) {
 				RemoveCheckpoint( m_pCheckpointEdit );
 				m_pCheckpointEdit = NULL;
@@ -1361,7 +1326,7 @@ void CMapInfoDlg::Draw( void )
 			const char *entityId = "Entity ID";
 
 			ImGui::SeparatorText( va( "spawn %u", (unsigned)( m_pSpawnEdit - mapData->spawns ) ) );
-			DrawVec3Control( "Position", va( "EditSpawn%u", i ), m_pSpawnEdit->xyz );
+			DrawVec3Control( "Position", Frame_Printf( "EditSpawn%u", i ), m_pSpawnEdit->xyz );
 			if ( g_pProjectManager->GetProject()->m_EntityList[ mapData->spawns[i].entitytype ].size() ) {
 				if ( mapData->spawns[i].entityid != -1 ) {
 					entityId = g_pProjectManager->GetProject()->m_EntityList[ mapData->spawns[i].entitytype ][mapData->spawns[i].entityid].m_Name.c_str();
@@ -1384,15 +1349,20 @@ void CMapInfoDlg::Draw( void )
 				ImGui::PopStyleColor( 3 );
 				ImGui::EndCombo();
 			}
-			if ( ImGui::BeginCombo( "Bind to Checkpoint", va( "Checkpoint #%u", m_pSpawnEdit->checkpoint ) ) ) {
+			if ( ImGui::BeginCombo( "Bind to Checkpoint", CheckpointLabel( m_pSpawnEdit->checkpoint ) ) ) {
 				const ImVec4& color = style.Colors[ ImGuiCol_FrameBg ];
 
 				ImGui::PushStyleColor( ImGuiCol_FrameBg, ImVec4( color.x, color.y, color.z, 1.0f ) );
 				ImGui::PushStyleColor( ImGuiCol_FrameBgActive, ImVec4( color.x, color.y, color.z, 1.0f ) );
 				ImGui::PushStyleColor( ImGuiCol_FrameBgHovered, ImVec4( color.x, color.y, color.z, 1.0f ) );
-				for ( i = 0; i < mapData->numCheckpoints; i++ ) {
-					if ( ImGui::Selectable( va( "Checkpoint %u##SpawnSelectCheckpointIndex", i ), ( m_pSpawnEdit->checkpoint == i ) ) ) {
-						m_pSpawnEdit->checkpoint = i;
+				for ( i = 0; i < mapData->checkpointSlots.numSlots; i++ ) {
+					if ( !mapData->checkpointSlots.used[i] ) {
+						continue;
+					}
+					if ( ImGui::Selectable( va( "Checkpoint %u##SpawnSelectCheckpointIndex", i ),
+						( Slot_Resolve( &mapData->checkpointSlots, m_pSpawnEdit->checkpoint ) == (int)i ) ) )
+					{
+						m_pSpawnEdit->checkpoint = Slot_Handle( &mapData->checkpointSlots, i );
 						SetModified( true, true );
 						Log_Printf( "Spawn %u linked to checkpoint %u.\n", (unsigned)( m_pSpawnEdit - mapData->spawns ), i );
 					}
@@ -1445,7 +1415,7 @@ void CMapInfoDlg::Draw( void )
 	if ( m_bHasLightWindow ) {
 		if ( ImGui::Begin( "Editing Light", &m_bHasLightWindow, ImGuiWindowFlags_AlwaysAutoResize ) ) {
 			ImGui::SeparatorText( va( "light %u", (unsigned)( m_pLightEdit - mapData->lights ) ) );
-			DrawVec3Control( "Position", va( "EditLight%u", i ), m_pLightEdit->origin );
+			DrawVec3Control( "Position", Frame_Printf( "EditLight%u", i ), m_pLightEdit->origin );
 			if ( m_pLightEdit->type == LIGHT_DIRECTIONAL ) {
 				if ( ImGui::SliderAngle( "Direction", &m_pLightEdit->angle ) ) {
 					SetModified( true, true );
@@ -1534,9 +1504,14 @@ void CMapInfoDlg::Draw( void )
                 }
 
                 if ( ImGui::BeginTabItem( it->m_pMapData->name, &it->m_bUsed ) ) {
-                    mapData = it->m_pMapData;
+                    mapData = Map_Acquire( it->m_pMapData );
 					m_pCurrentMap = it;
                     ImGui::EndTabItem();
+
+					// couldn't be paged back in, close its tab rather than retrying every frame
+					if ( !mapData ) {
+						it->m_bUsed = false;
+					}
                 }
 
 				if ( !it->m_bUsed ) {
@@ -1558,7 +1533,7 @@ void CMapInfoDlg::Draw( void )
 			g_pEditor->m_InputFocus = EditorInputFocus::ToolFocus;
 		}
 
-		if ( empty ) {
+		if ( empty || !mapData ) {
 			ImGui::End();
 			return;
 		}
@@ -1584,6 +1559,7 @@ void CMapInfoDlg::Draw( void )
 				} else if ( mapData->width > MAX_MAP_WIDTH ) {
 					mapData->width = MAX_MAP_WIDTH;
 				}
+				Map_Resize();
 			}
 
 			ImGui::TextUnformatted( "Height: " );
@@ -1597,19 +1573,30 @@ void CMapInfoDlg::Draw( void )
 				} else if ( mapData->height > MAX_MAP_HEIGHT ) {
 					mapData->height = MAX_MAP_HEIGHT;
 				}
+				Map_Resize();
 			}
 
 			if ( ImGui::ColorEdit3( "Ambient Light Color", mapData->ambientColor, ImGuiColorEditFlags_HDR ) ) {
 				SetModified( true, true );
 			}
 
+			if ( ImGui::Button( "Clear Tiles" ) && Sys_MessageBox( "Clear Tiles", va( "Clear every tile in '%s'? This can't be undone.", mapData->name ),
+				MB_YESNO | MB_ICONQUESTION ) == IDYES )
+			{
+				Tiles_Clear( &mapData->tiles );
+				SetModified( true, true );
+			}
+
 			ImGui::NewLine();
 
 			ImGui::TreePop();
 		}
 
 		if ( ImGui::TreeNodeEx( (void *)(uintptr_t)"##LightMapInfoDlg", ImGuiTreeNodeFlags_SpanAvailWidth, "Lights" ) ) {
-			for ( i = 0; i < mapData->numLights; i++ ) {
+			for ( i = 0; i < mapData->lightSlots.numSlots; i++ ) {
+				if ( !mapData->lightSlots.used[i] ) {
+					continue;
+				}
 				ImGui::PushStyleVar( ImGuiStyleVar_FramePadding, ImVec2( 4, 4 ) );
 
 				open = ImGui::TreeNodeEx( (void *)(uintptr_t)&mapData->lights[i], treeNodeFlags, "light %u", i );
@@ -1628,7 +1615,7 @@ void CMapInfoDlg::Draw( void )
 						m_pLightEdit = NULL;
 						SetModified( true, true );
 					}
-					DrawVec3Control( "Position", va( "EditLightNoWindow%u", i ), mapData->lights[i].origin );
+					DrawVec3Control( "Position", Frame_Printf( "EditLightNoWindow%u", i ), mapData->lights[i].origin );
 					if ( mapData->lights[i].type == LIGHT_DIRECTIONAL ) {
 						if ( ImGui::SliderAngle( "Direction", &mapData->lights[i].angle ) ) {
 							SetModified( true, true );
@@ -1688,7 +1675,10 @@ void CMapInfoDlg::Draw( void )
 		}
 
 		if ( ImGui::TreeNodeEx( (void *)(uintptr_t)"##SecretsMapInfoDlg", ImGuiTreeNodeFlags_SpanAvailWidth, "Secrets" ) ) {
-			for ( i = 0; i < mapData->numSecrets; i++ ) {
+			for ( i = 0; i < mapData->secretSlots.numSlots; i++ ) {
+				if ( !mapData->secretSlots.used[i] ) {
+					continue;
+				}
 				ImGui::PushStyleVar( ImGuiStyleVar_FramePadding, ImVec2( 4, 4 ) );
 
 				open = ImGui::TreeNodeEx( (void *)(uintptr_t)&mapData->secrets[i], treeNodeFlags, "secret %u", i );
@@ -1718,7 +1708,10 @@ void CMapInfoDlg::Draw( void )
 		}
 		
 		if ( ImGui::TreeNodeEx( (void *)(uintptr_t)"##ChechkpointMapInfoDlg", ImGuiTreeNodeFlags_SpanAvailWidth, "Checkpoints" ) ) {
-		    for ( i = 0; i < mapData->numCheckpoints; i++ ) {
+		    for ( i = 0; i < mapData->checkpointSlots.numSlots; i++ ) {
+				if ( !mapData->checkpointSlots.used[i] ) {
+					continue;
+				}
 				ImGui::PushStyleVar( ImGuiStyleVar_FramePadding, ImVec2( 4, 4 ) );
 
 				open = ImGui::TreeNodeEx( (void *)(uintptr_t)&mapData->checkpoints[i], treeNodeFlags, "checkpoint %u", i );
@@ -1737,7 +1730,7 @@ void CMapInfoDlg::Draw( void )
 						m_pCheckpointEdit = NULL;
 						SetModified( true, true );
 					}
-					DrawVec3Control( "Position", va( "EditCheckpointNoWindow%u", i ), mapData->checkpoints[i].xyz );
+					DrawVec3Control( "Position", Frame_Printf( "EditCheckpointNoWindow%u", i ), mapData->checkpoints[i].xyz );
 					ImGui::TreePop();
 				}
 				ImGui::PopStyleVar();
@@ -1749,7 +1742,10 @@ void CMapInfoDlg::Draw( void )
 		}
 
 		if ( ImGui::TreeNodeEx( (void *)(uintptr_t)"##SpawnsMapInfoDlg", ImGuiTreeNodeFlags_SpanAvailWidth, "Spawns" ) ) {
-			for ( i = 0; i < mapData->numSpawns; i++ ) {
+			for ( i = 0; i < mapData->spawnSlots.numSlots; i++ ) {
+				if ( !mapData->spawnSlots.used[i] ) {
+					continue;
+				}
 				const char *entityId = "Entity ID";
 
 				ImGui::PushStyleVar( ImGuiStyleVar_FramePadding, ImVec2( 4, 4 ) );
@@ -1770,7 +1766,7 @@ void CMapInfoDlg::Draw( void )
 						m_pSpawnEdit = NULL;
 						SetModified( true, true );
 					}
-					DrawVec3Control( "Position", va( "EditSpawnNoWindow%u", i ), mapData->spawns[i].xyz );
+					DrawVec3Control( "Position", Frame_Printf( "EditSpawnNoWindow%u", i ), mapData->spawns[i].xyz );
 
 					if ( g_pProjectManager->GetProject()->m_EntityList[ mapData->spawns[i].entitytype ].size() ) {
 						if ( mapData->spawns[i].entityid != -1 ) {
@@ -1794,15 +1790,20 @@ void CMapInfoDlg::Draw( void )
 						ImGui::PopStyleColor( 3 );
 						ImGui::EndCombo();
 					}
-					if ( ImGui::BeginCombo( va( "Bind to Checkpoint##EditSpawnBindToCheckpoint%u", i ), va( "Checkpoint #%u", mapData->spawns[i].checkpoint ) ) ) {
+					if ( ImGui::BeginCombo( va( "Bind to Checkpoint##EditSpawnBindToCheckpoint%u", i ), CheckpointLabel( mapData->spawns[i].checkpoint ) ) ) {
 						const ImVec4& color = style.Colors[ ImGuiCol_FrameBg ];
 
 						ImGui::PushStyleColor( ImGuiCol_FrameBg, ImVec4( color.x, color.y, color.z, 1.0f ) );
 						ImGui::PushStyleColor( ImGuiCol_FrameBgActive, ImVec4( color.x, color.y, color.z, 1.0f ) );
 						ImGui::PushStyleColor( ImGuiCol_FrameBgHovered, ImVec4( color.x, color.y, color.z, 1.0f ) );
-						for ( uint32_t a = 0; a < mapData->numCheckpoints; a++ ) {
-							if ( ImGui::Selectable( va( "Checkpoint %u##SpawnSelectCheckpointIndex%u", a, i ), ( mapData->spawns[i].checkpoint == a ) ) ) {
-								mapData->spawns[i].checkpoint = a;
+						for ( uint32_t a = 0; a < mapData->checkpointSlots.numSlots; a++ ) {
+							if ( !mapData->checkpointSlots.used[a] ) {
+								continue;
+							}
+							if ( ImGui::Selectable( va( "Checkpoint %u##SpawnSelectCheckpointIndex%u", a, i ),
+								( Slot_Resolve( &mapData->checkpointSlots, mapData->spawns[i].checkpoint ) == (int)a ) ) )
+							{
+								mapData->spawns[i].checkpoint = Slot_Handle( &mapData->checkpointSlots, a );
 								SetModified( true, true );
 								Log_Printf( "Spawn %u linked to checkpoint %u.\n", a, i );
 							}
@@ -1894,7 +1895,7 @@ void CMapInfoDlg::Draw( void )
 			if ( mapData->textures[ Walnut::TB_DIFFUSEMAP ] ) {
 				if ( ImGui::Button( "Clear" ) ) {
 					SetModified( true, true );
-					delete mapData->textures[ Walnut::TB_DIFFUSEMAP ];
+					Tex_Release( mapData->textures[ Walnut::TB_DIFFUSEMAP ] );
 					mapData->textures[ Walnut::TB_DIFFUSEMAP ] = NULL;
 				}
 			}
@@ -1917,7 +1918,7 @@ void CMapInfoDlg::Draw( void )
 			if ( mapData->textures[ Walnut::TB_NORMALMAP ] ) {
 				if ( ImGui::Button( "Clear" ) ) {
 					SetModified( true, true );
-					delete mapData->textures[ Walnut::TB_NORMALMAP ];
+					Tex_Release( mapData->textures[ Walnut::TB_NORMALMAP ] );
 					mapData->textures[ Walnut::TB_NORMALMAP ] = NULL;
 				}
 			}
@@ -1940,7 +1941,7 @@ void CMapInfoDlg::Draw( void )
 			if ( mapData->textures[ Walnut::TB_SPECULARMAP ] ) {
 				if ( ImGui::Button( "Clear" ) ) {
 					SetModified( true, true );
-					delete mapData->textures[ Walnut::TB_SPECULARMAP ];
+					Tex_Release( mapData->textures[ Walnut::TB_SPECULARMAP ] );
 					mapData->textures[ Walnut::TB_SPECULARMAP ] = NULL;
 				}
 			}
@@ -1964,7 +1965,7 @@ void CMapInfoDlg::Draw( void )
 			if ( mapData->textures[ Walnut::TB_LIGHTMAP ] ) {
 				if ( ImGui::Button( "Clear" ) ) {
 					SetModified( true, true );
-					delete mapData->textures[ Walnut::TB_LIGHTMAP ];
+					Tex_Release( mapData->textures[ Walnut::TB_LIGHTMAP ] );
 					mapData->textures[ Walnut::TB_LIGHTMAP ] = NULL;
 				}
 			}
@@ -1987,7 +1988,7 @@ void CMapInfoDlg::Draw( void )
 			if ( mapData->textures[ Walnut::TB_SHADOWMAP ] ) {
 				if ( ImGui::Button( "Clear" ) ) {
 					SetModified( true, true );
-					delete mapData->textures[ Walnut::TB_SHADOWMAP ];
+					Tex_Release( mapData->textures[ Walnut::TB_SHADOWMAP ] );
 					mapData->textures[ Walnut::TB_SHADOWMAP ] = NULL;
 				}
 			}
@@ -2024,6 +2025,11 @@ void CMapInfoDlg::Draw( void )
 			ImGui::TreePop();
 		}
 
+		if ( ImGui::TreeNodeEx( (void *)(uintptr_t)"##StatisticsMapInfoDlg", ImGuiTreeNodeFlags_SpanAvailWidth, "Statistics" ) ) {
+			DrawTileStatistics( &mapData->tiles );
+			ImGui::TreePop();
+		}
+
 		mapData->numTiles = mapData->width * mapData->height;
 
 		ImGui::End();
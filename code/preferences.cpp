@@ -1,4 +1,5 @@
 #include "editor.h"
+#include <thread>
 
 using json = nlohmann::json;
 
@@ -37,6 +38,9 @@ void CPrefsDlg::Reset( void )
     m_nFontScale = 1.0f;
     m_nOldFontScale = 1.0f;
     m_nAutoSaveTime = 5;
+    m_nMapCacheBudget = 256;
+    m_nJobThreads = 0;
+    m_nTextureCacheBudget = 256;
     m_nSelected = -1;
     m_nCameraMoveSpeed = 0.5f;
     m_nCameraRotationSpeed = 0.2f;
@@ -95,6 +99,21 @@ void CPrefsDlg::Load( void )
     m_nCameraRotationSpeed = data["CameraRotationSpeed"];
     
     m_nAutoSaveTime = data["AutoSaveTime"];
+    if ( data.contains( "MapCacheBudget" ) ) {
+        m_nMapCacheBudget = data["MapCacheBudget"];
+    } else {
+        m_nMapCacheBudget = 256;
+    }
+    if ( data.contains( "TextureCacheBudget" ) ) {
+        m_nTextureCacheBudget = data["TextureCacheBudget"];
+    } else {
+        m_nTextureCacheBudget = 256;
+    }
+    if ( data.contains( "JobThreads" ) ) {
+        m_nJobThreads = data["JobThreads"];
+    } else {
+        m_nJobThreads = 0;
+    }
     m_nFontScale = data["FontScale"];
 
     if ( data.contains( "EditorStyleShort" ) ) {
@@ -193,6 +212,9 @@ void CPrefsDlg::Save( void ) const
     data["CameraRotationSpeed"] = m_nCameraRotationSpeed;
 
     data["AutoSavetime"] = m_nAutoSaveTime;
+    data["MapCacheBudget"] = m_nMapCacheBudget;
+    data["TextureCacheBudget"] = m_nTextureCacheBudget;
+    data["JobThreads"] = m_nJobThreads;
     data["FontScale"] = m_nFontScale;
 
     std::ofstream file( va( "%spreferences.json", g_pEditor->m_CurrentPath.c_str() ), std::ios::out );
@@ -322,6 +344,48 @@ void CPrefsDlg::Draw( void )
                 ImGui::PopStyleColor( 3 );
             }
 
+            ImGui::TextUnformatted( "Open map memory budget" );
+            ImGui::SameLine();
+            if ( ImGui::InputInt( "MB##MapCacheBudget", &m_nMapCacheBudget, 16, 128 ) ) {
+                if ( m_nMapCacheBudget < 16 ) {
+                    m_nMapCacheBudget = 16;
+                }
+            }
+            if ( ImGui::IsItemHovered() ) {
+                ImGui::SetTooltip( "Inactive maps are paged out to disk once open maps use more than this, %lu MB in use",
+                    Map_ResidentMemory() / ( 1024 * 1024 ) );
+            }
+
+            ImGui::TextUnformatted( "Texture cache budget" );
+            ImGui::SameLine();
+            if ( ImGui::InputInt( "MB##TextureCacheBudget", &m_nTextureCacheBudget, 16, 128 ) ) {
+                if ( m_nTextureCacheBudget < 0 ) {
+                    m_nTextureCacheBudget = 0;
+                }
+                Tex_TrimCache();
+            }
+            if ( ImGui::IsItemHovered() ) {
+                texCacheStats_t stats;
+
+                Tex_GetCacheStats( &stats );
+                ImGui::SetTooltip( "Textures no open map uses are kept around until textures use more than this, %lu MB in use",
+                    stats.residentBytes / ( 1024 * 1024 ) );
+            }
+
+            ImGui::TextUnformatted( "Worker threads" );
+            ImGui::SameLine();
+            if ( ImGui::InputInt( "##JobThreads", &m_nJobThreads ) ) {
+                if ( m_nJobThreads < 0 ) {
+                    m_nJobThreads = 0;
+                } else if ( m_nJobThreads > (int)std::thread::hardware_concurrency() ) {
+                    m_nJobThreads = (int)std::thread::hardware_concurrency();
+                }
+            }
+            if ( ImGui::IsItemHovered() ) {
+                ImGui::SetTooltip( "Threads used for background work like compiling and loading, 0 uses one less than the number of cores (%u). "
+                    "Takes effect after a restart, %i running now", std::thread::hardware_concurrency(), Job_NumWorkers() );
+            }
+
             if ( ImGui::BeginCombo( "Editor Style", editorStyleToString() ) ) {
                 
                 if ( ImGui::Selectable( "Dark", m_bUseEditorStyleDark ) ) {
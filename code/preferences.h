@@ -59,6 +59,15 @@ public:
     float m_nCameraRotationSpeed;
 
     int m_nAutoSaveTime;
+
+    // megabytes of tiles open maps may keep resident before inactive ones are paged out
+    int m_nMapCacheBudget;
+
+    // megabytes of VRAM unreferenced textures may keep before the least recently used are freed
+    int m_nTextureCacheBudget;
+
+    // worker threads for the job system, 0 picks from the core count, read once at startup
+    int m_nJobThreads;
     ImGuiStyle m_EditorStyle;
 private:
     bool m_bUseEditorStyleDark;
@@ -4,6 +4,8 @@
 
 CProjectManager *g_pProjectManager;
 
+static void LoadProjectIndex( Project *proj );
+
 CProjectManager::CProjectManager( void )
 {
     char filePath[MAX_OSPATH*2+1];
@@ -21,10 +23,20 @@ CProjectManager::CProjectManager( void )
     }
 
     m_bLoaded = true;
+
+    // the index is listed from the asset index, so it's simply listed again the next time it's asked for
+    m_nWatchHandle = Watch_AddListener( [this]( const watchEvent_t& event ) {
+        if ( m_CurrentProject && ( ( event.flags & WATCH_RESCAN ) || event.isDirectory
+            || Asset_Classify( event.path.c_str() ) == ASSET_MAP ) )
+        {
+            m_CurrentProject->m_bIndexBuilt = false;
+        }
+    } );
 }
 
 CProjectManager::~CProjectManager()
 {
+    Watch_RemoveListener( m_nWatchHandle );
     Save();
 }
 
@@ -53,7 +65,6 @@ void CProjectManager::InitProjectConfig( const char *filepath ) const
 
 void CProjectManager::AddToCache( const std::string& path, bool loadJSON, bool buildPath )
 {
-    std::string filePath;
     json data;
     std::shared_ptr<Project> proj;
 
@@ -135,21 +146,406 @@ void CProjectManager::AddToCache( const std::string& path, bool loadJSON, bool b
         proj->m_AssetDirectory = va( "%s%cAssets", path.c_str(), PATH_SEP );
         proj->m_AssetPath = "Assets";
     }
-    try {
-        for ( const auto& mapIterator : std::filesystem::directory_iterator{ proj->m_AssetDirectory } ) {
-            filePath = mapIterator.path().string();
+    // the map list is built the first time it's needed, most cached projects are never opened
+    proj->m_bIndexBuilt = false;
+}
+
+/*
+===============================================================
+
+Project index cache: Config/mapindex.cache holds everything the
+project list knows about each map file, entries whose size and
+mtime still match skip the scan entirely on the next startup
+
+===============================================================
+*/
+
+#define PROJINDEX_IDENT (('X'<<24)+('D'<<16)+('I'<<8)+'P')
+#define PROJINDEX_VERSION 1
+
+static const char *ProjectIndexPath( const Project *proj ) {
+    return va( "%sConfig%cmapindex.cache", proj->m_FilePath.c_str(), PATH_SEP );
+}
+
+static void IndexWriteString( std::vector<byte>& out, const std::string& str )
+{
+    const uint16_t length = str.size() < UINT16_MAX ? str.size() : UINT16_MAX;
+
+    out.insert( out.end(), (const byte *)&length, (const byte *)&length + sizeof(length) );
+    out.insert( out.end(), str.begin(), str.begin() + length );
+}
+
+template<typename T>
+static void IndexWrite( std::vector<byte>& out, const T& value ) {
+    out.insert( out.end(), (const byte *)&value, (const byte *)&value + sizeof(value) );
+}
+
+static bool IndexReadString( const byte **p, const byte *end, std::string& str )
+{
+    uint16_t length;
+
+    if ( end - *p < (ptrdiff_t)sizeof(length) ) {
+        return false;
+    }
+    memcpy( &length, *p, sizeof(length) );
+    *p += sizeof(length);
+    if ( end - *p < length ) {
+        return false;
+    }
+    str.assign( (const char *)*p, length );
+    *p += length;
+    return true;
+}
+
+template<typename T>
+static bool IndexRead( const byte **p, const byte *end, T *value )
+{
+    if ( end - *p < (ptrdiff_t)sizeof(*value) ) {
+        return false;
+    }
+    memcpy( value, *p, sizeof(*value) );
+    *p += sizeof(*value);
+    return true;
+}
+
+/*
+* LoadProjectIndex: fills in the entries of proj->m_MapIndex whose file hasn't changed since the
+* cache was written, a missing, old or damaged cache just means everything gets scanned
+*/
+static void LoadProjectIndex( Project *proj )
+{
+    const char *path;
+    union {
+        void *v;
+        byte *b;
+    } f;
+    const byte *p, *end;
+    uint32_t ident, version, numEntries, matched;
+    uint64_t length;
+    projectMap_t entry;
+
+    proj->m_bIndexStale = true;
+
+    path = ProjectIndexPath( proj );
+    if ( !FileExists( path ) ) {
+        return;
+    }
+    length = LoadFile( path, &f.v );
+    if ( !f.v ) {
+        return;
+    }
+
+    p = f.b;
+    end = f.b + length;
+    if ( !IndexRead( &p, end, &ident ) || !IndexRead( &p, end, &version ) || !IndexRead( &p, end, &numEntries )
+        || ident != PROJINDEX_IDENT || version != PROJINDEX_VERSION )
+    {
+        Log_Printf( "Project index '%s' is out of date, rescanning every map.\n", path );
+        FreeMemory( f.v );
+        return;
+    }
+
+    matched = 0;
+    for ( uint32_t i = 0; i < numEntries; i++ ) {
+        if ( !IndexReadString( &p, end, entry.fileName ) || !IndexReadString( &p, end, entry.name )
+            || !IndexReadString( &p, end, entry.tilesetShader ) || !IndexReadString( &p, end, entry.diffuseMap )
+            || !IndexRead( &p, end, &entry.width ) || !IndexRead( &p, end, &entry.height )
+            || !IndexRead( &p, end, &entry.counts ) || !IndexRead( &p, end, &entry.fileSize )
+            || !IndexRead( &p, end, &entry.modifiedTime ) || !IndexRead( &p, end, &entry.hash ) )
+        {
+            Log_FPrintf( SYS_WRN, "WARNING: project index '%s' is truncated\n", path );
+            break;
+        }
+
+        // both lists are sorted by file name
+        const auto it = std::lower_bound( proj->m_MapIndex.begin(), proj->m_MapIndex.end(), entry.fileName,
+            []( const projectMap_t& a, const std::string& b ) { return a.fileName < b; } );
+        if ( it == proj->m_MapIndex.end() || it->fileName != entry.fileName || it->fileSize != entry.fileSize
+            || it->modifiedTime != entry.modifiedTime )
+        {
+            continue;
+        }
+        entry.scanned = true;
+        *it = entry;
+        matched++;
+    }
+    FreeMemory( f.v );
+
+    proj->m_bIndexStale = matched != numEntries || matched != proj->m_MapIndex.size();
+}
+
+/*
+* SaveProjectIndex: written next to the old one and renamed over it so a crash can't leave a
+* torn cache behind
+*/
+static void SaveProjectIndex( Project *proj )
+{
+    std::vector<byte> data;
+    std::string path, tmpPath;
+    FILE *fp;
+
+    IndexWrite( data, (uint32_t)PROJINDEX_IDENT );
+    IndexWrite( data, (uint32_t)PROJINDEX_VERSION );
+    IndexWrite( data, (uint32_t)proj->m_MapIndex.size() );
+    for ( const auto& it : proj->m_MapIndex ) {
+        IndexWriteString( data, it.fileName );
+        IndexWriteString( data, it.name );
+        IndexWriteString( data, it.tilesetShader );
+        IndexWriteString( data, it.diffuseMap );
+        IndexWrite( data, it.width );
+        IndexWrite( data, it.height );
+        IndexWrite( data, it.counts );
+        IndexWrite( data, it.fileSize );
+        IndexWrite( data, it.modifiedTime );
+        IndexWrite( data, it.hash );
+    }
+
+    path = ProjectIndexPath( proj );
+    tmpPath = path + ".tmp";
+
+    fp = fopen( tmpPath.c_str(), "wb" );
+    if ( !fp ) {
+        Log_FPrintf( SYS_WRN, "WARNING: failed to write project index '%s'\n", tmpPath.c_str() );
+        return;
+    }
+    SafeWrite( data.data(), data.size(), fp );
+    fclose( fp );
+
+    if ( rename( tmpPath.c_str(), path.c_str() ) == -1 ) {
+        Log_FPrintf( SYS_WRN, "WARNING: failed to replace project index '%s'\n", path.c_str() );
+        return;
+    }
+    proj->m_bIndexStale = false;
+}
+
+/*
+* ScanMapFile: hashes a map file and pulls what the project list shows out of its text, the map's
+* own keys, the tileset's shader and diffuse map and a count of each entity classname. Doesn't
+* touch the shared parser state so it can run on any thread.
+*/
+static void ScanMapFile( const char *path, projectMap_t *entry )
+{
+    union {
+        void *v;
+        char *b;
+    } f;
+    char token[MAX_NPATH];
+    char key[MAX_NPATH];
+    const char *p, *end;
+    uint64_t length, n;
+    int depth;
+    bool tilesetChunk;
+
+    length = LoadFile( path, &f.v );
+    if ( !f.v ) {
+        return;
+    }
+    entry->hash = Com_HashBuffer( f.v, length, 0 );
+
+    key[0] = '\0';
+    depth = 0;
+    tilesetChunk = false;
+    p = f.b;
+    end = f.b + length;
+    while ( p < end ) {
+        while ( p < end && isspace( (unsigned char)*p ) ) {
+            p++;
+        }
+        if ( p >= end ) {
+            break;
+        }
 
-            if ( mapIterator.is_regular_file() && ( !N_stricmp( COM_GetExtension( filePath.c_str() ), "map" )
-                || !N_stricmp( COM_GetExtension( filePath.c_str() ), "bmf") ) )
-            {
-                Map_LoadFile( filePath.c_str() );
-                if ( !m_bLoaded ) {
-                    proj->m_MapList.emplace_back( std::addressof( g_MapCache.back() ) );
+        n = 0;
+        if ( *p == '"' ) {
+            p++;
+            while ( p < end && *p != '"' ) {
+                if ( n < sizeof(token) - 1 ) {
+                    token[n++] = *p;
                 }
+                p++;
             }
+            if ( p < end ) {
+                p++;
+            }
+        } else {
+            while ( p < end && !isspace( (unsigned char)*p ) ) {
+                if ( n < sizeof(token) - 1 ) {
+                    token[n++] = *p;
+                }
+                p++;
+            }
+        }
+        token[n] = '\0';
+
+        if ( !token[1] && ( token[0] == '{' || token[0] == '}' ) ) {
+            depth += token[0] == '{' ? 1 : -1;
+            tilesetChunk = false;
+            key[0] = '\0';
+            continue;
+        }
+        // vectors like ambientColor and sides are always a key's value, the tokens inside don't matter
+        if ( !token[1] && token[0] == '(' ) {
+            while ( p < end && *p != ')' ) {
+                p++;
+            }
+            if ( p < end ) {
+                p++;
+            }
+            key[0] = '\0';
+            continue;
+        }
+
+        if ( !key[0] ) {
+            N_strncpyz( key, token, sizeof(key) );
+            continue;
+        }
+
+        if ( depth == 1 ) {
+            if ( !N_stricmp( key, "map_name" ) ) {
+                entry->name = token;
+            } else if ( !N_stricmp( key, "width" ) ) {
+                entry->width = atoi( token );
+            } else if ( !N_stricmp( key, "height" ) ) {
+                entry->height = atoi( token );
+            }
+        } else if ( !N_stricmp( key, "classname" ) ) {
+            if ( !N_stricmp( token, "tilesetdata" ) ) {
+                tilesetChunk = true;
+            } else if ( !N_stricmp( token, "map_checkpoint" ) ) {
+                entry->counts[PROJMAP_CHECKPOINTS]++;
+            } else if ( !N_stricmp( token, "map_spawn" ) ) {
+                entry->counts[PROJMAP_SPAWNS]++;
+            } else if ( !N_stricmp( token, "map_light" ) ) {
+                entry->counts[PROJMAP_LIGHTS]++;
+            } else if ( !N_stricmp( token, "map_secret" ) ) {
+                entry->counts[PROJMAP_SECRETS]++;
+            } else if ( !N_stricmp( token, "map_tile" ) ) {
+                entry->counts[PROJMAP_TILES]++;
+            }
+        } else if ( tilesetChunk ) {
+            if ( !N_stricmp( key, "shader" ) ) {
+                entry->tilesetShader = token;
+            } else if ( !N_stricmp( key, "diffuseMap" ) && strcmp( token, " " ) ) {
+                entry->diffuseMap = token;
+            }
+        }
+
+        // chunks keep going on the same line (pos x y z), only the first value is ever wanted
+        key[0] = '\0';
+        while ( p < end && *p != '\n' ) {
+            p++;
+        }
+    }
+    FreeMemory( f.v );
+
+    entry->scanned = true;
+}
+
+/*
+* BuildProjectIndex: lists the project's map files, takes what the index cache can vouch for and
+* scans the rest over the job system, then rewrites the cache if anything changed
+*/
+static void BuildProjectIndex( Project *proj )
+{
+    std::vector<projectMap_t *> pending;
+
+    if ( proj->m_bIndexBuilt ) {
+        return;
+    }
+    proj->m_bIndexBuilt = true;
+    proj->m_MapIndex.clear();
+
+    const std::filesystem::path mapDirectory = ( proj->m_AssetDirectory / "maps" ).lexically_normal();
+
+    // the asset index walks the whole tree, only the maps directory itself holds the project's maps
+    for ( const auto& it : Asset_GetFiles( proj->m_AssetDirectory, ASSET_MAP ) ) {
+        const std::filesystem::path mapPath = it.path;
+
+        if ( mapPath.parent_path() != mapDirectory ) {
+            continue;
+        }
+
+        projectMap_t& entry = proj->m_MapIndex.emplace_back();
+
+        entry.fileName = mapPath.filename().string();
+        entry.name = entry.fileName;
+        entry.width = 0;
+        entry.height = 0;
+        memset( entry.counts, 0, sizeof(entry.counts) );
+        entry.fileSize = it.fileSize;
+        entry.modifiedTime = it.modifiedTime;
+        entry.hash = 0;
+        entry.scanned = false;
+    }
+    std::sort( proj->m_MapIndex.begin(), proj->m_MapIndex.end(),
+        []( const projectMap_t& a, const projectMap_t& b ) { return a.fileName < b.fileName; } );
+
+    LoadProjectIndex( proj );
+
+    for ( auto& it : proj->m_MapIndex ) {
+        if ( !it.scanned ) {
+            pending.emplace_back( std::addressof( it ) );
+            proj->m_bIndexStale = true;
         }
-    } catch ( const std::filesystem::filesystem_error& e ) {
-        Log_FPrintf( SYS_WRN, "[CProjectManager::AddToCache] Filesystem exception occured, what: %s\n", e.what() );
+    }
+
+    Sys_ParallelFor( pending.size(), [&]( uint64_t i ) {
+        const std::filesystem::path path = proj->m_AssetDirectory / "maps" / pending[i]->fileName;
+        ScanMapFile( path.string().c_str(), pending[i] );
+    } );
+
+    if ( proj->m_bIndexStale && FolderExists( va( "%sConfig", proj->m_FilePath.c_str() ) ) ) {
+        SaveProjectIndex( proj );
+    }
+
+    Log_Printf( "[BuildProjectIndex] scanned %lu changed map files\n", pending.size() );
+}
+
+const std::vector<projectMap_t>& CProjectManager::GetMapIndex( void ) const
+{
+    BuildProjectIndex( m_CurrentProject.get() );
+    return m_CurrentProject->m_MapIndex;
+}
+
+/*
+* UpdateMapIndex: rescans one map file the editor just wrote, the asset index may not have
+* heard about it from the watcher yet so its size and mtime are read here
+*/
+void CProjectManager::UpdateMapIndex( const char *fileName )
+{
+    Project *proj;
+    std::error_code error;
+    std::vector<projectMap_t>::iterator it;
+
+    proj = m_CurrentProject.get();
+    if ( !proj || !proj->m_bIndexBuilt ) {
+        return;
+    }
+
+    const std::filesystem::path path = proj->m_AssetDirectory / "maps" / fileName;
+
+    it = std::lower_bound( proj->m_MapIndex.begin(), proj->m_MapIndex.end(), fileName,
+        []( const projectMap_t& a, const char *b ) { return a.fileName < b; } );
+    if ( it == proj->m_MapIndex.end() || it->fileName != fileName ) {
+        it = proj->m_MapIndex.insert( it, projectMap_t() );
+        it->fileName = fileName;
+    }
+
+    it->name = it->fileName;
+    it->tilesetShader.clear();
+    it->diffuseMap.clear();
+    it->width = 0;
+    it->height = 0;
+    memset( it->counts, 0, sizeof(it->counts) );
+    it->fileSize = std::filesystem::file_size( path, error );
+    it->modifiedTime = std::filesystem::last_write_time( path, error ).time_since_epoch().count();
+    it->hash = 0;
+    it->scanned = false;
+    ScanMapFile( path.string().c_str(), std::addressof( *it ) );
+
+    proj->m_bIndexStale = true;
+    if ( FolderExists( va( "%sConfig", proj->m_FilePath.c_str() ) ) ) {
+        SaveProjectIndex( proj );
     }
 }
 
@@ -189,6 +585,7 @@ void CProjectManager::New( void )
     }
     AddToCache( path );
     m_CurrentProject = m_ProjList.find( path )->second;
+    Watch_SetRoot( m_CurrentProject->m_AssetDirectory );
 
     InitProjectConfig( path );
 }
@@ -215,6 +612,14 @@ void CProjectManager::Save( void ) const
     for ( const auto& it : m_CurrentProject->m_MapList ) {
         data["maplist"].emplace_back( it->name );
     }
+    // maps that were never opened this session
+    for ( const auto& it : GetMapIndex() ) {
+        if ( std::find_if( m_CurrentProject->m_MapList.begin(), m_CurrentProject->m_MapList.end(),
+            [&it]( const mapData_t *map ) { return it.name == map->name; } ) == m_CurrentProject->m_MapList.end() )
+        {
+            data["maplist"].emplace_back( it.name );
+        }
+    }
 
     file.width( 4 );
     file << data;
@@ -266,7 +671,12 @@ void CProjectManager::SetCurrent( const std::string& name, bool buildPath )
     if ( !m_CurrentProject ) {
         m_CurrentProject = m_ProjList.find( ospath )->second;
     }
+    Watch_SetRoot( m_CurrentProject->m_AssetDirectory );
+
+    // only the first map is opened, the rest load when they're picked from the map list
     if ( m_CurrentProject->m_MapList.size() ) {
         Map_LoadFile( m_CurrentProject->m_MapList.front()->name );
+    } else if ( GetMapIndex().size() ) {
+        Map_LoadFile( GetMapIndex().front().fileName.c_str() );
     }
 }
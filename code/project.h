@@ -3,10 +3,42 @@
 
 #pragma once
 
+typedef enum {
+    PROJMAP_CHECKPOINTS,
+    PROJMAP_SPAWNS,
+    PROJMAP_LIGHTS,
+    PROJMAP_SECRETS,
+    PROJMAP_TILES,
+
+    NUM_PROJMAP_COUNTS
+} projectMapCount_t;
+
+/*
+* projectMap_t: what a project knows about one of its map files without loading it. It comes from
+* the project's index cache when the file's size and mtime still match, otherwise from a scan of
+* the file's text. The map itself is only parsed once it's opened.
+*/
+typedef struct {
+    std::string fileName; // inside the project's maps directory
+    std::string name; // map_name, the file name until the file has been scanned
+    std::string tilesetShader;
+    std::string diffuseMap;
+    int width;
+    int height;
+    uint32_t counts[NUM_PROJMAP_COUNTS]; // entities by type
+    uint64_t fileSize;
+    int64_t modifiedTime;
+    uint64_t hash;
+    bool scanned;
+} projectMap_t;
+
 struct Project
 {
     std::string m_Name;
-    std::vector<mapData_t *> m_MapList;
+    std::vector<mapData_t *> m_MapList; // maps that have been opened
+    std::vector<projectMap_t> m_MapIndex; // every map file in the project, opened or not
+    bool m_bIndexStale; // the index cache on disk doesn't match m_MapIndex
+    bool m_bIndexBuilt; // m_MapIndex has been listed and scanned
 
     std::vector<entityInfo_t> m_EntityList[NUMENTITYTYPES];
     std::unordered_map<std::string, int32_t> m_MobTypes;
@@ -26,6 +58,8 @@ public:
     const std::string& GetName( void ) const;
     const std::string& GetProjectDirectory( void ) const;
     const std::vector<mapData_t *>& GetMapList( void ) const;
+    const std::vector<projectMap_t>& GetMapIndex( void ) const;
+    void UpdateMapIndex( const char *fileName );
     const std::filesystem::path& GetAssetDirectory( void ) const;
     std::shared_ptr<Project>& GetProject( void );
 
@@ -45,6 +79,7 @@ private:
     void AddToCache( const std::string& path, bool loadJSON = false, bool buildPath = false );
 
     bool m_bLoaded;
+    int m_nWatchHandle;
 
     std::unordered_map<std::string, std::shared_ptr<Project>> m_ProjList;
     std::string m_ProjectsDirectory;
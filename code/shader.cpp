@@ -1,6 +1,7 @@
 #include "gln.h"
 #include "editor.h"
 #include "shader.h"
+#include <chrono>
 
 namespace Walnut {
 
@@ -1036,13 +1037,13 @@ static CShader *GeneratePermanentShader( void )
 			break;
 		}
 
-		newShader->stages[i] = (shaderStage_t *)GetMemory( sizeof(stages[i]) );
+		newShader->stages[i] = (shaderStage_t *)GetMemory( sizeof(stages[i]), TAG_RENDER );
 		*newShader->stages[i] = stages[i];
 
 		for ( uint32_t b = 0 ; b < NUM_TEXTURE_BUNDLES ; b++ ) {
 			size = newShader->stages[i]->bundle[b].numTexMods * sizeof( texModInfo_t );
 			if ( size ) {
-				newShader->stages[i]->bundle[b].texMods =  (texModInfo_t *)GetMemory( size );
+				newShader->stages[i]->bundle[b].texMods =  (texModInfo_t *)GetMemory( size, TAG_RENDER );
 				memcpy( newShader->stages[i]->bundle[b].texMods, stages[i].bundle[b].texMods, size );
 			}
 		}
@@ -1293,91 +1294,103 @@ CShader *R_FindShader( const char *name ) {
 	return GeneratePermanentShader();
 }
 
-#define	MAX_SHADER_FILES 16384
+typedef struct {
+	const char *path;
+	char *text;		// compressed, NULL if the file couldn't be loaded or has a broken shader
+	uint64_t length;
+	std::vector<std::pair<uint64_t, uint64_t>> names; // offset into text and hash of every shader the file defines
+} shaderFile_t;
 
-static int loadShaderBuffers( std::vector<std::string>& shaderFiles, const uint64_t numShaderFiles, char **buffers )
+/*
+* LoadShaderFile: loads, validates and compresses one shader file and notes where each of its
+* shaders starts. Runs on the job system, so it keeps to its own file and logs whole lines only.
+*/
+static void LoadShaderFile( shaderFile_t *file )
 {
-	std::string filename;
 	char shaderName[MAX_NPATH];
-	const char *p, *tok;
-	uint64_t summand, sum = 0;
+	const char *p, *oldp, *tok;
+	uint64_t length;
 	uint64_t shaderLine;
-	uint64_t i;
 	const char *shaderStart;
 	qboolean denyErrors;
 
-	// load and parse shader files
-	for ( i = 0; i < numShaderFiles; i++ ) {
-		filename = shaderFiles[i];
-		Log_Printf( "...loading '%s'\n", filename.c_str() );
-		summand = LoadFile( filename.c_str(), (void **)&buffers[i] );
+	length = LoadFile( file->path, (void **)&file->text );
 
-		if ( !buffers[i] || !summand ) {
-			Log_FPrintf( SYS_WRN, "Couldn't load %s.\n", filename.c_str() );
-			continue;
-		}
+	if ( !file->text ) {
+		Log_FPrintf( SYS_WRN, "Couldn't load %s.\n", file->path );
+		return;
+	}
+	if ( !length ) {
+		// an empty shader file has nothing to register
+		FreeMemory( file->text );
+		file->text = NULL;
+		return;
+	}
 
-		p = buffers[i];
-		COM_BeginParseSession( filename.c_str() );
-		
-		shaderStart = NULL;
-		denyErrors = qfalse;
-
-		while ( 1 ) {
-			tok = COM_ParseExt( &p, qtrue );
-			
-			if ( !*tok )
-				break;
-
-			N_strncpyz( shaderName, tok, sizeof(shaderName) );
-			shaderLine = COM_GetCurrentParseLine();
-
-			tok = COM_ParseExt( &p, qtrue );
-			if ( tok[0] != '{' || tok[1] != '\0' ) {
-				Log_Printf( "File %s: shader \"%s\" " \
-					"on line %lu missing opening brace", filename.c_str(), shaderName, shaderLine );
-				if ( tok[0] )
-					Log_Printf( " (found \"%s\" on line %lu)\n", tok, COM_GetCurrentParseLine() );
-				else
-					Log_Printf( "\n" );
+	p = file->text;
+	COM_BeginParseSession( file->path );
 
-				if ( denyErrors || !p )
-				{
-					Log_Printf( "Ignoring entire file '%s' due to error.\n", filename.c_str() );
-					FreeMemory( buffers[i] );
-					buffers[i] = NULL;
-					break;
-				}
+	shaderStart = NULL;
+	denyErrors = qfalse;
 
-				SkipRestOfLine( &p );
-				shaderStart = p;
-				continue;
-			}
+	while ( 1 ) {
+		tok = COM_ParseExt( &p, qtrue );
+
+		if ( !*tok )
+			break;
 
-			if ( !SkipBracedSection( &p, 1 ) ) {
-				Log_Printf( "WARNING: Ignoring shader file %s. Shader \"%s\" " \
-					"on line %lu missing closing brace.\n", filename.c_str(), shaderName, shaderLine );
-				FreeMemory( buffers[i] );
-				buffers[i] = NULL;
-				break;
+		N_strncpyz( shaderName, tok, sizeof(shaderName) );
+		shaderLine = COM_GetCurrentParseLine();
+
+		tok = COM_ParseExt( &p, qtrue );
+		if ( tok[0] != '{' || tok[1] != '\0' ) {
+			if ( tok[0] )
+				Log_Printf( "File %s: shader \"%s\" on line %lu missing opening brace (found \"%s\" on line %lu)\n",
+					file->path, shaderName, shaderLine, tok, COM_GetCurrentParseLine() );
+			else
+				Log_Printf( "File %s: shader \"%s\" on line %lu missing opening brace\n", file->path, shaderName, shaderLine );
+
+			if ( denyErrors || !p )
+			{
+				Log_Printf( "Ignoring entire file '%s' due to error.\n", file->path );
+				FreeMemory( file->text );
+				file->text = NULL;
+				return;
 			}
 
-			denyErrors = qtrue;
+			SkipRestOfLine( &p );
+			shaderStart = p;
+			continue;
 		}
 
-		if ( buffers[ i ] ) {
-			if ( shaderStart ) {
-				summand -= (shaderStart - buffers[i]);
-				if ( summand >= 0 ) {
-					memmove( buffers[i], shaderStart, summand + 1 );
-				}
-			}
-			//sum += summand;
-			sum += COM_Compress( buffers[ i ] );
+		if ( !SkipBracedSection( &p, 1 ) ) {
+			Log_Printf( "WARNING: Ignoring shader file %s. Shader \"%s\" " \
+				"on line %lu missing closing brace.\n", file->path, shaderName, shaderLine );
+			FreeMemory( file->text );
+			file->text = NULL;
+			return;
 		}
+
+		denyErrors = qtrue;
+	}
+
+	if ( shaderStart ) {
+		length -= ( shaderStart - file->text );
+		memmove( file->text, shaderStart, length + 1 );
 	}
+	file->length = COM_Compress( file->text );
 
-	return sum;
+	// look for shader names
+	p = file->text;
+	while ( 1 ) {
+		oldp = p;
+		tok = COM_ParseExt( &p, qtrue );
+		if ( tok[0] == 0 ) {
+			break;
+		}
+		file->names.emplace_back( oldp - file->text, Com_GenerateHashValue( tok, MAX_SHADERTEXT_HASH ) );
+		SkipBracedSection( &p, 0 );
+	}
 }
 
 
@@ -1386,15 +1399,8 @@ static char *hashMem = NULL;
 
 static void LoadShaderFiles( std::vector<std::string>& shaderFiles, const std::filesystem::path& currentDir )
 {
-	for ( const auto& it : std::filesystem::directory_iterator{ currentDir } ) {
-		std::string path = std::move( it.path().string() );
-
-        if ( it.is_directory() ) {
-			LoadShaderFiles( shaderFiles, it );
-		}
-		else if ( !N_stricmp( COM_GetExtension( path.c_str() ), "shader" ) ) {
-            shaderFiles.emplace_back( path );
-        }
+	for ( const auto& it : Asset_GetFiles( currentDir, ASSET_SHADER ) ) {
+		shaderFiles.emplace_back( it.path );
 	}
 }
 
@@ -1403,26 +1409,24 @@ static void LoadShaderFiles( std::vector<std::string>& shaderFiles, const std::f
 ScanAndLoadShaderFiles
 
 Finds and loads all .shader files, combining them into
-a single large text block that can be scanned for shader names
+a single large text block that can be scanned for shader names.
+Every file is loaded, checked and indexed on its own job, only
+the final merge into the text block and hash table is serial.
 =====================
 */
 static void ScanAndLoadShaderFiles( void )
 {
-    std::vector<std::string> shaderFiles;
-	char *buffers[MAX_SHADER_FILES];
+	std::vector<std::string> shaderFiles;
+	std::vector<shaderFile_t> files;
+	std::vector<uint64_t> offsets;
 	uint64_t numShaderFiles;
 	int64_t i;
-	const char *tok;
-	char *textEnd;
-	const char *p, *oldp;
-	uint64_t shaderTextHashTableSizes[MAX_SHADERTEXT_HASH], hash, size;
-
-	memset(buffers, 0, sizeof(buffers));
-	memset(shaderTextHashTableSizes, 0, sizeof(shaderTextHashTableSizes));
+	const char **hashCursor;
+	uint64_t shaderTextHashTableSizes[MAX_SHADERTEXT_HASH], size, sum;
 
-    uint64_t sum = 0;
+	const auto start = std::chrono::steady_clock::now();
 
-	LoadShaderFiles( shaderFiles, g_pProjectManager->GetProjectDirectory() );
+	LoadShaderFiles( shaderFiles, g_pProjectManager->GetAssetDirectory() );
 
 	numShaderFiles = shaderFiles.size();
 
@@ -1433,72 +1437,69 @@ static void ScanAndLoadShaderFiles( void )
 		return;
 	}
 
-	if ( numShaderFiles > MAX_SHADER_FILES ) {
-		numShaderFiles = MAX_SHADER_FILES;
+	files.resize( numShaderFiles );
+	for ( i = 0; i < (int64_t)numShaderFiles; i++ ) {
+		files[i].path = shaderFiles[i].c_str();
+		files[i].text = NULL;
+		files[i].length = 0;
 	}
 
+	Sys_ParallelFor( numShaderFiles, [&]( uint64_t index ) { LoadShaderFile( &files[index] ); } );
+
+	// the files go into the text back to front
+	offsets.resize( numShaderFiles );
 	sum = 0;
-	sum += loadShaderBuffers( shaderFiles, numShaderFiles, buffers );
+	for ( i = numShaderFiles - 1; i >= 0; i-- ) {
+		if ( files[i].text ) {
+			offsets[i] = sum;
+			sum += files[i].length + 1;
+		}
+	}
 
 	// build single large buffer
-	r_shaderText = (char *)GetMemory( sum + numShaderFiles*2 + 1 );
-	memset( r_shaderText, 0, sum + numShaderFiles*2 );
+	r_shaderText = (char *)GetMemory( sum + 1, TAG_RENDER );
 
-	textEnd = r_shaderText;
-
-	// free in reverse order, so the temp files are all dumped
-	for ( i = numShaderFiles - 1; i >= 0 ; i-- ) {
-		if ( buffers[ i ] ) {
-			textEnd = N_stradd( textEnd, buffers[ i ] );
-			textEnd = N_stradd( textEnd, "\n" );
-			FreeMemory( buffers[ i ] );
+	Sys_ParallelFor( numShaderFiles, [&]( uint64_t index ) {
+		if ( files[index].text ) {
+			memcpy( r_shaderText + offsets[index], files[index].text, files[index].length );
+			r_shaderText[ offsets[index] + files[index].length ] = '\n';
+			FreeMemory( files[index].text );
 		}
-	}
+	} );
 
 	// if shader text >= r_extensionOffset then it is an extended shader
 	// normal shaders will never encounter that
-	r_extensionOffset = textEnd;
+	r_extensionOffset = r_shaderText + sum;
 
-	COM_Compress( r_shaderText );
 	memset( shaderTextHashTableSizes, 0, sizeof( shaderTextHashTableSizes ) );
 	size = 0;
 
-	p = r_shaderText;
-	// look for shader names
-	while ( 1 ) {
-		tok = COM_ParseExt( &p, qtrue );
-		if ( tok[0] == 0 ) {
-			break;
+	for ( const auto& file : files ) {
+		for ( const auto& name : file.names ) {
+			shaderTextHashTableSizes[ name.second ]++;
+			size++;
 		}
-		hash = Com_GenerateHashValue(tok, MAX_SHADERTEXT_HASH);
-		shaderTextHashTableSizes[hash]++;
-		size++;
-		SkipBracedSection(&p, 0);
 	}
 
 	size += MAX_SHADERTEXT_HASH;
 
-	hashMem = (char *)GetMemory( size * sizeof(char *) );
+	hashMem = (char *)GetMemory( size * sizeof(char *), TAG_RENDER );
 
+	hashCursor = (const char **)hashMem;
 	for (i = 0; i < MAX_SHADERTEXT_HASH; i++) {
-		shaderTextHashTable[i] = (const char **) hashMem;
-		hashMem = ((char *) hashMem) + ((shaderTextHashTableSizes[i] + 1) * sizeof(char *));
+		shaderTextHashTable[i] = hashCursor;
+		hashCursor += shaderTextHashTableSizes[i] + 1;
 	}
 
-	p = r_shaderText;
-	// look for shader names
-	while ( 1 ) {
-		oldp = p;
-		tok = COM_ParseExt( &p, qtrue );
-		if ( tok[0] == 0 ) {
-			break;
+	// same order as walking the text from the start, so lookups resolve duplicates as they always have
+	for ( i = numShaderFiles - 1; i >= 0; i-- ) {
+		for ( const auto& name : files[i].names ) {
+			shaderTextHashTable[ name.second ][ --shaderTextHashTableSizes[ name.second ] ] = r_shaderText + offsets[i] + name.first;
 		}
-
-		hash = Com_GenerateHashValue(tok, MAX_SHADERTEXT_HASH);
-		shaderTextHashTable[hash][--shaderTextHashTableSizes[hash]] = (char*)oldp;
-
-		SkipBracedSection(&p, 0);
 	}
+
+	Log_Printf( "Indexed %lu shaders in %.1lf ms.\n", size - MAX_SHADERTEXT_HASH,
+		std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count() );
 }
 
 
@@ -1526,28 +1527,33 @@ InitShaders
 */
 void InitShaders( void )
 {
-	return;
 	Log_Printf( "Initializing Shaders\n" );
 
-	for ( uint64_t i = 0; i > numShaders; i++ ) {
-		if ( hashTable[i] ) {
-			delete hashTable[i];
-		}
-	}
-
 	if ( r_shaderText ) {
-		FreeMemory( r_shaderText );
+		FreeMemory( r_shaderText, TAG_RENDER );
+		r_shaderText = NULL;
 	}
 
 	if ( hashMem ) {
-		FreeMemory( hashMem );
+		FreeMemory( hashMem, TAG_RENDER );
+		hashMem = NULL;
+	}
+	memset( shaderTextHashTable, 0, sizeof(shaderTextHashTable) );
+
+	ScanAndLoadShaderFiles();
+
+	// nothing draws with the parsed shaders yet, only the text index is built
+	return;
+
+	for ( uint64_t i = 0; i > numShaders; i++ ) {
+		if ( hashTable[i] ) {
+			delete hashTable[i];
+		}
 	}
 
     memset( hashTable, 0, sizeof(hashTable) );
 
 	CreateInternalShaders();
-
-	ScanAndLoadShaderFiles();
 }
 
 CShader::CShader( void )
@@ -1563,10 +1569,10 @@ CShader::~CShader()
         }
 
         if ( stages[i]->bundle[0].texMods ) {
-            FreeMemory( stages[i]->bundle[0].texMods );
+            FreeMemory( stages[i]->bundle[0].texMods, TAG_RENDER );
         }
 
-        FreeMemory( stages[i] );
+        FreeMemory( stages[i], TAG_RENDER );
     }
 }
 
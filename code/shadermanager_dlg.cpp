@@ -9,32 +9,22 @@ CAssetManagerDlg::~CAssetManagerDlg()
 {
 }
 
+/*
+* FindShaderFiles, FindTextureFiles: both come out of the shared asset index rather than walking the
+* tree, the texture list only keeps file names
+*/
 static void FindShaderFiles( const std::filesystem::path& currentPath, std::vector<std::filesystem::path>& shaderList )
 {
-	for ( const auto& it : std::filesystem::directory_iterator{ currentPath } ) {
-		if ( it.is_directory() ) {
-			FindShaderFiles( it, shaderList );
-		} else if ( !N_stricmp( COM_GetExtension( it.path().string().c_str() ), "shader" ) && !it.is_directory() ) {
-			shaderList.emplace_back( it.path().string().c_str() );
-			Log_Printf( "added shader file '%s' to cache\n", it.path().string().c_str() );
-		}
+	for ( const auto& it : Asset_GetFiles( currentPath, ASSET_SHADER ) ) {
+		shaderList.emplace_back( it.path );
 	}
+	Log_Printf( "found %lu shader files\n", shaderList.size() );
 }
 
 static void FindTextureFiles( const std::filesystem::path& currentPath, std::vector<std::filesystem::path>& textureList )
 {
-	for ( const auto& it : std::filesystem::directory_iterator{ currentPath } ) {
-		if ( it.is_directory() ) {
-			FindTextureFiles( it, textureList );
-		} else {
-			const std::string path = it.path().filename().string();
-			const char *ext = COM_GetExtension( path.c_str() );
-			if ( !N_stricmp( ext, "png" ) || !N_stricmp( ext, "jpeg" ) || !N_stricmp( ext, "jpg" ) || !N_stricmp( ext, "bmp" )
-				|| !N_stricmp( ext, "tga" ) )
-			{
-				textureList.emplace_back( path );
-			}
-		}
+	for ( const auto& it : Asset_GetFiles( currentPath, ASSET_TEXTURE ) ) {
+		textureList.emplace_back( std::filesystem::path( it.path ).filename() );
 	}
 }
 
@@ -48,10 +38,50 @@ void CAssetManagerDlg::OnAttach( void )
 
 	FindShaderFiles( m_BaseDirectory, m_ShaderList );
 	FindTextureFiles( m_BaseDirectory, m_TextureList );
+
+	m_nWatchHandle = Watch_AddListener( [this]( const watchEvent_t& event ) { OnFileChanged( event ); } );
+}
+
+/*
+* OnFileChanged: keeps the shader and texture lists, the shader text and the texture cache in step
+* with what the file watcher reports, the asset index has already seen the event by now
+*/
+void CAssetManagerDlg::OnFileChanged( const watchEvent_t& event )
+{
+	const assetType_t type = Asset_Classify( event.path.c_str() );
+
+	if ( ( event.flags & WATCH_RESCAN ) || event.isDirectory ) {
+		// a whole directory came or went, or events were lost
+		m_ShaderList.clear();
+		m_TextureList.clear();
+		FindShaderFiles( m_BaseDirectory, m_ShaderList );
+		FindTextureFiles( m_BaseDirectory, m_TextureList );
+		Walnut::InitShaders();
+		return;
+	}
+
+	if ( type == ASSET_SHADER ) {
+		if ( event.flags & ( WATCH_CREATED | WATCH_REMOVED ) ) {
+			m_ShaderList.clear();
+			FindShaderFiles( m_BaseDirectory, m_ShaderList );
+		}
+		Log_Printf( "Shader file '%s' changed on disk, reloading shaders...\n", event.path.c_str() );
+		Walnut::InitShaders();
+	} else if ( type == ASSET_TEXTURE ) {
+		if ( event.flags & ( WATCH_CREATED | WATCH_REMOVED ) ) {
+			m_TextureList.clear();
+			FindTextureFiles( m_BaseDirectory, m_TextureList );
+		}
+		if ( event.flags & ( WATCH_CREATED | WATCH_MODIFIED ) ) {
+			Tex_Reload( event.path.c_str() );
+		}
+	}
 }
 
 void CAssetManagerDlg::OnDetach( void )
 {
+	Watch_RemoveListener( m_nWatchHandle );
+
 	delete m_pDirectoryIcon;
 	delete m_pFileIcon;
 }
@@ -137,6 +167,7 @@ void CAssetManagerDlg::OnUIRender( void )
 		if ( ImGui::Button( "Reload Shader List") ) {
 			m_ShaderList.clear();
 			Log_Printf( "[CAssetManagerDlg::OnUIRender] Reloading shader file list...\n" );
+			Asset_Rescan( m_BaseDirectory );
 			FindShaderFiles( m_BaseDirectory, m_ShaderList );
 		}
 		if ( ImGui::TreeNodeEx( (void *)(uintptr_t)"NewShader", treeNodeFlags, "New Shader" ) ) {
@@ -199,6 +230,26 @@ void CAssetManagerDlg::OnUIRender( void )
 			}
 		}
 
+		if ( ImGui::TreeNodeEx( (void *)(uintptr_t)"LoadedTextures", ImGuiTreeNodeFlags_SpanAvailWidth | ImGuiTreeNodeFlags_FramePadding,
+			"Loaded Textures" ) )
+		{
+			texCacheStats_t stats;
+
+			Tex_GetCacheStats( &stats );
+			ImGui::Text( "%u textures, %.2f MiB resident", stats.numTextures, (double)stats.residentBytes / ( 1024.0 * 1024.0 ) );
+
+			Tex_ForEach( []( const CTexture *texture ) {
+				const char *name = texture->GetName().c_str();
+
+				ImGui::MenuItem( strrchr( name, PATH_SEP ) ? strrchr( name, PATH_SEP ) + 1 : name );
+				if ( ImGui::IsItemHovered() ) {
+					ImGui::SetTooltip( "%s\n%ix%i, %i references%s", name, texture->GetWidth(), texture->GetHeight(), texture->GetRefCount(),
+						texture->IsReady() ? "" : ", loading" );
+				}
+			} );
+			ImGui::TreePop();
+		}
+
 		if ( ImGui::Button( "Add Texture File" ) ) {
 			ImGuiFileDialog::Instance()->OpenDialog( "AddTextureFileDlg", "Open Texture File",
 				".jpg,.jpeg,.png,.bmp,.tga,.webp,"
@@ -18,6 +18,8 @@ public:
     void AddShaderFile( const std::string& shaderFile );
     void AddTextureFile( const std::string& textureFile );
 private:
+    void OnFileChanged( const watchEvent_t& event );
+
     std::vector<std::filesystem::path> m_ShaderList;
     std::vector<std::filesystem::path> m_TextureList;
 
@@ -27,6 +29,8 @@ private:
     Walnut::Image *m_pDirectoryIcon;
     Walnut::Image *m_pFileIcon;
 
+    int m_nWatchHandle;
+
     char m_szNewShaderName[MAX_NPATH];
     std::string m_newShaderPath;
 };
@@ -0,0 +1,94 @@
+#ifndef __SLOTMAP__
+#define __SLOTMAP__
+
+#pragma once
+
+/*
+* slotMap_t: bookkeeping for one of a map's fixed entity arrays. An entity keeps the slot it was
+* created in until the map is packed for saving or compiling, so removing one never moves the
+* others and pointers into the array stay put. New entities go on the end while there's room so
+* their order matches creation order, freed slots are only reused once the array is full.
+*
+* entityHandle_t is the slot in the low 16 bits and the slot's generation in the high 16, a
+* handle to a removed entity stops resolving even if its slot gets reused. 0 is never valid.
+*/
+typedef uint32_t entityHandle_t;
+
+#define ENTITY_HANDLE_NONE 0
+
+template<uint32_t N>
+struct slotMap_t {
+    uint16_t generation[N];
+    uint16_t freeList[N];
+    bool used[N];
+    uint32_t numFree;
+    uint32_t numSlots; // high water mark of slots handed out, holes included, only Slot_Clear resets it
+    uint32_t numUsed;
+};
+
+template<uint32_t N>
+inline void Slot_Clear( slotMap_t<N> *map ) {
+    memset( map, 0, sizeof(*map) );
+}
+
+/*
+* Slot_Alloc: returns the new entity's slot, or -1 if every slot is taken
+*/
+template<uint32_t N>
+inline int Slot_Alloc( slotMap_t<N> *map )
+{
+    uint32_t slot;
+
+    if ( map->numSlots < N ) {
+        slot = map->numSlots++;
+    } else if ( map->numFree ) {
+        slot = map->freeList[ --map->numFree ];
+    } else {
+        return -1;
+    }
+
+    if ( ++map->generation[slot] == 0 ) {
+        map->generation[slot] = 1;
+    }
+    map->used[slot] = true;
+    map->numUsed++;
+
+    return (int)slot;
+}
+
+template<uint32_t N>
+inline void Slot_Free( slotMap_t<N> *map, uint32_t slot )
+{
+    if ( slot >= map->numSlots || !map->used[slot] ) {
+        return;
+    }
+    map->used[slot] = false;
+    map->freeList[ map->numFree++ ] = slot;
+    map->numUsed--;
+}
+
+template<uint32_t N>
+inline bool Slot_Used( const slotMap_t<N> *map, uint32_t slot ) {
+    return slot < map->numSlots && map->used[slot];
+}
+
+template<uint32_t N>
+inline entityHandle_t Slot_Handle( const slotMap_t<N> *map, uint32_t slot ) {
+    return Slot_Used( map, slot ) ? ( (uint32_t)map->generation[slot] << 16 ) | slot : ENTITY_HANDLE_NONE;
+}
+
+/*
+* Slot_Resolve: returns the slot a handle refers to, or -1 if the entity is gone
+*/
+template<uint32_t N>
+inline int Slot_Resolve( const slotMap_t<N> *map, entityHandle_t handle )
+{
+    const uint32_t slot = handle & 0xffff;
+
+    if ( handle == ENTITY_HANDLE_NONE || !Slot_Used( map, slot ) || map->generation[slot] != ( handle >> 16 ) ) {
+        return -1;
+    }
+    return (int)slot;
+}
+
+#endif
@@ -30,7 +30,7 @@ MemStream::MemStream( uint64_t nLen )
 	m_pBuffer = NULL;
 	m_bAutoDelete = true;
 
-	GrowFile( nLen );
+	Reserve( nLen );
 }
 
 FileStream::FileStream( void )
@@ -283,28 +283,45 @@ uint64_t FileStream::GetPosition( void ) const
 	return ftell( m_hFile );
 }
 
+/*
+* GrowFile: the buffer at least doubles each time so writing n bytes a piece at a time costs O(n)
+* copying overall, m_nGrowBytes is just the smallest step
+*/
 void MemStream::GrowFile( uint64_t nNewLen )
 {
 	if ( nNewLen > m_nBufferSize ) {
 		// grow the buffer
-		uint64_t nNewBufferSize = m_nBufferSize;
+		uint64_t nNewBufferSize = m_nBufferSize * 2;
 
 		// determine new buffer size
-		while ( nNewBufferSize < nNewLen )
-			nNewBufferSize += m_nGrowBytes;
-
-		// allocate new buffer
-		byte* lpNew;
-		if ( m_pBuffer == NULL ) {
-			lpNew = static_cast<byte*>( GetMemory( nNewBufferSize ) );
+		if ( nNewBufferSize < m_nBufferSize + m_nGrowBytes ) {
+			nNewBufferSize = m_nBufferSize + m_nGrowBytes;
 		}
-		else {
-			lpNew = static_cast<byte*>( GetResizedMemory( m_pBuffer, nNewBufferSize ) );
+		if ( nNewBufferSize < nNewLen ) {
+			nNewBufferSize = nNewLen;
 		}
 
-		m_pBuffer = lpNew;
-		m_nBufferSize = nNewBufferSize;
+		Reserve( nNewBufferSize );
+	}
+}
+
+/*
+* Reserve: sizes the buffer for nBytes up front when the caller knows roughly how much is coming,
+* doesn't change the stream's length
+*/
+void MemStream::Reserve( uint64_t nBytes )
+{
+	if ( nBytes <= m_nBufferSize ) {
+		return;
+	}
+
+	if ( m_pBuffer == NULL ) {
+		m_pBuffer = static_cast<byte*>( GetMemory( nBytes ) );
+	}
+	else {
+		m_pBuffer = static_cast<byte*>( GetResizedMemory( m_pBuffer, nBytes ) );
 	}
+	m_nBufferSize = nBytes;
 }
 
 void MemStream::Flush(void)
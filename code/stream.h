@@ -33,6 +33,8 @@ protected:
     bool m_bAutoDelete;
     void GrowFile( uint64_t nNewLen );
 public:
+    void Reserve( uint64_t nBytes );
+
     virtual uint64_t GetPosition( void ) const override;
     virtual uint64_t Seek( uint64_t lOff, int nFrom ) override;
     virtual void SetLength( uint64_t nNewLen ) override;
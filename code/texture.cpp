@@ -0,0 +1,459 @@
+#include "editor.h"
+#include "glad/gl.h"
+#include "stb_image.h"
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+#include <filesystem>
+
+/*
+===============================================================
+
+Texture cache and loading: one texture per file and sampler,
+shared by every map that uses it. stbi_load runs on a worker,
+the main thread streams the decoded pixels into GL through a
+pixel unpack buffer and stops once it has used up its share of
+the frame. Textures nobody references stay resident until the
+cache goes over its VRAM budget.
+
+===============================================================
+*/
+
+#define TEX_UPLOAD_MSEC 4.0 // main thread time spent uploading per frame
+#define TEX_UPLOAD_STRIP ( 1024 * 1024 ) // bytes per glTexSubImage2D
+
+typedef enum {
+    TEXLOAD_DECODING,
+    TEXLOAD_DECODED,
+    TEXLOAD_FAILED
+} texLoadState_t;
+
+typedef struct texLoad_s {
+    CTexture *texture; // NULL once the texture was deleted, the load is dropped when the worker is done with it
+    std::string path;
+    byte *pixels;
+    int width;
+    int height;
+    int uploadedRows;
+    std::atomic<int> state;
+} texLoad_t;
+
+static std::mutex s_TextureLock; // guards the cache and the load list
+static std::unordered_map<std::string, CTexture *> s_TextureCache;
+static std::vector<texLoad_t *> s_Loads;
+static jobGroup_t s_LoadGroup;
+static uint64_t s_nUseCounter;
+static uint64_t s_nCacheHits, s_nCacheMisses, s_nCacheEvictions;
+
+static GLuint s_nPlaceholder;
+static GLuint s_nUploadBuffer;
+
+CTexture::CTexture( const char *path, int width, int height, texSampler_t sampler )
+    : m_Name( path ), m_nID( 0 ), m_nWidth( width ), m_nHeight( height ), m_nSampler( sampler ), m_bReady( false ),
+    m_nRefs( 0 ), m_nLastUsed( 0 ), m_pLoad( NULL )
+{
+}
+
+/*
+* only ever called with s_TextureLock held
+*/
+CTexture::~CTexture()
+{
+    if ( m_pLoad ) {
+        m_pLoad->texture = NULL;
+    }
+    if ( m_nID ) {
+        glDeleteTextures( 1, &m_nID );
+    }
+}
+
+uint32_t CTexture::GetID( void ) const {
+    return m_bReady ? m_nID : s_nPlaceholder;
+}
+
+static std::string Tex_CacheKey( const char *path, texSampler_t sampler )
+{
+    std::error_code error;
+    std::filesystem::path canonical;
+
+    // the same file reached through a different relative path or a symlink is still the same texture
+    canonical = std::filesystem::weakly_canonical( path, error );
+    if ( error ) {
+        canonical = path;
+    }
+    return canonical.string() + "|" + std::to_string( (int)sampler );
+}
+
+/*
+* Tex_StartLoad: queues the decode of texture's file, only ever called with s_TextureLock held
+*/
+void Tex_StartLoad( CTexture *texture )
+{
+    texLoad_t *load;
+
+    load = new texLoad_t;
+    load->texture = texture;
+    load->path = texture->m_Name;
+    load->pixels = NULL;
+    load->width = texture->m_nWidth;
+    load->height = texture->m_nHeight;
+    load->uploadedRows = 0;
+    load->state = TEXLOAD_DECODING;
+    texture->m_pLoad = load;
+    s_Loads.emplace_back( load );
+
+    Job_Add( &s_LoadGroup, JOB_PRIORITY_INTERACTIVE, [load]( void ) {
+        int width, height, channels;
+
+        load->pixels = stbi_load( load->path.c_str(), &width, &height, &channels, STBI_rgb_alpha );
+        if ( load->pixels && ( width != load->width || height != load->height ) ) {
+            // changed on disk between the header read and now
+            stbi_image_free( load->pixels );
+            load->pixels = NULL;
+        }
+        load->state.store( load->pixels ? TEXLOAD_DECODED : TEXLOAD_FAILED, std::memory_order_release );
+    } );
+}
+
+/*
+* Tex_Load: returns the cached texture for path and sampler with a new reference, loading it if it
+* isn't cached. A new texture shows the placeholder until it has been uploaded. Returns NULL if path
+* isn't an image stb_image can read. Can be called from any thread.
+*/
+CTexture *Tex_Load( const char *path, texSampler_t sampler )
+{
+    CTexture *texture;
+    int width, height, channels;
+    const std::string key = Tex_CacheKey( path, sampler );
+
+    {
+        std::lock_guard<std::mutex> lock{ s_TextureLock };
+        const auto it = s_TextureCache.find( key );
+        if ( it != s_TextureCache.end() ) {
+            it->second->m_nRefs++;
+            s_nCacheHits++;
+            return it->second;
+        }
+    }
+
+    if ( !stbi_info( path, &width, &height, &channels ) ) {
+        Log_FPrintf( SYS_WRN, "WARNING: failed to load texture '%s', %s\n", path, stbi_failure_reason() );
+        return NULL;
+    }
+
+    std::lock_guard<std::mutex> lock{ s_TextureLock };
+
+    // someone else may have started it while the header was being read
+    const auto it = s_TextureCache.find( key );
+    if ( it != s_TextureCache.end() ) {
+        it->second->m_nRefs++;
+        s_nCacheHits++;
+        return it->second;
+    }
+    s_nCacheMisses++;
+
+    texture = new CTexture( path, width, height, sampler );
+    texture->m_nRefs = 1;
+    s_TextureCache.try_emplace( key, texture );
+    Tex_StartLoad( texture );
+
+    return texture;
+}
+
+/*
+* Tex_Reload: decodes a file that changed on disk again for every cached texture made from it, they
+* keep showing the old pixels until the new ones are uploaded. If the size changed the texture goes
+* back to the placeholder in the meantime. Main thread only.
+*/
+void Tex_Reload( const char *path )
+{
+    int width, height, channels;
+
+    std::lock_guard<std::mutex> lock{ s_TextureLock };
+
+    for ( int sampler = 0; sampler < NUM_TEX_SAMPLERS; sampler++ ) {
+        const auto it = s_TextureCache.find( Tex_CacheKey( path, (texSampler_t)sampler ) );
+        if ( it == s_TextureCache.end() ) {
+            continue;
+        }
+        CTexture *texture = it->second;
+
+        if ( !stbi_info( texture->m_Name.c_str(), &width, &height, &channels ) ) {
+            Log_FPrintf( SYS_WRN, "WARNING: failed to reload texture '%s', %s\n", texture->m_Name.c_str(), stbi_failure_reason() );
+            continue;
+        }
+        Log_Printf( "Reloading texture '%s'\n", texture->m_Name.c_str() );
+
+        if ( texture->m_pLoad ) {
+            // the decode in flight read the old file, it's thrown away when it finishes
+            texture->m_pLoad->texture = NULL;
+            texture->m_pLoad = NULL;
+        }
+        if ( width != texture->m_nWidth || height != texture->m_nHeight ) {
+            Log_FPrintf( SYS_WRN, "WARNING: texture '%s' changed size from %ix%i to %ix%i\n", texture->m_Name.c_str(),
+                texture->m_nWidth, texture->m_nHeight, width, height );
+            if ( texture->m_nID ) {
+                glDeleteTextures( 1, &texture->m_nID );
+                texture->m_nID = 0;
+            }
+            texture->m_nWidth = width;
+            texture->m_nHeight = height;
+            texture->m_bReady = false;
+        }
+        Tex_StartLoad( texture );
+    }
+}
+
+/*
+* Tex_Release: drops a reference from Tex_Load, NULL is fine. The texture stays cached for the next
+* map that wants it until the cache needs the room. Main thread only, it may evict.
+*/
+void Tex_Release( CTexture *texture )
+{
+    if ( !texture ) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{ s_TextureLock };
+        if ( --texture->m_nRefs > 0 ) {
+            return;
+        }
+        texture->m_nLastUsed = ++s_nUseCounter;
+    }
+    Tex_TrimCache();
+}
+
+/*
+* Tex_TrimCache: evicts unreferenced textures, least recently released first, until the resident
+* ones fit in the budget from the preferences. Textures still in use are never evicted, the cache
+* can stay over budget if they alone don't fit.
+*/
+void Tex_TrimCache( void )
+{
+    std::lock_guard<std::mutex> lock{ s_TextureLock };
+    uint64_t resident, budget;
+
+    budget = (uint64_t)g_pPrefsDlg->m_nTextureCacheBudget * 1024 * 1024;
+    resident = 0;
+    for ( const auto& it : s_TextureCache ) {
+        resident += it.second->GetMemorySize();
+    }
+
+    while ( resident > budget ) {
+        auto oldest = s_TextureCache.end();
+
+        for ( auto it = s_TextureCache.begin(); it != s_TextureCache.end(); ++it ) {
+            if ( it->second->m_nRefs > 0 || !it->second->GetMemorySize() ) {
+                continue;
+            }
+            if ( oldest == s_TextureCache.end() || it->second->m_nLastUsed < oldest->second->m_nLastUsed ) {
+                oldest = it;
+            }
+        }
+        if ( oldest == s_TextureCache.end() ) {
+            break;
+        }
+
+        resident -= oldest->second->GetMemorySize();
+        delete oldest->second;
+        s_TextureCache.erase( oldest );
+        s_nCacheEvictions++;
+    }
+}
+
+static void Tex_FreeLoad( texLoad_t *load )
+{
+    if ( load->pixels ) {
+        stbi_image_free( load->pixels );
+    }
+    delete load;
+}
+
+static void Tex_CreatePlaceholder( void )
+{
+    const byte pixels[] = {
+        96, 96, 96, 255,    160, 160, 160, 255,
+        160, 160, 160, 255, 96, 96, 96, 255
+    };
+
+    glGenTextures( 1, &s_nPlaceholder );
+    glBindTexture( GL_TEXTURE_2D, s_nPlaceholder );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels );
+    glBindTexture( GL_TEXTURE_2D, 0 );
+
+    glGenBuffers( 1, &s_nUploadBuffer );
+}
+
+/*
+* Tex_UploadStrip: copies the next rows of a decoded image into its texture through the unpack
+* buffer, the buffer is orphaned each time so the driver never has to wait on the last strip
+*/
+static void Tex_UploadStrip( texLoad_t *load )
+{
+    const uint64_t rowSize = (uint64_t)load->width * 4;
+    uint64_t numRows, size;
+    void *dst;
+
+    numRows = TEX_UPLOAD_STRIP / rowSize;
+    if ( numRows < 1 ) {
+        numRows = 1;
+    }
+    if ( numRows > (uint64_t)( load->height - load->uploadedRows ) ) {
+        numRows = load->height - load->uploadedRows;
+    }
+    size = numRows * rowSize;
+
+    glBufferData( GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW );
+    dst = glMapBufferRange( GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT );
+    if ( dst ) {
+        memcpy( dst, load->pixels + load->uploadedRows * rowSize, size );
+        glUnmapBuffer( GL_PIXEL_UNPACK_BUFFER );
+        glTexSubImage2D( GL_TEXTURE_2D, 0, 0, load->uploadedRows, load->width, numRows, GL_RGBA, GL_UNSIGNED_BYTE, (const void *)0 );
+    } else {
+        // couldn't map it, let the driver copy straight out of the decoded image
+        glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+        glTexSubImage2D( GL_TEXTURE_2D, 0, 0, load->uploadedRows, load->width, numRows, GL_RGBA, GL_UNSIGNED_BYTE,
+            load->pixels + load->uploadedRows * rowSize );
+        glBindBuffer( GL_PIXEL_UNPACK_BUFFER, s_nUploadBuffer );
+    }
+    load->uploadedRows += numRows;
+}
+
+/*
+* Tex_UploadFrame: the main thread stage, called once a frame. Uploads decoded textures until
+* TEX_UPLOAD_MSEC is used up, a large image is spread over as many frames as it takes.
+*/
+void Tex_UploadFrame( void )
+{
+    const auto start = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock{ s_TextureLock };
+    bool uploaded;
+
+    if ( !s_nPlaceholder ) {
+        Tex_CreatePlaceholder();
+    }
+
+    const auto outOfTime = [&start]( void ) {
+        return std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count() >= TEX_UPLOAD_MSEC;
+    };
+
+    uploaded = false;
+    for ( uint64_t i = 0; i < s_Loads.size(); ) {
+        texLoad_t *load = s_Loads[i];
+        CTexture *texture = load->texture;
+        const int state = load->state.load( std::memory_order_acquire );
+
+        if ( state == TEXLOAD_DECODING ) {
+            i++;
+            continue;
+        }
+
+        if ( texture && state == TEXLOAD_DECODED ) {
+            if ( uploaded && outOfTime() ) {
+                break;
+            }
+            uploaded = true;
+
+            if ( !texture->m_nID ) {
+                const GLint filter = texture->m_nSampler == TEX_SAMPLER_LINEAR ? GL_LINEAR : GL_NEAREST;
+
+                glGenTextures( 1, &texture->m_nID );
+                glBindTexture( GL_TEXTURE_2D, texture->m_nID );
+                glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter );
+                glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter );
+                glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+                glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+                glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, load->width, load->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
+            } else {
+                glBindTexture( GL_TEXTURE_2D, texture->m_nID );
+            }
+
+            glBindBuffer( GL_PIXEL_UNPACK_BUFFER, s_nUploadBuffer );
+            do {
+                Tex_UploadStrip( load );
+            } while ( load->uploadedRows < load->height && !outOfTime() );
+            glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+
+            if ( load->uploadedRows < load->height ) {
+                break;
+            }
+            texture->m_bReady = true;
+        } else if ( texture ) {
+            Log_FPrintf( SYS_WRN, "WARNING: failed to decode texture '%s'\n", load->path.c_str() );
+        }
+
+        if ( texture ) {
+            texture->m_pLoad = NULL;
+        }
+        Tex_FreeLoad( load );
+        s_Loads[i] = s_Loads.back();
+        s_Loads.pop_back();
+    }
+
+    if ( uploaded ) {
+        glBindTexture( GL_TEXTURE_2D, 0 );
+    }
+}
+
+/*
+* Tex_Shutdown: must run before the job system and the GL context go away, every texture is
+* freed whether it's still referenced or not
+*/
+void Tex_Shutdown( void )
+{
+    Job_Cancel( &s_LoadGroup );
+    Job_Wait( &s_LoadGroup );
+
+    std::lock_guard<std::mutex> lock{ s_TextureLock };
+    for ( auto& it : s_TextureCache ) {
+        delete it.second;
+    }
+    s_TextureCache.clear();
+    for ( auto *it : s_Loads ) {
+        Tex_FreeLoad( it );
+    }
+    s_Loads.clear();
+
+    if ( s_nPlaceholder ) {
+        glDeleteTextures( 1, &s_nPlaceholder );
+        glDeleteBuffers( 1, &s_nUploadBuffer );
+        s_nPlaceholder = 0;
+        s_nUploadBuffer = 0;
+    }
+}
+
+void Tex_GetCacheStats( texCacheStats_t *stats )
+{
+    std::lock_guard<std::mutex> lock{ s_TextureLock };
+
+    memset( stats, 0, sizeof(*stats) );
+    for ( const auto& it : s_TextureCache ) {
+        stats->residentBytes += it.second->GetMemorySize();
+        if ( !it.second->GetRefCount() ) {
+            stats->unreferencedBytes += it.second->GetMemorySize();
+            stats->numUnreferenced++;
+        }
+    }
+    stats->numTextures = s_TextureCache.size();
+    stats->numLoading = s_Loads.size();
+    stats->budgetBytes = (uint64_t)g_pPrefsDlg->m_nTextureCacheBudget * 1024 * 1024;
+    stats->hits = s_nCacheHits;
+    stats->misses = s_nCacheMisses;
+    stats->evictions = s_nCacheEvictions;
+}
+
+/*
+* Tex_ForEach: calls func for every cached texture with the cache locked, func mustn't load or
+* release textures
+*/
+void Tex_ForEach( const std::function<void( const CTexture * )>& func )
+{
+    std::lock_guard<std::mutex> lock{ s_TextureLock };
+
+    for ( const auto& it : s_TextureCache ) {
+        func( it.second );
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef __TEXTURE__
+#define __TEXTURE__
+
+#pragma once
+
+#include <string>
+#include <functional>
+
+struct texLoad_s;
+
+typedef enum {
+    TEX_SAMPLER_NEAREST,
+    TEX_SAMPLER_LINEAR,
+
+    NUM_TEX_SAMPLERS
+} texSampler_t;
+
+/*
+* CTexture: a GL texture that loads in two stages, the file is read and decoded on the job system
+* and the pixels are then uploaded a strip at a time at the top of each frame. Until it's resident
+* GetID() hands back a shared placeholder. The dimensions come from the file header up front so a
+* tileset can be built from a texture that's still loading.
+*
+* Textures are shared through the cache, one per file and sampler, so get them from Tex_Load and
+* hand them back with Tex_Release instead of deleting them.
+*/
+class CTexture
+{
+public:
+    uint32_t GetID( void ) const;
+    int GetWidth( void ) const { return m_nWidth; }
+    int GetHeight( void ) const { return m_nHeight; }
+    const std::string& GetName( void ) const { return m_Name; }
+    bool IsReady( void ) const { return m_bReady; }
+    int GetRefCount( void ) const { return m_nRefs; }
+    uint64_t GetMemorySize( void ) const { return m_nID ? (uint64_t)m_nWidth * m_nHeight * 4 : 0; }
+private:
+    CTexture( const char *path, int width, int height, texSampler_t sampler );
+    ~CTexture();
+
+    friend CTexture *Tex_Load( const char *path, texSampler_t sampler );
+    friend void Tex_Release( CTexture *texture );
+    friend void Tex_Reload( const char *path );
+    friend void Tex_StartLoad( CTexture *texture );
+    friend void Tex_UploadFrame( void );
+    friend void Tex_Shutdown( void );
+    friend void Tex_TrimCache( void );
+
+    std::string m_Name;
+    uint32_t m_nID; // 0 until the first strip is uploaded
+    int m_nWidth;
+    int m_nHeight;
+    texSampler_t m_nSampler;
+    bool m_bReady;
+
+    int m_nRefs;
+    uint64_t m_nLastUsed; // when the last reference went away, the oldest unreferenced texture is evicted first
+
+    struct texLoad_s *m_pLoad; // NULL once resident
+};
+
+typedef struct {
+    uint64_t residentBytes;
+    uint64_t unreferencedBytes;
+    uint64_t budgetBytes;
+    uint32_t numTextures;
+    uint32_t numUnreferenced;
+    uint32_t numLoading;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+} texCacheStats_t;
+
+CTexture *Tex_Load( const char *path, texSampler_t sampler = TEX_SAMPLER_NEAREST );
+void Tex_Release( CTexture *texture );
+void Tex_Reload( const char *path );
+void Tex_UploadFrame( void );
+void Tex_TrimCache( void );
+void Tex_Shutdown( void );
+void Tex_GetCacheStats( texCacheStats_t *stats );
+void Tex_ForEach( const std::function<void( const CTexture * )>& func );
+
+#endif
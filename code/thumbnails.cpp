@@ -0,0 +1,472 @@
+#include "editor.h"
+#include "glad/gl.h"
+#include "stb_image.h"
+#include <unordered_map>
+#include <algorithm>
+#include <filesystem>
+
+/*
+===============================================================
+
+Thumbnails: small previews of images and maps for the content
+browser. They're generated on the job system, written to the
+project's Config/thumbnails so the next session can skip the
+decode, and uploaded into slots of one shared atlas texture.
+Slots nobody has drawn lately are handed to new thumbnails once
+the atlas fills up, an evicted thumbnail comes back from disk.
+
+===============================================================
+*/
+
+#define THUMB_ATLAS_SIZE 2048
+#define THUMB_ATLAS_SLOTS ( ( THUMB_ATLAS_SIZE / THUMB_SIZE ) * ( THUMB_ATLAS_SIZE / THUMB_SIZE ) )
+#define THUMB_UPLOADS_PER_FRAME 32
+
+#define THUMB_IDENT (('B'<<24)+('M'<<16)+('H'<<8)+'T')
+#define THUMB_VERSION 1
+
+typedef enum {
+    THUMB_NONE, // needs a job, new or evicted from the atlas
+    THUMB_PENDING,
+    THUMB_DECODED,
+    THUMB_RESIDENT,
+    THUMB_FAILED
+} thumbState_t;
+
+typedef struct {
+    uint64_t fileSize;
+    int64_t modifiedTime;
+    int slot; // -1 when not in the atlas
+    int lastUsed; // ImGui frame it was last drawn in
+    std::atomic<int> state;
+    byte *pixels; // owned by the job until it's decoded, freed once uploaded
+} thumb_t;
+
+// only touched from the main thread, the jobs only get their own thumb_t
+static std::unordered_map<std::string, thumb_t *> s_Thumbnails;
+static thumb_t *s_Slots[THUMB_ATLAS_SLOTS];
+static uint32_t s_nResident;
+static GLuint s_nAtlas;
+static jobGroup_t s_ThumbGroup;
+static int s_nUploadFrame, s_nUploads;
+
+bool Thumb_CanGenerate( const char *path )
+{
+    const char *ext = COM_GetExtension( path );
+
+    return !N_stricmp( ext, "png" ) || !N_stricmp( ext, "jpg" ) || !N_stricmp( ext, "jpeg" ) || !N_stricmp( ext, "tga" )
+        || !N_stricmp( ext, "bmp" ) || !N_stricmp( ext, "map" );
+}
+
+/*
+* Thumb_Resample: box filters an RGBA image into the middle of a thumbnail, images smaller than a
+* thumbnail are scaled up with nearest
+*/
+static void Thumb_Resample( const byte *src, int width, int height, byte *out )
+{
+    int outWidth, outHeight, offsetX, offsetY;
+
+    memset( out, 0, THUMB_SIZE * THUMB_SIZE * 4 );
+
+    if ( width >= height ) {
+        outWidth = THUMB_SIZE;
+        outHeight = std::max( 1, height * THUMB_SIZE / width );
+    } else {
+        outHeight = THUMB_SIZE;
+        outWidth = std::max( 1, width * THUMB_SIZE / height );
+    }
+    offsetX = ( THUMB_SIZE - outWidth ) / 2;
+    offsetY = ( THUMB_SIZE - outHeight ) / 2;
+
+    for ( int y = 0; y < outHeight; y++ ) {
+        const int y0 = y * height / outHeight;
+        const int y1 = std::max( y0 + 1, ( y + 1 ) * height / outHeight );
+
+        for ( int x = 0; x < outWidth; x++ ) {
+            const int x0 = x * width / outWidth;
+            const int x1 = std::max( x0 + 1, ( x + 1 ) * width / outWidth );
+            uint32_t sum[4] = { 0, 0, 0, 0 };
+            byte *dst;
+
+            for ( int sy = y0; sy < y1; sy++ ) {
+                const byte *row = src + ( (uint64_t)sy * width + x0 ) * 4;
+                for ( int sx = x0; sx < x1; sx++, row += 4 ) {
+                    sum[0] += row[0];
+                    sum[1] += row[1];
+                    sum[2] += row[2];
+                    sum[3] += row[3];
+                }
+            }
+
+            const uint32_t count = ( y1 - y0 ) * ( x1 - x0 );
+            dst = out + ( ( offsetY + y ) * THUMB_SIZE + offsetX + x ) * 4;
+            dst[0] = sum[0] / count;
+            dst[1] = sum[1] / count;
+            dst[2] = sum[2] / count;
+            dst[3] = sum[3] / count;
+        }
+    }
+}
+
+static bool Thumb_GenerateImage( const char *path, byte *out )
+{
+    int width, height, channels;
+    byte *pixels;
+
+    pixels = stbi_load( path, &width, &height, &channels, STBI_rgb_alpha );
+    if ( !pixels ) {
+        return false;
+    }
+    Thumb_Resample( pixels, width, height, out );
+    stbi_image_free( pixels );
+
+    return true;
+}
+
+/*
+* Thumb_GenerateMap: a top down view of where a map has tiles, coloured by tileset index. Only the
+* size and each tile's pos and texIndex matter, so the file is read a line at a time the way
+* Map_Save writes it instead of tokenizing all of it.
+*/
+static bool Thumb_GenerateMap( const char *path, byte *out )
+{
+    union {
+        void *v;
+        char *b;
+    } f;
+    std::vector<byte> grid;
+    char line[1024];
+    const char *p, *end, *text;
+    uint64_t length, n;
+    int width, height, depth, x, y, z, texIndex;
+    bool inTile;
+
+    if ( !FileExists( path ) ) {
+        return false;
+    }
+    length = LoadFile( path, &f.v );
+    if ( !f.v ) {
+        return false;
+    }
+
+    width = height = 0;
+    depth = 0;
+    inTile = false;
+    x = y = -1;
+    texIndex = -1;
+    p = f.b;
+    end = f.b + length;
+    while ( p < end ) {
+        n = 0;
+        while ( p < end && *p != '\n' ) {
+            if ( n < sizeof(line) - 1 ) {
+                line[n++] = *p;
+            }
+            p++;
+        }
+        line[n] = '\0';
+        p++;
+
+        text = line;
+        while ( *text && isspace( (unsigned char)*text ) ) {
+            text++;
+        }
+
+        if ( *text == '{' ) {
+            depth++;
+            continue;
+        }
+        if ( *text == '}' ) {
+            if ( inTile && x >= 0 && y >= 0 && x < width && y < height ) {
+                byte *dst = &grid[ ( (uint64_t)y * width + x ) * 4 ];
+                const uint32_t hash = (uint32_t)Com_HashBuffer( &texIndex, sizeof(texIndex), 0 );
+
+                // the same tileset index always gets the same colour, bright enough to read as a tile
+                dst[0] = 64 + ( hash & 0x7f );
+                dst[1] = 64 + ( ( hash >> 8 ) & 0x7f );
+                dst[2] = 64 + ( ( hash >> 16 ) & 0x7f );
+                dst[3] = 255;
+            }
+            depth--;
+            inTile = false;
+            x = y = -1;
+            texIndex = -1;
+            continue;
+        }
+
+        if ( depth == 1 ) {
+            if ( sscanf( text, "width %i", &x ) == 1 ) {
+                width = x;
+            } else if ( sscanf( text, "height %i", &y ) == 1 ) {
+                height = y;
+            }
+            x = y = -1;
+            if ( width > 0 && height > 0 && width <= 4096 && height <= 4096 && grid.empty() ) {
+                grid.resize( (uint64_t)width * height * 4, 40 );
+            }
+        } else if ( !strncmp( text, "classname", 9 ) ) {
+            inTile = strstr( text, "\"map_tile\"" ) != NULL;
+        } else if ( inTile ) {
+            if ( sscanf( text, "pos %i %i %i", &x, &y, &z ) != 3 ) {
+                sscanf( text, "texIndex %i", &texIndex );
+            }
+        }
+    }
+    FreeMemory( f.v );
+
+    if ( grid.empty() ) {
+        return false;
+    }
+    Thumb_Resample( grid.data(), width, height, out );
+
+    return true;
+}
+
+static bool Thumb_ReadCache( const std::string& cachePath, byte *out )
+{
+    uint32_t header[2];
+    FILE *fp;
+    bool valid;
+
+    fp = fopen( cachePath.c_str(), "rb" );
+    if ( !fp ) {
+        return false;
+    }
+    valid = fread( header, sizeof(header), 1, fp ) == 1 && header[0] == THUMB_IDENT && header[1] == THUMB_VERSION
+        && fread( out, THUMB_SIZE * THUMB_SIZE * 4, 1, fp ) == 1;
+    fclose( fp );
+
+    return valid;
+}
+
+static void Thumb_WriteCache( const std::string& cachePath, const byte *pixels )
+{
+    const uint32_t header[2] = { THUMB_IDENT, THUMB_VERSION };
+    const std::string tmpPath = cachePath + ".tmp";
+    std::error_code error;
+    FILE *fp;
+    bool ok;
+
+    std::filesystem::create_directories( std::filesystem::path( cachePath ).parent_path(), error );
+
+    // runs on a job, so a full disk just means no cache entry, never an Error()
+    fp = fopen( tmpPath.c_str(), "wb" );
+    if ( !fp ) {
+        return;
+    }
+    ok = fwrite( header, sizeof(header), 1, fp ) == 1;
+    ok = ok && fwrite( pixels, THUMB_SIZE * THUMB_SIZE * 4, 1, fp ) == 1;
+    ok = ( fclose( fp ) == 0 ) && ok;
+    if ( !ok ) {
+        remove( tmpPath.c_str() );
+        return;
+    }
+
+    if ( rename( tmpPath.c_str(), cachePath.c_str() ) == -1 ) {
+        remove( tmpPath.c_str() );
+    }
+}
+
+static void Thumb_Queue( const std::string& path, thumb_t *thumb )
+{
+    uint64_t hash;
+    std::string cachePath;
+
+    // a new version of the file gets a new cache entry, the old one is just never read again
+    hash = Com_HashBuffer( path.c_str(), path.size(), 0 );
+    hash = Com_HashBuffer( &thumb->fileSize, sizeof(thumb->fileSize), hash );
+    hash = Com_HashBuffer( &thumb->modifiedTime, sizeof(thumb->modifiedTime), hash );
+    cachePath = va( "%sConfig%cthumbnails%c%016lx.thumb", g_pProjectManager->GetProject()->m_FilePath.c_str(), PATH_SEP, PATH_SEP,
+        (unsigned long)hash );
+
+    delete[] thumb->pixels;
+    thumb->pixels = NULL;
+
+    thumb->state = THUMB_PENDING;
+    Job_Add( &s_ThumbGroup, JOB_PRIORITY_BACKGROUND, [path, cachePath, thumb]( void ) {
+        bool generated;
+
+        thumb->pixels = new byte[ THUMB_SIZE * THUMB_SIZE * 4 ];
+        if ( Thumb_ReadCache( cachePath, thumb->pixels ) ) {
+            thumb->state.store( THUMB_DECODED, std::memory_order_release );
+            return;
+        }
+
+        if ( !N_stricmp( COM_GetExtension( path.c_str() ), "map" ) ) {
+            generated = Thumb_GenerateMap( path.c_str(), thumb->pixels );
+        } else {
+            generated = Thumb_GenerateImage( path.c_str(), thumb->pixels );
+        }
+        if ( generated ) {
+            Thumb_WriteCache( cachePath, thumb->pixels );
+        } else {
+            delete[] thumb->pixels;
+            thumb->pixels = NULL;
+        }
+        thumb->state.store( generated ? THUMB_DECODED : THUMB_FAILED, std::memory_order_release );
+    } );
+}
+
+static void Thumb_ReleaseSlot( thumb_t *thumb )
+{
+    if ( thumb->slot != -1 ) {
+        s_Slots[thumb->slot] = NULL;
+        thumb->slot = -1;
+        s_nResident--;
+    }
+}
+
+/*
+* Thumb_AllocSlot: a free slot, or the one drawn longest ago as long as that wasn't this frame.
+* Only resident thumbnails are evicted, anything else may still have a job writing its pixels.
+*/
+static int Thumb_AllocSlot( int frame )
+{
+    thumb_t *evicted;
+    int oldest;
+
+    oldest = -1;
+    for ( int i = 0; i < THUMB_ATLAS_SLOTS; i++ ) {
+        if ( !s_Slots[i] ) {
+            return i;
+        }
+        if ( s_Slots[i]->state.load( std::memory_order_relaxed ) != THUMB_RESIDENT ) {
+            continue;
+        }
+        if ( s_Slots[i]->lastUsed < frame && ( oldest == -1 || s_Slots[i]->lastUsed < s_Slots[oldest]->lastUsed ) ) {
+            oldest = i;
+        }
+    }
+    if ( oldest != -1 ) {
+        evicted = s_Slots[oldest];
+        Thumb_ReleaseSlot( evicted );
+        evicted->state = THUMB_NONE;
+    }
+    return oldest;
+}
+
+static void Thumb_Upload( thumb_t *thumb )
+{
+    if ( !s_nAtlas ) {
+        glGenTextures( 1, &s_nAtlas );
+        glBindTexture( GL_TEXTURE_2D, s_nAtlas );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+        glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, THUMB_ATLAS_SIZE, THUMB_ATLAS_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
+    } else {
+        glBindTexture( GL_TEXTURE_2D, s_nAtlas );
+    }
+
+    glTexSubImage2D( GL_TEXTURE_2D, 0, ( thumb->slot % ( THUMB_ATLAS_SIZE / THUMB_SIZE ) ) * THUMB_SIZE,
+        ( thumb->slot / ( THUMB_ATLAS_SIZE / THUMB_SIZE ) ) * THUMB_SIZE, THUMB_SIZE, THUMB_SIZE, GL_RGBA, GL_UNSIGNED_BYTE,
+        thumb->pixels );
+    glBindTexture( GL_TEXTURE_2D, 0 );
+}
+
+/*
+* Thumb_Get: the thumbnail for a file as of the given size and mtime, starting a job for it the first
+* time it's asked for. Returns false until it's in the atlas or if the file can't be previewed, the
+* caller draws its generic icon meanwhile. Main thread only.
+*/
+bool Thumb_Get( const std::string& path, uint64_t fileSize, int64_t modifiedTime, thumbImage_t *image )
+{
+    const int frame = ImGui::GetFrameCount();
+    thumb_t *thumb;
+    int state;
+
+    if ( frame != s_nUploadFrame ) {
+        s_nUploadFrame = frame;
+        s_nUploads = 0;
+    }
+
+    auto it = s_Thumbnails.find( path );
+    if ( it == s_Thumbnails.end() ) {
+        thumb = new thumb_t;
+        thumb->fileSize = fileSize;
+        thumb->modifiedTime = modifiedTime;
+        thumb->slot = -1;
+        thumb->lastUsed = frame;
+        thumb->pixels = NULL;
+        thumb->state = THUMB_NONE;
+        it = s_Thumbnails.try_emplace( path, thumb ).first;
+    }
+    thumb = it->second;
+    thumb->lastUsed = frame;
+
+    state = thumb->state.load( std::memory_order_acquire );
+    if ( state == THUMB_PENDING ) {
+        return false;
+    }
+    if ( thumb->fileSize != fileSize || thumb->modifiedTime != modifiedTime ) {
+        // changed on disk, the new version gets a slot once it's decoded
+        thumb->fileSize = fileSize;
+        thumb->modifiedTime = modifiedTime;
+        Thumb_ReleaseSlot( thumb );
+        state = THUMB_NONE;
+    }
+
+    if ( state == THUMB_NONE ) {
+        Thumb_Queue( path, thumb );
+        return false;
+    }
+    if ( state == THUMB_FAILED ) {
+        return false;
+    }
+
+    if ( state == THUMB_DECODED ) {
+        if ( s_nUploads >= THUMB_UPLOADS_PER_FRAME ) {
+            return false;
+        }
+        if ( thumb->slot == -1 ) {
+            thumb->slot = Thumb_AllocSlot( frame );
+            if ( thumb->slot == -1 ) {
+                // every slot is on screen right now
+                return false;
+            }
+            s_Slots[thumb->slot] = thumb;
+            s_nResident++;
+        }
+        Thumb_Upload( thumb );
+        s_nUploads++;
+        delete[] thumb->pixels;
+        thumb->pixels = NULL;
+        thumb->state = THUMB_RESIDENT;
+    }
+
+    const float slotSize = (float)THUMB_SIZE / THUMB_ATLAS_SIZE;
+    image->texture = s_nAtlas;
+    image->uv0[0] = ( thumb->slot % ( THUMB_ATLAS_SIZE / THUMB_SIZE ) ) * slotSize;
+    image->uv0[1] = ( thumb->slot / ( THUMB_ATLAS_SIZE / THUMB_SIZE ) ) * slotSize;
+    image->uv1[0] = image->uv0[0] + slotSize;
+    image->uv1[1] = image->uv0[1] + slotSize;
+
+    return true;
+}
+
+uint32_t Thumb_NumResident( void ) {
+    return s_nResident;
+}
+
+/*
+* Thumb_Shutdown: must run before the job system and the GL context go away
+*/
+void Thumb_Shutdown( void )
+{
+    Job_Cancel( &s_ThumbGroup );
+    Job_Wait( &s_ThumbGroup );
+
+    for ( auto& it : s_Thumbnails ) {
+        delete[] it.second->pixels;
+        delete it.second;
+    }
+    s_Thumbnails.clear();
+    memset( s_Slots, 0, sizeof(s_Slots) );
+    s_nResident = 0;
+
+    if ( s_nAtlas ) {
+        glDeleteTextures( 1, &s_nAtlas );
+        s_nAtlas = 0;
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef __THUMBNAILS__
+#define __THUMBNAILS__
+
+#pragma once
+
+#include <string>
+
+#define THUMB_SIZE 64 // pixels per side of a thumbnail, they're letterboxed to keep their aspect
+
+/*
+* thumbImage_t: where a thumbnail sits in the atlas, only good for the frame it was returned in
+*/
+typedef struct {
+    uint32_t texture;
+    float uv0[2];
+    float uv1[2];
+} thumbImage_t;
+
+bool Thumb_CanGenerate( const char *path );
+bool Thumb_Get( const std::string& path, uint64_t fileSize, int64_t modifiedTime, thumbImage_t *image );
+void Thumb_Shutdown( void );
+uint32_t Thumb_NumResident( void );
+
+#endif
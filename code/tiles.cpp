@@ -0,0 +1,495 @@
+#include "editor.h"
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define USE_SSE2
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/*
+===============================================================
+
+Tile store: struct-of-arrays tiles for the editor, maptile_t is
+only built when tiles leave the editor (compiling, the clipboard)
+
+===============================================================
+*/
+
+#define PLANE_COLOR     0x0001
+#define PLANE_ELEVATION 0x0002
+
+typedef struct {
+    int32_t width;
+    int32_t height;
+    uint32_t planes;
+} packedTiles_t;
+
+static inline int LowestBit( uint32_t bits )
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward( &index, bits );
+    return (int)index;
+#else
+    return __builtin_ctz( bits );
+#endif
+}
+
+static inline uint64_t PopCount( uint64_t bits )
+{
+#ifdef _MSC_VER
+    return __popcnt64( bits );
+#else
+    return __builtin_popcountll( bits );
+#endif
+}
+
+template<typename T>
+static T *AllocPlane( uint64_t numTiles )
+{
+    return (T *)Sys_ReservePages( sizeof(T) * numTiles );
+}
+
+template<typename T>
+static void FreePlane( T *&plane, uint64_t numTiles )
+{
+    Sys_ReleasePages( plane, sizeof(T) * numTiles );
+    plane = NULL;
+}
+
+/*
+* CopyPlane: copies the part of src that overlaps dst's dimensions, row by row
+*/
+template<typename T>
+static void CopyPlane( T *dst, int dstWidth, int dstHeight, const T *src, int srcWidth, int srcHeight )
+{
+    int y, width, height;
+
+    if ( !dst || !src ) {
+        return;
+    }
+
+    width = dstWidth < srcWidth ? dstWidth : srcWidth;
+    height = dstHeight < srcHeight ? dstHeight : srcHeight;
+    for ( y = 0; y < height; y++ ) {
+        memcpy( &dst[ y * dstWidth ], &src[ y * srcWidth ], sizeof(T) * width );
+    }
+}
+
+static inline uint64_t *Tiles_PlaneData( const tileStore_t *store, int plane )
+{
+    return store->planes + store->planeWords * plane;
+}
+
+/*
+* Tiles_FlipBits: flips tile's bit in the plane base + n for every bit n set in bits
+*/
+static void Tiles_FlipBits( tileStore_t *store, uint64_t tile, int base, uint32_t bits )
+{
+    const uint64_t mask = 1ULL << ( tile & 63 );
+
+    while ( bits ) {
+        Tiles_PlaneData( store, base + LowestBit( bits ) )[ tile >> 6 ] ^= mask;
+        bits &= bits - 1;
+    }
+}
+
+static void Tiles_RebuildPlanes( tileStore_t *store )
+{
+    const uint64_t numTiles = (uint64_t)store->width * store->height;
+    uint64_t i;
+
+    Sys_ResetPages( store->planes, sizeof(*store->planes) * store->planeWords * TILES_NUM_PLANES );
+    for ( i = 0; i < numTiles; i++ ) {
+        Tiles_FlipBits( store, i, 0, store->flags[i] );
+        Tiles_FlipBits( store, i, TILES_SIDE_PLANE( 0 ), store->sides[i] );
+    }
+}
+
+bool Tiles_Alloc( tileStore_t *store, int width, int height )
+{
+    uint64_t numTiles;
+
+    memset( store, 0, sizeof(*store) );
+    if ( width <= 0 || height <= 0 ) {
+        return false;
+    }
+
+    numTiles = (uint64_t)width * height;
+    store->index = AllocPlane<int32_t>( numTiles );
+    store->flags = AllocPlane<uint32_t>( numTiles );
+    store->sides = AllocPlane<uint16_t>( numTiles );
+
+    // rounded up to whole 128 bit vectors, the padding bits are never set
+    store->planeWords = ( ( numTiles + 127 ) / 128 ) * 2;
+    store->planes = AllocPlane<uint64_t>( store->planeWords * TILES_NUM_PLANES );
+
+    store->width = width;
+    store->height = height;
+
+    return true;
+}
+
+void Tiles_Free( tileStore_t *store )
+{
+    const uint64_t numTiles = (uint64_t)store->width * store->height;
+
+    FreePlane( store->index, numTiles );
+    FreePlane( store->flags, numTiles );
+    FreePlane( store->sides, numTiles );
+    FreePlane( store->color, numTiles );
+    FreePlane( store->elevation, numTiles );
+    FreePlane( store->planes, store->planeWords * TILES_NUM_PLANES );
+    store->planeWords = 0;
+    store->width = 0;
+    store->height = 0;
+}
+
+void Tiles_Resize( tileStore_t *store, int width, int height )
+{
+    tileStore_t resized;
+
+    if ( store->width == width && store->height == height && store->index ) {
+        return;
+    }
+
+    Tiles_Alloc( &resized, width, height );
+    if ( resized.index ) {
+        if ( store->color ) {
+            resized.color = AllocPlane<vec4_t>( (uint64_t)width * height );
+        }
+        if ( store->elevation ) {
+            resized.elevation = AllocPlane<uint32_t>( (uint64_t)width * height );
+        }
+        CopyPlane( resized.index, width, height, store->index, store->width, store->height );
+        CopyPlane( resized.flags, width, height, store->flags, store->width, store->height );
+        CopyPlane( resized.sides, width, height, store->sides, store->width, store->height );
+        CopyPlane( resized.color, width, height, store->color, store->width, store->height );
+        CopyPlane( resized.elevation, width, height, store->elevation, store->width, store->height );
+        Tiles_RebuildPlanes( &resized );
+    }
+
+    Tiles_Free( store );
+    *store = resized;
+}
+
+/*
+* Tiles_Clear: empties every tile without writing to them. The planes' pages go back to the OS and
+* read as zero until something is stored in them again, so the cost scales with the pages the map
+* had touched rather than with its size, and the untouched parts of a huge map cost nothing at all.
+*/
+void Tiles_Clear( tileStore_t *store )
+{
+    const uint64_t numTiles = (uint64_t)store->width * store->height;
+
+    if ( !store->index ) {
+        return;
+    }
+
+    Sys_ResetPages( store->index, sizeof(*store->index) * numTiles );
+    Sys_ResetPages( store->flags, sizeof(*store->flags) * numTiles );
+    Sys_ResetPages( store->sides, sizeof(*store->sides) * numTiles );
+    Sys_ResetPages( store->planes, sizeof(*store->planes) * store->planeWords * TILES_NUM_PLANES );
+
+    // an empty map doesn't need the cold planes
+    FreePlane( store->color, numTiles );
+    FreePlane( store->elevation, numTiles );
+}
+
+/*
+* Tiles_DataSize: bytes held by the per-tile arrays, which is everything Tiles_Pack writes
+*/
+static uint64_t Tiles_DataSize( const tileStore_t *store )
+{
+    uint64_t perTile;
+
+    perTile = sizeof(*store->index) + sizeof(*store->flags) + sizeof(*store->sides);
+    if ( store->color ) {
+        perTile += sizeof(*store->color);
+    }
+    if ( store->elevation ) {
+        perTile += sizeof(*store->elevation);
+    }
+    return store->index ? perTile * store->width * store->height : 0;
+}
+
+uint64_t Tiles_MemorySize( const tileStore_t *store )
+{
+    return Tiles_DataSize( store ) + sizeof(*store->planes) * store->planeWords * TILES_NUM_PLANES;
+}
+
+void Tiles_SetFlags( tileStore_t *store, uint64_t tile, uint32_t flags )
+{
+    Tiles_FlipBits( store, tile, 0, store->flags[tile] ^ flags );
+    store->flags[tile] = flags;
+}
+
+void Tiles_SetSides( tileStore_t *store, uint64_t tile, uint32_t sides )
+{
+    sides &= ( 1 << NUMDIRS ) - 1;
+    Tiles_FlipBits( store, tile, TILES_SIDE_PLANE( 0 ), store->sides[tile] ^ sides );
+    store->sides[tile] = sides;
+}
+
+void Tiles_SetColor( tileStore_t *store, uint64_t tile, const vec4_t color )
+{
+    if ( !store->color ) {
+        if ( !color[0] && !color[1] && !color[2] && !color[3] ) {
+            return;
+        }
+        store->color = AllocPlane<vec4_t>( (uint64_t)store->width * store->height );
+    }
+    memcpy( store->color[tile], color, sizeof(vec4_t) );
+}
+
+void Tiles_SetElevation( tileStore_t *store, uint64_t tile, uint32_t elevation )
+{
+    if ( !store->elevation ) {
+        if ( !elevation ) {
+            return;
+        }
+        store->elevation = AllocPlane<uint32_t>( (uint64_t)store->width * store->height );
+    }
+    store->elevation[tile] = elevation;
+}
+
+void Tiles_GetTile( const tileStore_t *store, uint64_t tile, const spriteCoord_t *texcoords, uint32_t numSprites, maptile_t *out )
+{
+    int i;
+
+    memset( out, 0, sizeof(*out) );
+    out->index = store->index[tile];
+    out->flags = store->flags[tile];
+    out->pos[0] = tile % store->width;
+    out->pos[1] = tile / store->width;
+    out->pos[2] = store->elevation ? store->elevation[tile] : 0;
+    for ( i = 0; i < DIR_NULL; i++ ) {
+        out->sides[i] = Tiles_HasSide( store, tile, i );
+    }
+    if ( store->color ) {
+        memcpy( out->color, store->color[tile], sizeof(out->color) );
+    }
+    if ( texcoords && out->index >= 0 && (uint32_t)out->index < numSprites ) {
+        memcpy( out->texcoords, texcoords[ out->index ], sizeof(out->texcoords) );
+    }
+}
+
+void Tiles_SetTile( tileStore_t *store, uint64_t tile, const maptile_t *in )
+{
+    uint32_t sides;
+    int i;
+
+    // maptile_t has no room for the inside, so that one is left as it is
+    sides = store->sides[tile] & ( 1 << DIR_NULL );
+    for ( i = 0; i < DIR_NULL; i++ ) {
+        if ( in->sides[i] ) {
+            sides |= ( 1 << i );
+        }
+    }
+
+    store->index[tile] = in->index;
+    Tiles_SetFlags( store, tile, in->flags );
+    Tiles_SetSides( store, tile, sides );
+    Tiles_SetColor( store, tile, in->color );
+    Tiles_SetElevation( store, tile, in->pos[2] );
+}
+
+/*
+* Tiles_ToMapTiles: expands the first numTiles tiles to the on-disk layout into out, which must have
+* room for numTiles of them. Returns how many were written, never more than the store holds.
+*/
+uint64_t Tiles_ToMapTiles( const tileStore_t *store, uint64_t numTiles, const spriteCoord_t *texcoords, uint32_t numSprites, maptile_t *out )
+{
+    uint64_t i;
+
+    if ( numTiles > (uint64_t)store->width * store->height ) {
+        numTiles = (uint64_t)store->width * store->height;
+    }
+
+    for ( i = 0; i < numTiles; i++ ) {
+        Tiles_GetTile( store, i, texcoords, numSprites, &out[i] );
+    }
+
+    return numTiles;
+}
+
+uint64_t Tiles_PackedSize( const tileStore_t *store )
+{
+    return sizeof(packedTiles_t) + Tiles_DataSize( store );
+}
+
+void Tiles_Pack( const tileStore_t *store, byte *out )
+{
+    packedTiles_t header;
+    const uint64_t numTiles = (uint64_t)store->width * store->height;
+
+    header.width = store->width;
+    header.height = store->height;
+    header.planes = ( store->color ? PLANE_COLOR : 0 ) | ( store->elevation ? PLANE_ELEVATION : 0 );
+    memcpy( out, &header, sizeof(header) );
+    out += sizeof(header);
+
+    if ( !store->index ) {
+        return;
+    }
+
+    memcpy( out, store->index, sizeof(*store->index) * numTiles );
+    out += sizeof(*store->index) * numTiles;
+    memcpy( out, store->flags, sizeof(*store->flags) * numTiles );
+    out += sizeof(*store->flags) * numTiles;
+    memcpy( out, store->sides, sizeof(*store->sides) * numTiles );
+    out += sizeof(*store->sides) * numTiles;
+    if ( store->color ) {
+        memcpy( out, store->color, sizeof(*store->color) * numTiles );
+        out += sizeof(*store->color) * numTiles;
+    }
+    if ( store->elevation ) {
+        memcpy( out, store->elevation, sizeof(*store->elevation) * numTiles );
+    }
+}
+
+bool Tiles_Unpack( tileStore_t *store, const byte *in, uint64_t size )
+{
+    packedTiles_t header;
+    uint64_t numTiles;
+
+    if ( size < sizeof(header) ) {
+        return false;
+    }
+    memcpy( &header, in, sizeof(header) );
+    in += sizeof(header);
+
+    if ( !Tiles_Alloc( store, header.width, header.height ) ) {
+        return size == sizeof(header);
+    }
+    if ( header.planes & PLANE_COLOR ) {
+        store->color = AllocPlane<vec4_t>( (uint64_t)header.width * header.height );
+    }
+    if ( header.planes & PLANE_ELEVATION ) {
+        store->elevation = AllocPlane<uint32_t>( (uint64_t)header.width * header.height );
+    }
+    if ( size != Tiles_PackedSize( store ) ) {
+        Tiles_Free( store );
+        return false;
+    }
+
+    numTiles = (uint64_t)store->width * store->height;
+    memcpy( store->index, in, sizeof(*store->index) * numTiles );
+    in += sizeof(*store->index) * numTiles;
+    memcpy( store->flags, in, sizeof(*store->flags) * numTiles );
+    in += sizeof(*store->flags) * numTiles;
+    memcpy( store->sides, in, sizeof(*store->sides) * numTiles );
+    in += sizeof(*store->sides) * numTiles;
+    if ( store->color ) {
+        memcpy( store->color, in, sizeof(*store->color) * numTiles );
+        in += sizeof(*store->color) * numTiles;
+    }
+    if ( store->elevation ) {
+        memcpy( store->elevation, in, sizeof(*store->elevation) * numTiles );
+    }
+    Tiles_RebuildPlanes( store );
+
+    return true;
+}
+
+/*
+===============================================================
+
+Bitplane queries
+
+===============================================================
+*/
+
+int Tiles_FlagPlane( uint32_t flag )
+{
+    return flag ? LowestBit( flag ) : -1;
+}
+
+const uint64_t *Tiles_GetPlane( const tileStore_t *store, int plane )
+{
+    if ( !store->planes || plane < 0 || plane >= TILES_NUM_PLANES ) {
+        return NULL;
+    }
+    return Tiles_PlaneData( store, plane );
+}
+
+uint64_t Tiles_CountPlane( const tileStore_t *store, int plane )
+{
+    const uint64_t *bits;
+
+    bits = Tiles_GetPlane( store, plane );
+    return bits ? Bits_Count( bits, store->planeWords ) : 0;
+}
+
+void Bits_And( uint64_t *out, const uint64_t *a, const uint64_t *b, uint64_t count )
+{
+    uint64_t i;
+
+    i = 0;
+#ifdef USE_SSE2
+    for ( ; i + 2 <= count; i += 2 ) {
+        _mm_storeu_si128( (__m128i *)&out[i], _mm_and_si128( _mm_loadu_si128( (const __m128i *)&a[i] ),
+            _mm_loadu_si128( (const __m128i *)&b[i] ) ) );
+    }
+#endif
+    for ( ; i < count; i++ ) {
+        out[i] = a[i] & b[i];
+    }
+}
+
+void Bits_Or( uint64_t *out, const uint64_t *a, const uint64_t *b, uint64_t count )
+{
+    uint64_t i;
+
+    i = 0;
+#ifdef USE_SSE2
+    for ( ; i + 2 <= count; i += 2 ) {
+        _mm_storeu_si128( (__m128i *)&out[i], _mm_or_si128( _mm_loadu_si128( (const __m128i *)&a[i] ),
+            _mm_loadu_si128( (const __m128i *)&b[i] ) ) );
+    }
+#endif
+    for ( ; i < count; i++ ) {
+        out[i] = a[i] | b[i];
+    }
+}
+
+/*
+* Bits_Count: popcount over four independent sums so the adds don't serialize, an all zero plane
+* (the common case for most flags) costs no more than reading it
+*/
+uint64_t Bits_Count( const uint64_t *a, uint64_t count )
+{
+    uint64_t sum[4];
+    uint64_t i;
+
+    sum[0] = sum[1] = sum[2] = sum[3] = 0;
+    for ( i = 0; i + 4 <= count; i += 4 ) {
+        sum[0] += PopCount( a[i + 0] );
+        sum[1] += PopCount( a[i + 1] );
+        sum[2] += PopCount( a[i + 2] );
+        sum[3] += PopCount( a[i + 3] );
+    }
+    for ( ; i < count; i++ ) {
+        sum[0] += PopCount( a[i] );
+    }
+    return sum[0] + sum[1] + sum[2] + sum[3];
+}
+
+uint64_t Bits_CountAnd( const uint64_t *a, const uint64_t *b, uint64_t count )
+{
+    uint64_t sum[4];
+    uint64_t i;
+
+    sum[0] = sum[1] = sum[2] = sum[3] = 0;
+    for ( i = 0; i + 4 <= count; i += 4 ) {
+        sum[0] += PopCount( a[i + 0] & b[i + 0] );
+        sum[1] += PopCount( a[i + 1] & b[i + 1] );
+        sum[2] += PopCount( a[i + 2] & b[i + 2] );
+        sum[3] += PopCount( a[i + 3] & b[i + 3] );
+    }
+    for ( ; i < count; i++ ) {
+        sum[0] += PopCount( a[i] & b[i] );
+    }
+    return sum[0] + sum[1] + sum[2] + sum[3];
+}
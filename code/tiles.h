@@ -0,0 +1,76 @@
+#ifndef __TILES__
+#define __TILES__
+
+#pragma once
+
+// one bitplane per flags bit and per side, planes are one bit per tile in uint64_t words
+#define TILES_FLAG_PLANES 32
+#define TILES_SIDE_PLANE( dir ) ( TILES_FLAG_PLANES + (dir) )
+#define TILES_NUM_PLANES ( TILES_FLAG_PLANES + NUMDIRS )
+
+/*
+* tileStore_t: the editor's copy of a map's tiles, kept as one contiguous plane per field so a
+* pass over the whole map only pulls in what it reads. A tile's texcoords come from its index into
+* the tileset and its pos from where it sits in the planes, neither is stored. The cold planes stay
+* NULL until some tile actually needs them. flags and sides must be changed through Tiles_SetFlags
+* and Tiles_SetSides so their bitplanes stay in sync.
+*/
+typedef struct {
+    int32_t *index; // tileset sprite
+    uint32_t *flags; // SURFACEPARM_*
+    uint16_t *sides; // one bit per dirtype_t, DIR_NULL is the inside of the tile
+
+    vec4_t *color;
+    uint32_t *elevation;
+
+    uint64_t *planes; // TILES_NUM_PLANES planes of planeWords each
+    uint64_t planeWords;
+
+    int width;
+    int height;
+} tileStore_t;
+
+bool Tiles_Alloc( tileStore_t *store, int width, int height );
+void Tiles_Free( tileStore_t *store );
+void Tiles_Resize( tileStore_t *store, int width, int height );
+void Tiles_Clear( tileStore_t *store );
+uint64_t Tiles_MemorySize( const tileStore_t *store );
+
+void Tiles_SetFlags( tileStore_t *store, uint64_t tile, uint32_t flags );
+void Tiles_SetSides( tileStore_t *store, uint64_t tile, uint32_t sides );
+void Tiles_SetColor( tileStore_t *store, uint64_t tile, const vec4_t color );
+void Tiles_SetElevation( tileStore_t *store, uint64_t tile, uint32_t elevation );
+
+// converters to and from the on-disk layout
+void Tiles_GetTile( const tileStore_t *store, uint64_t tile, const spriteCoord_t *texcoords, uint32_t numSprites, maptile_t *out );
+void Tiles_SetTile( tileStore_t *store, uint64_t tile, const maptile_t *in );
+uint64_t Tiles_ToMapTiles( const tileStore_t *store, uint64_t numTiles, const spriteCoord_t *texcoords, uint32_t numSprites, maptile_t *out );
+
+// flat copy of every plane, used to page maps out
+uint64_t Tiles_PackedSize( const tileStore_t *store );
+void Tiles_Pack( const tileStore_t *store, byte *out );
+bool Tiles_Unpack( tileStore_t *store, const byte *in, uint64_t size );
+
+// bitplane queries, out may alias either input and count is in words
+int Tiles_FlagPlane( uint32_t flag );
+const uint64_t *Tiles_GetPlane( const tileStore_t *store, int plane );
+uint64_t Tiles_CountPlane( const tileStore_t *store, int plane );
+
+void Bits_And( uint64_t *out, const uint64_t *a, const uint64_t *b, uint64_t count );
+void Bits_Or( uint64_t *out, const uint64_t *a, const uint64_t *b, uint64_t count );
+uint64_t Bits_Count( const uint64_t *a, uint64_t count );
+uint64_t Bits_CountAnd( const uint64_t *a, const uint64_t *b, uint64_t count );
+
+inline bool Tiles_HasSide( const tileStore_t *store, uint64_t tile, int dir ) {
+    return ( store->sides[tile] & ( 1 << dir ) ) != 0;
+}
+
+inline void Tiles_ToggleSide( tileStore_t *store, uint64_t tile, int dir ) {
+    Tiles_SetSides( store, tile, store->sides[tile] ^ ( 1 << dir ) );
+}
+
+inline void Tiles_ToggleFlags( tileStore_t *store, uint64_t tile, uint32_t flags ) {
+    Tiles_SetFlags( store, tile, store->flags[tile] ^ flags );
+}
+
+#endif
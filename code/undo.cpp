@@ -37,8 +37,8 @@ void Undo_ClearRedo( void )
     for ( redo = g_pRedoList; redo; redo = nextredo ) {
         nextredo = redo->next;
         
-        free( redo->data );
-        free( redo );
+        FreeMemory( redo->data, TAG_UNDO );
+        FreeMemory( redo, TAG_UNDO );
     }
 
     g_pRedoList = NULL;
@@ -57,7 +57,7 @@ void Undo_Clear( void )
     for ( undo = g_pUndoList; undo; undo = nextundo ) {
         nextundo = undo->next;
         g_nUndoMemorySize -= sizeof(undo_t);
-        free( undo );
+        FreeMemory( undo, TAG_UNDO );
     }
 
     g_pUndoList = NULL;
@@ -107,7 +107,7 @@ void Undo_FreeFirstUndo( void )
     g_pUndoList->prev = NULL;
 
     g_nUndoMemorySize -= sizeof(undo_t);
-    free( undo );
+    FreeMemory( undo, TAG_UNDO );
     g_nUndoSize--;
 }
 
@@ -121,11 +121,7 @@ void Undo_GeneralStart( const char *operation )
 		}
 	}
 
-	undo = (undo_t *) malloc( sizeof( undo_t ) );
-	if ( !undo ) {
-		return;
-	}
-	memset( undo, 0, sizeof( undo_t ) );
+	undo = (undo_t *)GetMemory( sizeof( undo_t ), TAG_UNDO );
 	if ( g_pLastUndo ) {
 		g_pLastUndo->next = undo;
 	}